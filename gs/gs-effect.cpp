@@ -18,13 +18,16 @@
  */
 
 #include "gs-effect.h"
+#include "plugin/utils.h"
 
 GS::Effect::Effect(std::string file, Cache *cache):m_cache(cache) {
 	m_name = file;
+	// keyed by size and write time too, so an edited file reloads
+	m_key = Utils::FileKey(file);
 	obs_enter_graphics();
 	m_effect = nullptr;
 	if (m_cache != nullptr)
-		m_cache->load(CacheableType::Effect, m_name, (void **)&m_effect);
+		m_cache->load(CacheableType::Effect, m_key, (void **)&m_effect);
 	if (m_effect == nullptr)
 	{
 		char* errorMessage = nullptr;
@@ -35,18 +38,20 @@ GS::Effect::Effect(std::string file, Cache *cache):m_cache(cache) {
 			obs_leave_graphics();
 			throw std::runtime_error(error);
 		}
-		if (!m_cache->add(CacheableType::Effect, m_name, (void *)m_effect))
-			blog(LOG_WARNING, "Caching effect failed: %s", m_name.c_str());
+		if (m_cache != nullptr)
+			m_cache->add(CacheableType::Effect, m_key, (void *)m_effect);
 	}
 	obs_leave_graphics();
 }
 
 GS::Effect::Effect(std::string code, std::string name, Cache *cache):m_cache(cache) {
 	m_name = name;
+	// same code, same effect, whatever it is called
+	m_key = Utils::HashToString(Utils::HashData(code.data(), code.length()));
 	obs_enter_graphics();
 	m_effect = nullptr;
 	if (m_cache != nullptr)
-		m_cache->load(CacheableType::Effect, m_name, (void **)&m_effect);
+		m_cache->load(CacheableType::Effect, m_key, (void **)&m_effect);
 	if (m_effect == nullptr)
 	{
 		char* errorMessage = nullptr;
@@ -57,14 +62,14 @@ GS::Effect::Effect(std::string code, std::string name, Cache *cache):m_cache(cac
 			obs_leave_graphics();
 			throw std::runtime_error(error);
 		}
-		if(!m_cache->add(CacheableType::Effect, m_name, (void *)m_effect))
-			blog(LOG_WARNING, "Caching effect failed: %s", m_name.c_str());
+		if (m_cache != nullptr)
+			m_cache->add(CacheableType::Effect, m_key, (void *)m_effect, code.length());
 	}
 	obs_leave_graphics();
 }
 
 GS::Effect::~Effect() {
-	m_cache->try_destroy_resource(m_name, m_effect,
+	m_cache->try_destroy_resource(m_key, m_effect,
 		CacheableType::Effect);
 }
 
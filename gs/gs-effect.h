@@ -104,6 +104,8 @@ namespace GS {
 		protected:
 		gs_effect_t* m_effect;
 		std::string m_name;
+		// key in the cache
+		std::string m_key;
 
 		// cache manager from FM instance
 		Cache *m_cache;
@@ -18,10 +18,41 @@
  */
 
 #include "gs-texture.h"
+#include "plugin/utils.h"
+#pragma warning( push )
+#pragma warning( disable: 4127 )
+#pragma warning( disable: 4201 )
+#pragma warning( disable: 4267 )
+#include <opencv2/opencv.hpp>
+#pragma warning( pop )
+
+// Content key and size of texture data
+// - for the resource cache, the same texture data always makes the
+//   same key, whatever the texture is called
+// - the flags are part of it, built mipmaps make a different texture
+static std::string texture_key(uint32_t width, uint32_t height, uint32_t depth,
+	uint32_t faces, gs_color_format format, uint32_t mip_levels,
+	const uint8_t **mip_data, uint32_t flags, size_t& bytes) {
+	uint32_t header[] = { width, height, depth, faces, (uint32_t)format, mip_levels, flags };
+	uint64_t hash = Utils::HashData(header, sizeof(header));
+	size_t bpp = gs_get_format_bpp(format);
+	bytes = 0;
+	for (uint32_t face = 0; face < faces; face++) {
+		uint32_t w = width, h = height, d = depth;
+		for (uint32_t i = 0; i < mip_levels; i++) {
+			size_t size = (size_t)w * h * d * bpp / 8;
+			hash = Utils::HashData(mip_data[face * mip_levels + i], size, hash);
+			bytes += size;
+			w = (w > 1) ? w / 2 : 1;
+			h = (h > 1) ? h / 2 : 1;
+			d = (d > 1) ? d / 2 : 1;
+		}
+	}
+	return Utils::HashToString(hash);
+}
 
 GS::Texture::Texture(uint32_t width, uint32_t height, gs_color_format format, uint32_t mip_levels, const uint8_t **mip_data, uint32_t flags,
 	Cache *cache) : m_destroy(true), m_cache(cache) {
-	m_name = ""; // will not participate in caching
 	if (width == 0)
 		throw std::logic_error("width must be at least 1");
 	if (height == 0)
@@ -38,8 +69,19 @@ GS::Texture::Texture(uint32_t width, uint32_t height, gs_color_format format, ui
 			throw std::logic_error("mip mapping requires power of two dimensions");
 	}
 
+	size_t bytes = 0;
+	if (m_cache != nullptr && !(flags & Flags::Dynamic))
+		m_key = texture_key(width, height, 1, 1, format, mip_levels, mip_data, flags, bytes);
+
 	obs_enter_graphics();
-	m_texture = gs_texture_create(width, height, format, mip_levels, mip_data, (flags & Flags::Dynamic) ? GS_DYNAMIC : 0 | (flags & Flags::BuildMipMaps) ? GS_BUILD_MIPMAPS : 0);
+	m_texture = nullptr;
+	if (m_cache != nullptr)
+		m_cache->load(CacheableType::Texture, m_key, (void **)&m_texture);
+	if (m_texture == nullptr) {
+		m_texture = gs_texture_create(width, height, format, mip_levels, mip_data, (flags & Flags::Dynamic) ? GS_DYNAMIC : 0 | (flags & Flags::BuildMipMaps) ? GS_BUILD_MIPMAPS : 0);
+		if (m_texture && m_cache != nullptr)
+			m_cache->add(CacheableType::Texture, m_key, (void *)m_texture, bytes);
+	}
 	obs_leave_graphics();
 
 	if (!m_texture)
@@ -48,7 +90,6 @@ GS::Texture::Texture(uint32_t width, uint32_t height, gs_color_format format, ui
 
 GS::Texture::Texture(uint32_t width, uint32_t height, uint32_t depth, gs_color_format format, uint32_t mip_levels, const uint8_t **mip_data, uint32_t flags,
 	Cache *cache) : m_destroy(true), m_cache(cache) {
-	m_name = ""; // will not participate in caching
 	if (width == 0)
 		throw std::logic_error("width must be at least 1");
 	if (height == 0)
@@ -68,8 +109,19 @@ GS::Texture::Texture(uint32_t width, uint32_t height, uint32_t depth, gs_color_f
 			throw std::logic_error("mip mapping requires power of two dimensions");
 	}
 
+	size_t bytes = 0;
+	if (m_cache != nullptr && !(flags & Flags::Dynamic))
+		m_key = texture_key(width, height, depth, 1, format, mip_levels, mip_data, flags, bytes);
+
 	obs_enter_graphics();
-	m_texture = gs_voltexture_create(width, height, depth, format, mip_levels, mip_data, (flags & Flags::Dynamic) ? GS_DYNAMIC : 0 | (flags & Flags::BuildMipMaps) ? GS_BUILD_MIPMAPS : 0);
+	m_texture = nullptr;
+	if (m_cache != nullptr)
+		m_cache->load(CacheableType::Texture, m_key, (void **)&m_texture);
+	if (m_texture == nullptr) {
+		m_texture = gs_voltexture_create(width, height, depth, format, mip_levels, mip_data, (flags & Flags::Dynamic) ? GS_DYNAMIC : 0 | (flags & Flags::BuildMipMaps) ? GS_BUILD_MIPMAPS : 0);
+		if (m_texture && m_cache != nullptr)
+			m_cache->add(CacheableType::Texture, m_key, (void *)m_texture, bytes);
+	}
 	obs_leave_graphics();
 
 	if (!m_texture)
@@ -78,36 +130,37 @@ GS::Texture::Texture(uint32_t width, uint32_t height, uint32_t depth, gs_color_f
 
 GS::Texture::Texture(std::string name,uint32_t size, gs_color_format format, uint32_t mip_levels, const uint8_t **mip_data, uint32_t flags,
 	Cache *cache) : m_destroy(true), m_cache(cache) {
-	m_name = name;
+	UNUSED_PARAMETER(name);
+	if (size == 0)
+		throw std::logic_error("size must be at least 1");
+	if (mip_levels == 0)
+		throw std::logic_error("mip_levels must be at least 1");
+	if (!mip_data)
+		throw std::logic_error("mip_data is invalid");
+
+	if (mip_levels > 1 || flags & Flags::BuildMipMaps) {
+		bool isPOT = (pow(2, (int64_t)floor(log(size) / log(2))) == size);
+		if (!isPOT)
+			throw std::logic_error("mip mapping requires power of two dimensions");
+	}
+
+	size_t bytes = 0;
+	if (m_cache != nullptr && !(flags & Flags::Dynamic))
+		m_key = texture_key(size, size, 1, 6, format, mip_levels, mip_data, flags, bytes);
+
 	obs_enter_graphics();
 	m_texture = nullptr;
 	if (m_cache != nullptr)
-		m_cache->load(CacheableType::Texture, m_name, (void **)&m_texture);
-	if (m_texture == nullptr)
-	{
-		if (size == 0)
-			throw std::logic_error("size must be at least 1");
-		if (mip_levels == 0)
-			throw std::logic_error("mip_levels must be at least 1");
-		if (!mip_data)
-			throw std::logic_error("mip_data is invalid");
-
-		if (mip_levels > 1 || flags & Flags::BuildMipMaps) {
-			bool isPOT = (pow(2, (int64_t)floor(log(size) / log(2))) == size);
-			if (!isPOT)
-				throw std::logic_error("mip mapping requires power of two dimensions");
-		}
-
+		m_cache->load(CacheableType::Texture, m_key, (void **)&m_texture);
+	if (m_texture == nullptr) {
 		m_texture = gs_cubetexture_create(size, format, mip_levels, mip_data, (flags & Flags::Dynamic) ? GS_DYNAMIC : 0 | (flags & Flags::BuildMipMaps) ? GS_BUILD_MIPMAPS : 0);
-
-		if (!m_texture)
-			throw std::runtime_error("Failed to create texture.");
-
-		if (!m_cache->add(CacheableType::Texture, m_name, (void *)m_texture))
-			blog(LOG_WARNING, "Caching texture failed: %s", m_name.c_str());
-
+		if (m_texture && m_cache != nullptr)
+			m_cache->add(CacheableType::Texture, m_key, (void *)m_texture, bytes);
 	}
 	obs_leave_graphics();
+
+	if (!m_texture)
+		throw std::runtime_error("Failed to create texture.");
 }
 
 GS::Texture::Texture(std::string file, Cache *cache) : m_destroy(true), m_cache(cache) {
@@ -115,17 +168,71 @@ GS::Texture::Texture(std::string file, Cache *cache) : m_destroy(true), m_cache(
 	if (os_stat(file.c_str(), &st) != 0)
 		throw Plugin::file_not_found_error(file);
 
+	// the default textures get loaded by every mask
+	// - keyed by size and write time too, so an edited file reloads
+	if (m_cache != nullptr)
+		m_key = Utils::FileKey(file);
+
 	obs_enter_graphics();
-	m_texture = gs_texture_create_from_file(file.c_str());
+	m_texture = nullptr;
+	if (m_cache != nullptr)
+		m_cache->load(CacheableType::Texture, m_key, (void **)&m_texture);
+	if (m_texture == nullptr) {
+		m_texture = gs_texture_create_from_file(file.c_str());
+		if (m_texture && m_cache != nullptr) {
+			size_t bytes = (size_t)gs_texture_get_width(m_texture) *
+				gs_texture_get_height(m_texture) * 4;
+			m_cache->add(CacheableType::Texture, m_key, (void *)m_texture, bytes);
+		}
+	}
 	obs_leave_graphics();
 
 	if (!m_texture)
 		throw Plugin::io_error("Failed to load texture.", file);
 }
 
+GS::Texture::Texture(const uint8_t* data, size_t size, Cache *cache) : m_destroy(true), m_cache(cache) {
+	if (!data || size == 0)
+		throw std::logic_error("image data is invalid");
+
+	// already have it?
+	if (m_cache != nullptr) {
+		m_key = "image:" + Utils::HashToString(Utils::HashData(data, size));
+		obs_enter_graphics();
+		m_cache->load(CacheableType::Texture, m_key, (void **)&m_texture);
+		obs_leave_graphics();
+		if (m_texture != nullptr)
+			return;
+	}
+
+	// decode, no copy of the encoded data
+	cv::Mat encoded(1, (int)size, CV_8UC1, (void*)data);
+	cv::Mat image = cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
+	if (image.empty())
+		throw Plugin::io_error("Failed to decode texture.", "<memory>");
+
+	// to 8 bit BGRA, which is what we get loading from file as well
+	if (image.depth() != CV_8U)
+		image.convertTo(image, CV_8U, (image.depth() == CV_16U) ? (1.0 / 257.0) : 1.0);
+	if (image.channels() == 1)
+		cv::cvtColor(image, image, cv::COLOR_GRAY2BGRA);
+	else if (image.channels() == 3)
+		cv::cvtColor(image, image, cv::COLOR_BGR2BGRA);
+
+	const uint8_t* mip = image.data;
+	obs_enter_graphics();
+	m_texture = gs_texture_create(image.cols, image.rows, GS_BGRA, 1, &mip, 0);
+	if (m_texture && m_cache != nullptr)
+		m_cache->add(CacheableType::Texture, m_key, (void *)m_texture, image.total() * 4);
+	obs_leave_graphics();
+
+	if (!m_texture)
+		throw Plugin::io_error("Failed to load texture.", "<memory>");
+}
+
 GS::Texture::~Texture() {
 	if(m_destroy)
-		m_cache->try_destroy_resource(m_name, m_texture,
+		m_cache->try_destroy_resource(m_key, m_texture,
 			CacheableType::Texture);
 }
 
@@ -114,6 +114,18 @@ namespace GS {
 		*/
 		Texture(std::string file, Cache *cache);
 
+		/*!
+		* \brief Load a texture from an encoded image in memory
+		*
+		* Decodes a PNG/JPEG/etc image held in memory, without going
+		* through a file on disk. If the data can not be decoded, a
+		* #Plugin::io_error will be thrown.
+		*
+		* \param data Encoded image data.
+		* \param size Size of the encoded image data in bytes.
+		*/
+		Texture(const uint8_t* data, size_t size, Cache *cache);
+
 		/*!
 		* \brief Default constructor
 		*/
@@ -157,10 +169,10 @@ namespace GS {
 		protected:
 		gs_texture_t* m_texture;
 		bool m_destroy;
-		std::string m_name;
+		// content key in the cache, empty if not cached
+		std::string m_key;
 
 		// cache manager from FM instance
-		// currently only caching cubemaps
 		Cache *m_cache;
 
 	};
@@ -44,15 +44,17 @@ static void init_vbdata(gs_vb_data* vbd, size_t num_verts) {
 GS::VertexBuffer::VertexBuffer(uint8_t* raw)
  : m_vb_data(nullptr), m_vertexbuffer(nullptr), m_raw(nullptr) {
 	m_raw = raw;
-	gs_vb_data* vbdata = (gs_vb_data*)ALIGN_16(raw);
+	CreateFromImage((const uint8_t*)ALIGN_16(raw), SIZE_MAX);
+}
 
-	// sanity check
-	if (vbdata->num_tex < 0 || vbdata->num_tex > 8) {
-		// Bail...bad data
-		blog(LOG_ERROR, "[Face Mask] Vertex Buffer is old format. Skipping. Mask will not render correctly, if at all.");
-		return;
-	}
 
+GS::VertexBuffer::VertexBuffer(const uint8_t* image, size_t size)
+ : m_vb_data(nullptr), m_vertexbuffer(nullptr), m_raw(nullptr) {
+	CreateFromImage(image, size);
+}
+
+
+void GS::VertexBuffer::CreateFromImage(const uint8_t* image, size_t size) {
 	// classic memory image dereferencing
 	//
 	// For more info on how this data was created, see the Maskmaker
@@ -60,30 +62,59 @@ GS::VertexBuffer::VertexBuffer(uint8_t* raw)
 	//
 	// facemask-plugin\tools\MaskMaker\command_import.cpp : GSVertexBuffer::get_data/size
 	//
-	size_t top = (size_t)vbdata;
-	vbdata->points = (vec3*)((size_t)(vbdata->points) + top);
-	vbdata->normals = (vec3*)((size_t)(vbdata->normals) + top);
-	vbdata->tangents = (vec3*)((size_t)(vbdata->tangents) + top);
-	vbdata->colors = (uint32_t*)((size_t)(vbdata->colors) + top);
-	vbdata->tvarray = (gs_tvertarray*)((size_t)(vbdata->tvarray) + top);
-	for (int i = 0; i < vbdata->num_tex; i++) {
-		vbdata->tvarray[i].array = (void*)((size_t)(vbdata->tvarray[i].array) + top);
+	// The image may be a read only mapped mask package, so we resolve
+	// the offsets on a copy of the header instead of in place.
+	//
+	gs_vb_data vbdata;
+	if (size < sizeof(vbdata)) {
+		blog(LOG_ERROR, "[Face Mask] Vertex Buffer is truncated. Skipping.");
+		return;
+	}
+	memcpy(&vbdata, image, sizeof(vbdata));
+
+	// sanity check
+	if (vbdata.num_tex > 8) {
+		// Bail...bad data
+		blog(LOG_ERROR, "[Face Mask] Vertex Buffer is old format. Skipping. Mask will not render correctly, if at all.");
+		return;
+	}
+
+	// offset -> pointer, or null if it's missing or out of bounds
+	auto resolve = [image, size](const void* offset, size_t bytes) -> const uint8_t* {
+		size_t o = (size_t)offset;
+		if (o == 0 || o > size || bytes > size - o)
+			return nullptr;
+		return image + o;
+	};
+	const uint8_t* points = resolve(vbdata.points, sizeof(vec3) * vbdata.num);
+	const uint8_t* tvarray = resolve(vbdata.tvarray, sizeof(gs_tvertarray) * vbdata.num_tex);
+	if (!points || (vbdata.num_tex > 0 && !tvarray)) {
+		blog(LOG_ERROR, "[Face Mask] Vertex Buffer is malformed. Skipping.");
+		return;
 	}
+	const uint8_t* normals = resolve(vbdata.normals, sizeof(vec3) * vbdata.num);
+	const uint8_t* tangents = resolve(vbdata.tangents, sizeof(vec3) * vbdata.num);
+	const uint8_t* colors = resolve(vbdata.colors, sizeof(uint32_t) * vbdata.num);
 
 	// And now re-allocate the whole fucking thing
 	// (for some reason, gs_vertexbuffer_destroy() now deletes the vb data :P )
 	//
 	gs_vb_data* vbd = gs_vbdata_create();
-	init_vbdata(vbd, vbdata->num);
-	memcpy(vbd->points, vbdata->points, sizeof(vec3) * vbdata->num);
-	if (vbdata->normals)
-		memcpy(vbd->normals, vbdata->normals, sizeof(vec3) * vbdata->num);
-	if (vbdata->tangents)
-		memcpy(vbd->tangents, vbdata->tangents, sizeof(vec3) * vbdata->num);
-	if (vbdata->colors)
-		memcpy(vbd->colors, vbdata->colors, sizeof(uint32_t) * vbdata->num);
-	for (int i = 0; i < vbdata->num_tex; i++) {
-		memcpy(vbd->tvarray[i].array, vbdata->tvarray[i].array, sizeof(float) * vbd->tvarray[i].width * vbdata->num);
+	init_vbdata(vbd, vbdata.num);
+	memcpy(vbd->points, points, sizeof(vec3) * vbdata.num);
+	if (normals)
+		memcpy(vbd->normals, normals, sizeof(vec3) * vbdata.num);
+	if (tangents)
+		memcpy(vbd->tangents, tangents, sizeof(vec3) * vbdata.num);
+	if (colors)
+		memcpy(vbd->colors, colors, sizeof(uint32_t) * vbdata.num);
+	for (size_t i = 0; i < vbdata.num_tex; i++) {
+		gs_tvertarray tva;
+		memcpy(&tva, tvarray + sizeof(gs_tvertarray) * i, sizeof(tva));
+		size_t bytes = sizeof(float) * vbd->tvarray[i].width * vbdata.num;
+		const uint8_t* uvs = resolve(tva.array, bytes);
+		if (uvs)
+			memcpy(vbd->tvarray[i].array, uvs, bytes);
 	}
 
 	// create the gs vertex buffer
@@ -33,6 +33,7 @@ namespace GS {
 	class VertexBuffer {
 	public:
 		VertexBuffer(uint8_t* raw);
+		VertexBuffer(const uint8_t* image, size_t size);
 		VertexBuffer(const std::vector<GS::Vertex>& verts);
 		~VertexBuffer();
 
@@ -41,6 +42,8 @@ namespace GS {
 		size_t size();
 
 	protected:
+		void				CreateFromImage(const uint8_t* image, size_t size);
+
 		gs_vb_data*			m_vb_data;
 		gs_vertbuffer_t*	m_vertexbuffer;
 		uint8_t*			m_raw;
@@ -0,0 +1,320 @@
+/*
+ * Face Masks for SlOBS
+ * Copyright (C) 2017 General Workings Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "mask-animation-curve.h"
+#include <cmath>
+#include <cstring>
+
+
+static void write_varint(std::vector<uint8_t>& out, uint32_t v) {
+	while (v >= 0x80) {
+		out.push_back((uint8_t)(v | 0x80));
+		v >>= 7;
+	}
+	out.push_back((uint8_t)v);
+}
+
+static void write_zigzag(std::vector<uint8_t>& out, int32_t v) {
+	write_varint(out, ((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+}
+
+static bool read_varint(const std::vector<uint8_t>& in, size_t& offset, uint32_t& v) {
+	v = 0;
+	for (int shift = 0; shift < 35; shift += 7) {
+		if (offset >= in.size())
+			return false;
+		uint8_t b = in[offset++];
+		v |= (uint32_t)(b & 0x7F) << shift;
+		if (!(b & 0x80))
+			return true;
+	}
+	return false;
+}
+
+static bool read_zigzag(const std::vector<uint8_t>& in, size_t& offset, int32_t& v) {
+	uint32_t u;
+	if (!read_varint(in, offset, u))
+		return false;
+	v = (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+	return true;
+}
+
+static int32_t quantize(float v, float base, float step) {
+	double q = std::floor((double)(v - base) / step + 0.5);
+	if (q > INT32_MAX)
+		return INT32_MAX;
+	if (q < INT32_MIN)
+		return INT32_MIN;
+	return (int32_t)q;
+}
+
+
+Mask::AnimationCurve::AnimationCurve()
+	: m_numFrames(0), m_numKeys(0), m_base(0.0f), m_step(0.0f),
+	m_nextIndex(0), m_readOffset(0) {
+	memset(&m_key, 0, sizeof(m_key));
+	memset(&m_next, 0, sizeof(m_next));
+}
+
+float Mask::AnimationCurve::Interpolate(const Key& a, const Key& b, int frame,
+	float base, float step) {
+	float va = base + (float)a.q * step;
+	float vb = base + (float)b.q * step;
+	float length = (float)(b.frame - a.frame);
+	float t = (float)(frame - a.frame) / length;
+	if (!a.hermite)
+		return va + (vb - va) * t;
+
+	// hermite, with the slopes scaled to the segment
+	float m0 = (float)a.slope0 * step / MASK_CURVE_SLOPE_STEPS * length;
+	float m1 = (float)a.slope1 * step / MASK_CURVE_SLOPE_STEPS * length;
+	float t2 = t * t;
+	float t3 = t2 * t;
+	return (2.0f * t3 - 3.0f * t2 + 1.0f) * va +
+		(t3 - 2.0f * t2 + t) * m0 +
+		(-2.0f * t3 + 3.0f * t2) * vb +
+		(t3 - t2) * m1;
+}
+
+std::vector<uint8_t> Mask::AnimationCurve::Encode(const float* values,
+	size_t numFrames, float tolerance) {
+	if (!(tolerance > 0.0f))
+		tolerance = 1e-6f;
+
+	CurveHeader header;
+	memcpy(header.magic, MASK_CURVE_MAGIC, sizeof(header.magic));
+	header.numFrames = (uint32_t)numFrames;
+	header.numKeys = 0;
+	header.reserved = 0;
+	header.base = 0.0f;
+	header.step = tolerance;
+
+	std::vector<Key> keys;
+	if (numFrames > 0) {
+		float lo = values[0], hi = values[0];
+		for (size_t i = 1; i < numFrames; i++) {
+			if (values[i] < lo)
+				lo = values[i];
+			if (values[i] > hi)
+				hi = values[i];
+		}
+
+		if (hi - lo <= 2.0f * tolerance) {
+			// constant channel, one key does it
+			header.base = (lo + hi) * 0.5f;
+			keys.push_back({ 0, 0, false, 0, 0 });
+		}
+		else {
+			// quantize to the tolerance, unless the range won't fit
+			header.base = lo;
+			if ((hi - lo) / header.step > (float)(1 << 30))
+				header.step = (hi - lo) / (float)(1 << 30);
+			float base = header.base;
+			float step = header.step;
+
+			auto slope_at = [&](size_t f) -> int32_t {
+				size_t f0 = f > 0 ? f - 1 : f;
+				size_t f1 = f + 1 < numFrames ? f + 1 : f;
+				float slope = (values[f1] - values[f0]) / (float)(f1 - f0);
+				return quantize(slope * MASK_CURVE_SLOPE_STEPS, 0.0f, step);
+			};
+			auto fits = [&](const Key& a, const Key& b) {
+				for (int f = a.frame; f <= b.frame; f++) {
+					float v = Interpolate(a, b, f, base, step);
+					if (std::fabs(v - values[f]) > tolerance)
+						return false;
+				}
+				return true;
+			};
+
+			// fits a segment from start to end into a, linear if a line
+			// does, else hermite
+			auto fit = [&](size_t start, size_t end, Key& a) {
+				Key b = { (int)end, quantize(values[end], base, step), false, 0, 0 };
+				a.hermite = false;
+				if (fits(a, b))
+					return true;
+				a.hermite = true;
+				a.slope0 = slope_at(start);
+				a.slope1 = slope_at(end);
+				return fits(a, b);
+			};
+
+			// greedy: make each segment as long as it can be
+			// - rather than trying every length, which is quadratic,
+			//   double it until it doesn't fit, then search between the
+			//   last length that did and that one
+			keys.push_back({ 0, quantize(values[0], base, step), false, 0, 0 });
+			size_t start = 0;
+			while (start + 1 < numFrames) {
+				Key a = keys.back();
+				Key best = a;
+				best.hermite = false;
+				Key k = a;
+				size_t good = start + 1;
+				size_t bad = numFrames;
+				if (fit(start, good, k))
+					best = k;
+				for (size_t length = 2; good + 1 < numFrames; length *= 2) {
+					size_t end = start + length;
+					if (end >= numFrames)
+						end = numFrames - 1;
+					k = a;
+					if (!fit(start, end, k)) {
+						bad = end;
+						break;
+					}
+					best = k;
+					good = end;
+				}
+				while (bad - good > 1) {
+					size_t end = good + (bad - good) / 2;
+					k = a;
+					if (fit(start, end, k)) {
+						best = k;
+						good = end;
+					}
+					else
+						bad = end;
+				}
+				keys.back() = best;
+				keys.push_back({ (int)good,
+					quantize(values[good], base, step), false, 0, 0 });
+				start = good;
+			}
+		}
+	}
+	header.numKeys = (uint32_t)keys.size();
+
+	std::vector<uint8_t> out(sizeof(header));
+	memcpy(out.data(), &header, sizeof(header));
+	Key prev = { 0, 0, false, 0, 0 };
+	for (const Key& key : keys) {
+		write_varint(out, ((uint32_t)(key.frame - prev.frame) << 1) |
+			(key.hermite ? 1 : 0));
+		write_zigzag(out, (int32_t)((uint32_t)key.q - (uint32_t)prev.q));
+		if (key.hermite) {
+			write_zigzag(out, key.slope0);
+			write_zigzag(out, key.slope1);
+		}
+		prev = key;
+	}
+	return out;
+}
+
+bool Mask::AnimationCurve::Load(const uint8_t* data, size_t size) {
+	CurveHeader header;
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, MASK_CURVE_MAGIC, sizeof(header.magic)) != 0)
+		return false;
+	if ((header.numFrames == 0) != (header.numKeys == 0) ||
+		header.numFrames > INT32_MAX)
+		return false;
+
+	m_data.assign(data, data + size);
+	m_numFrames = (int)header.numFrames;
+	m_numKeys = header.numKeys;
+	m_base = header.base;
+	m_step = header.step;
+
+	// walk the keys once, so a bad curve fails here and not while
+	// we're playing it
+	Key prev = { 0, 0, false, 0, 0 };
+	m_readOffset = sizeof(header);
+	for (size_t i = 0; i < m_numKeys; i++) {
+		Key key;
+		if (!ReadKey(prev, key) ||
+			(i == 0 && key.frame != 0) ||
+			(i > 0 && key.frame <= prev.frame) ||
+			key.frame >= m_numFrames ||
+			(i + 1 == m_numKeys && key.hermite) ||
+			(i > 0 && i + 1 == m_numKeys && key.frame != m_numFrames - 1)) {
+			m_data.clear();
+			m_numFrames = 0;
+			m_numKeys = 0;
+			return false;
+		}
+		prev = key;
+	}
+
+	Rewind();
+	return true;
+}
+
+void Mask::AnimationCurve::Rewind() {
+	m_readOffset = sizeof(CurveHeader);
+	if (m_numKeys == 0)
+		return;
+	Key zero = { 0, 0, false, 0, 0 };
+	ReadKey(zero, m_key);
+	m_next = m_key;
+	m_nextIndex = 0;
+	if (m_numKeys > 1) {
+		ReadKey(m_key, m_next);
+		m_nextIndex = 1;
+	}
+}
+
+bool Mask::AnimationCurve::ReadKey(const Key& prev, Key& key) {
+	uint32_t head;
+	int32_t dq;
+	if (!read_varint(m_data, m_readOffset, head) ||
+		!read_zigzag(m_data, m_readOffset, dq))
+		return false;
+	// keys can't be past the end of the channel, which also keeps the
+	// frame from overflowing
+	uint32_t frames = head >> 1;
+	if (frames >= (uint32_t)(m_numFrames - prev.frame))
+		return false;
+	key.frame = prev.frame + (int)frames;
+	key.q = (int32_t)((uint32_t)prev.q + (uint32_t)dq);
+	key.hermite = (head & 1) != 0;
+	key.slope0 = key.slope1 = 0;
+	if (key.hermite) {
+		if (!read_zigzag(m_data, m_readOffset, key.slope0) ||
+			!read_zigzag(m_data, m_readOffset, key.slope1))
+			return false;
+	}
+	return true;
+}
+
+float Mask::AnimationCurve::Evaluate(int frame) {
+	if (m_numKeys == 0)
+		return 0.0f;
+	if (frame < 0)
+		frame = 0;
+	if (frame >= m_numFrames)
+		frame = m_numFrames - 1;
+
+	// going backwards means starting over, going forwards
+	// just reads on to the segment we want
+	if (frame < m_key.frame)
+		Rewind();
+	while (m_nextIndex + 1 < m_numKeys && frame >= m_next.frame) {
+		m_key = m_next;
+		ReadKey(m_key, m_next);
+		m_nextIndex++;
+	}
+
+	if (frame >= m_next.frame)
+		return m_base + (float)m_next.q * m_step;
+	return Interpolate(m_key, m_next, frame, m_base, m_step);
+}
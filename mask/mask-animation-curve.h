@@ -0,0 +1,106 @@
+/*
+ * Face Masks for SlOBS
+ * Copyright (C) 2017 General Workings Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include <inttypes.h>
+#include <cstddef>
+#include <vector>
+
+// Animation curve layout
+//
+//   CurveHeader
+//   keys[numKeys], variable length
+//
+// A curve stands in for the dense per-frame values of an animation
+// channel (channel "encoding" is "curve"). Values are quantized to
+// base + q * step, and each key holds
+//
+//   varint		(frames since the previous key << 1) | hermite
+//   zigzag		q, as a delta from the previous key
+//   zigzag		start slope  \  hermite keys only, the slopes (per
+//   zigzag		end slope    /  frame) of the segment to the next key
+//
+// Segments are linear unless the key says hermite. The first key is
+// at frame 0 and the last at numFrames - 1, except for a constant
+// channel, which is a single key.
+//
+// Note: this header is shared with MaskMaker, keep it free of libobs.
+//
+#define MASK_CURVE_MAGIC			"FMAC"
+#define MASK_CURVE_SLOPE_STEPS		(8)
+#define MASK_CURVE_ENCODING			"curve"
+
+namespace Mask {
+
+	struct CurveHeader {
+		char		magic[4];
+		uint32_t	numFrames;
+		uint32_t	numKeys;
+		uint32_t	reserved;
+		float		base;
+		float		step;
+	};
+
+	// AnimationCurve : a compressed animation channel
+	// - decodes lazily, keeping a cursor on the segment it last
+	//   evaluated, so playing forward only ever decodes the next key
+	class AnimationCurve {
+	public:
+		AnimationCurve();
+
+		// fits keys to the values, each frame within tolerance
+		static std::vector<uint8_t> Encode(const float* values,
+			size_t numFrames, float tolerance);
+
+		// false if the data isn't a curve
+		bool	Load(const uint8_t* data, size_t size);
+
+		int		GetNumFrames() const { return m_numFrames; }
+		size_t	GetNumKeys() const { return m_numKeys; }
+
+		// value at frame, clamped to [0, numFrames)
+		float	Evaluate(int frame);
+
+	private:
+		struct Key {
+			int		frame;
+			int32_t	q;
+			bool	hermite;
+			int32_t	slope0, slope1;
+		};
+
+		std::vector<uint8_t>	m_data;
+		int						m_numFrames;
+		size_t					m_numKeys;
+		float					m_base;
+		float					m_step;
+
+		// cursor, evaluating between m_key and m_next
+		Key		m_key;
+		Key		m_next;
+		size_t	m_nextIndex;	// index of m_next
+		size_t	m_readOffset;	// where the key after m_next starts
+
+		void	Rewind();
+		bool	ReadKey(const Key& prev, Key& key);
+
+		static float	Interpolate(const Key& a, const Key& b, int frame,
+							float base, float step);
+	};
+}
@@ -0,0 +1,138 @@
+/*
+ * Face Masks for SlOBS
+ * Copyright (C) 2017 General Workings Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "mask-blob-decoder.h"
+#include "plugin/base64.h"
+#include <cstring>
+
+
+// most worker threads we decode with
+static const size_t MAX_DECODE_THREADS = 4;
+// decoded bytes waiting to be taken before the workers hold off
+static const size_t DECODE_BUDGET = 64 * 1024 * 1024;
+
+
+Mask::BlobDecoder::BlobDecoder() : m_next(0), m_bytes(0), m_stop(false) {}
+
+Mask::BlobDecoder::~BlobDecoder() {
+	Stop();
+}
+
+std::string Mask::BlobDecoder::Key(const std::string& resource, const std::string& field) {
+	return resource + "/" + field;
+}
+
+void Mask::BlobDecoder::Add(const std::string& key, const char* value) {
+	if (!value || value[0] == '\0' || m_index.count(key) > 0)
+		return;
+	m_index.emplace(key, m_jobs.size());
+	m_jobs.push_back({ value, JOB_QUEUED, Blob() });
+}
+
+void Mask::BlobDecoder::Start(std::shared_ptr<Package> package) {
+	m_package = package;
+	m_stop = false;
+	size_t numThreads = std::thread::hardware_concurrency();
+	if (numThreads > MAX_DECODE_THREADS)
+		numThreads = MAX_DECODE_THREADS;
+	if (numThreads > m_jobs.size())
+		numThreads = m_jobs.size();
+	for (size_t i = 0; i < numThreads; i++)
+		m_threads.emplace_back(&BlobDecoder::WorkerMain, this);
+}
+
+bool Mask::BlobDecoder::Take(const std::string& key, Blob& blob) {
+	auto kv = m_index.find(key);
+	if (kv == m_index.end())
+		return false;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	Job& job = m_jobs[kv->second];
+	if (job.state == JOB_QUEUED) {
+		// nobody got to it yet, the caller is quicker doing it
+		job.state = JOB_TAKEN;
+		return false;
+	}
+	m_cond.wait(lock, [&job]() { return job.state != JOB_DECODING; });
+	if (job.state != JOB_DONE)
+		return false;
+
+	job.state = JOB_TAKEN;
+	m_bytes -= job.blob.size();
+	bool ok = !job.blob.empty();
+	if (ok)
+		blob = std::move(job.blob);
+	job.blob.Clear();
+	m_cond.notify_all();
+	return ok;
+}
+
+void Mask::BlobDecoder::Stop() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_cond.notify_all();
+	for (auto& t : m_threads)
+		t.join();
+	m_threads.clear();
+	m_jobs.clear();
+	m_index.clear();
+	m_package.reset();
+	m_next = 0;
+	m_bytes = 0;
+}
+
+void Mask::BlobDecoder::WorkerMain() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true) {
+		m_cond.wait(lock, [this]() { return m_stop || m_bytes < DECODE_BUDGET; });
+		while (m_next < m_jobs.size() && m_jobs[m_next].state != JOB_QUEUED)
+			m_next++;
+		if (m_stop || m_next >= m_jobs.size())
+			break;
+		Job& job = m_jobs[m_next++];
+		job.state = JOB_DECODING;
+		const char* value = job.value;
+		lock.unlock();
+
+		Blob blob;
+		try {
+			if (Package::IsBlobRef(value)) {
+				if (m_package)
+					m_package->GetBlob(value, blob);
+			}
+			else {
+				std::vector<uint8_t> decoded;
+				base64_decodeZ(value, strlen(value), decoded);
+				blob.Take(std::move(decoded));
+			}
+		}
+		catch (...) {
+			// leave it, the loader will try again and report it
+			blob.Clear();
+		}
+
+		lock.lock();
+		m_bytes += blob.size();
+		job.blob = std::move(blob);
+		job.state = JOB_DONE;
+		m_cond.notify_all();
+	}
+}
@@ -0,0 +1,83 @@
+/*
+ * Face Masks for SlOBS
+ * Copyright (C) 2017 General Workings Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "mask-package.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Mask {
+
+	// BlobDecoder : decodes resource data ahead of the loading walk
+	// - a few worker threads decode the queued data (base64/zlib, or
+	//   package blobs) while the resources are being created
+	// - stays under a byte budget, workers wait for the loader to take
+	//   what they decoded before going on
+	// - data is keyed by resource name and field, see Key
+	class BlobDecoder {
+	public:
+		BlobDecoder();
+		~BlobDecoder();
+
+		static std::string Key(const std::string& resource, const std::string& field);
+
+		// queue everything first, then start the workers
+		// - values must stay valid until Stop
+		void	Add(const std::string& key, const char* value);
+		void	Start(std::shared_ptr<Package> package);
+
+		// hands over the decoded data, waiting for it if a worker is
+		// on it. False if it wasn't queued, hasn't been started yet, or
+		// failed to decode, the caller decodes it itself then.
+		bool	Take(const std::string& key, Blob& blob);
+
+		// stops the workers and drops anything not taken
+		void	Stop();
+
+	private:
+		enum JobState {
+			JOB_QUEUED,
+			JOB_DECODING,
+			JOB_DONE,
+			JOB_TAKEN,
+		};
+		struct Job {
+			const char*		value;
+			JobState		state;
+			Blob			blob;
+		};
+
+		std::vector<Job>						m_jobs;
+		std::unordered_map<std::string, size_t>	m_index;
+		size_t									m_next;		// first job a worker might take
+		size_t									m_bytes;	// decoded, not yet taken
+		bool									m_stop;
+		std::shared_ptr<Package>				m_package;
+		std::vector<std::thread>				m_threads;
+		std::mutex								m_mutex;
+		std::condition_variable					m_cond;
+
+		void	WorkerMain();
+	};
+}
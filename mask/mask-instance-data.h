@@ -20,8 +20,10 @@
 #pragma once
 #include <string>
 #include <vector>
-#include <stack>
-#include <map>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <cstdint>
 extern "C" {
 #pragma warning( push )
 #pragma warning( disable: 4201 )
@@ -53,6 +55,17 @@ namespace Mask {
 		AlphaInstanceData() : alpha(1.0f) {}
 	};
 
+	// InstanceDataCache
+	// - the last instance data a resource looked up, and its id
+	// - resources mostly render from one place, so most lookups
+	//   never get as far as the table
+	template<typename IDType>
+	struct InstanceDataCache {
+		std::size_t	id;
+		IDType*		data;
+		InstanceDataCache() : id(0), data(nullptr) {}
+	};
+
 	// MaskInstanceDatas
 	// - manages per-instance data in the part/resource heirarchy
 	// - since resources may be referenced in multiple parts or 
@@ -69,43 +82,56 @@ namespace Mask {
 	// - some resources, like particle emitters, can create multiple
 	//   instances of a resource by pushing and popping instance
 	//   names before calling update on their child resources.
+	// - instance datas live in a pool per type, never move and are
+	//   never freed before we are, so resources can hang on to them
+	// - ids are looked up in an open addressing hash table, which
+	//   also keeps the type so we never need RTTI to cast
 	class MaskInstanceDatas {
 	public:
 
-		MaskInstanceDatas() : m_currentId(0) {}
+		MaskInstanceDatas() : m_currentId(0), m_count(0) {}
+		MaskInstanceDatas(const MaskInstanceDatas&) = delete;
+		MaskInstanceDatas& operator=(const MaskInstanceDatas&) = delete;
 
 		template<typename IDType>
-		std::shared_ptr<IDType> GetData() {
+		IDType* GetData() {
 			return GetData<IDType>(CurrentId());
 		}
 
 		template<typename IDType>
-		std::shared_ptr<IDType> GetData(std::size_t the_id) {
-			// create instance data if we need to.
-			auto it = m_instanceDatas.find(the_id);
-			if (it == m_instanceDatas.end()) {
-				std::shared_ptr<IDType> instData =
-					std::make_shared<IDType>();
-				m_instanceDatas[the_id] = instData;
-				return instData;
+		IDType* GetData(std::size_t the_id) {
+			const Entry* e = Find(the_id);
+			if (e) {
+				return e->type == TypeIndex<IDType>() ?
+					static_cast<IDType*>(e->data) : nullptr;
 			}
-			else {
-				return std::dynamic_pointer_cast<IDType>
-					(it->second);
+			// create instance data if we need to.
+			IDType* instData = GetPool<IDType>().Allocate();
+			Insert(the_id, TypeIndex<IDType>(), instData);
+			return instData;
+		}
+
+		template<typename IDType>
+		IDType* GetData(InstanceDataCache<IDType>& cache) {
+			return GetData<IDType>(CurrentId(), cache);
+		}
+
+		template<typename IDType>
+		IDType* GetData(std::size_t the_id, InstanceDataCache<IDType>& cache) {
+			if (!cache.data || cache.id != the_id) {
+				cache.data = GetData<IDType>(the_id);
+				cache.id = the_id;
 			}
+			return cache.data;
 		}
 
 		template<typename IDType>
-		std::shared_ptr<IDType> FindDataDontCreate(std::size_t the_id) {
+		IDType* FindDataDontCreate(std::size_t the_id) {
 			// return nullptr if not found
-			auto it = m_instanceDatas.find(the_id);
-			if (it == m_instanceDatas.end()) {
+			const Entry* e = Find(the_id);
+			if (!e || e->type != TypeIndex<IDType>())
 				return nullptr;
-			}
-			else {
-				return std::dynamic_pointer_cast<IDType>
-					(it->second);
-			}
+			return static_cast<IDType*>(e->data);
 		}
 
 		inline void Push(std::size_t the_id) {
@@ -127,22 +153,107 @@ namespace Mask {
 			return m_currentId;
 		}
 
-		std::vector<std::shared_ptr<InstanceData>> GetInstances() {
-			std::vector<std::shared_ptr<InstanceData>> r;
-			r.reserve(m_instanceDatas.size());
-			for (auto const& kv : m_instanceDatas) {
-				r.push_back(kv.second);
+		void ResetAll() {
+			for (const Entry& e : m_table) {
+				if (e.data)
+					e.data->Reset();
 			}
-			return r;
 		}
 
 	protected:
+		struct Entry {
+			std::size_t		id;
+			InstanceData*	data;	// nullptr for an empty slot
+			std::size_t		type;
+		};
+
+		struct PoolBase {
+			virtual ~PoolBase() {}
+		};
+		template<typename IDType>
+		struct Pool : public PoolBase {
+			std::deque<IDType> items;
+			IDType* Allocate() {
+				items.emplace_back();
+				return &items.back();
+			}
+		};
+
 		std::size_t m_currentId;
 		std::vector<size_t> m_stack;
-		std::map<size_t, std::shared_ptr<InstanceData>> m_instanceDatas;
+		std::vector<Entry> m_table;
+		std::size_t m_count;
+		std::vector<std::unique_ptr<PoolBase>> m_pools;
 
 		inline void hash_combine(std::size_t val) {
 			m_currentId ^= val + 0x9e3779b9 + (m_currentId << 6) + (m_currentId >> 2);
 		}
+
+		static std::size_t NextTypeIndex() {
+			static std::atomic<std::size_t> next(0);
+			return next++;
+		}
+
+		template<typename IDType>
+		static std::size_t TypeIndex() {
+			static const std::size_t index = NextTypeIndex();
+			return index;
+		}
+
+		template<typename IDType>
+		Pool<IDType>& GetPool() {
+			std::size_t t = TypeIndex<IDType>();
+			if (t >= m_pools.size())
+				m_pools.resize(t + 1);
+			if (!m_pools[t])
+				m_pools[t].reset(new Pool<IDType>());
+			return *static_cast<Pool<IDType>*>(m_pools[t].get());
+		}
+
+		static inline std::size_t Slot(std::size_t the_id) {
+			// ids are already hashes, but small ones (like the alpha
+			// id) need spreading out
+			uint64_t h = (uint64_t)the_id * 0x9E3779B97F4A7C15ULL;
+			return (std::size_t)(h ^ (h >> 32));
+		}
+
+		const Entry* Find(std::size_t the_id) const {
+			if (m_table.empty())
+				return nullptr;
+			std::size_t mask = m_table.size() - 1;
+			for (std::size_t i = Slot(the_id) & mask;; i = (i + 1) & mask) {
+				const Entry& e = m_table[i];
+				if (!e.data)
+					return nullptr;
+				if (e.id == the_id)
+					return &e;
+			}
+		}
+
+		void Insert(std::size_t the_id, std::size_t type, InstanceData* data) {
+			// keep at most half full
+			if ((m_count + 1) * 2 > m_table.size())
+				Grow();
+			std::size_t mask = m_table.size() - 1;
+			std::size_t i = Slot(the_id) & mask;
+			while (m_table[i].data)
+				i = (i + 1) & mask;
+			m_table[i].id = the_id;
+			m_table[i].data = data;
+			m_table[i].type = type;
+			m_count++;
+		}
+
+		void Grow() {
+			std::vector<Entry> old;
+			old.swap(m_table);
+			Entry empty = { 0, nullptr, 0 };
+			m_table.assign(old.empty() ? 64 : old.size() * 2, empty);
+			m_count = 0;
+			for (const Entry& e : old) {
+				if (e.data)
+					Insert(e.id, e.type, e.data);
+			}
+		}
 	};
 }
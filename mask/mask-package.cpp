@@ -0,0 +1,205 @@
+/*
+ * Face Masks for SlOBS
+ * Copyright (C) 2017 General Workings Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "mask-package.h"
+#include <Windows.h>
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+
+namespace zlib {
+#include <zlib.h>
+}
+
+
+// true if [offset, offset + size) is inside total, without overflowing
+static bool in_bounds(uint64_t offset, uint64_t size, uint64_t total) {
+	return size <= total && offset <= total - size;
+}
+
+
+void Mask::Blob::Reference(std::shared_ptr<const Package> package,
+	const uint8_t* data, size_t size) {
+	m_storage.clear();
+	m_package = package;
+	m_data = data;
+	m_size = size;
+}
+
+uint8_t* Mask::Blob::Allocate(size_t size) {
+	m_package.reset();
+	m_storage.resize(size);
+	m_data = m_storage.data();
+	m_size = size;
+	return m_storage.data();
+}
+
+void Mask::Blob::Take(std::vector<uint8_t>&& data) {
+	m_package.reset();
+	m_storage = std::move(data);
+	m_data = m_storage.data();
+	m_size = m_storage.size();
+}
+
+void Mask::Blob::Clear() {
+	m_package.reset();
+	m_storage.clear();
+	m_data = nullptr;
+	m_size = 0;
+}
+
+
+Mask::Package::Package(const std::string& file)
+	: m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr), m_view(nullptr),
+	m_size(0), m_header(nullptr), m_blobs(nullptr), m_numBlobs(0) {
+
+	// map the whole file, read only
+	m_file = ::CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (m_file == INVALID_HANDLE_VALUE)
+		throw std::ios_base::failure(file);
+
+	LARGE_INTEGER fileSize;
+	if (!::GetFileSizeEx(m_file, &fileSize) ||
+		fileSize.QuadPart < (LONGLONG)sizeof(PackageHeader)) {
+		Unmap();
+		throw std::ios_base::failure(file);
+	}
+	m_size = (size_t)fileSize.QuadPart;
+
+	m_mapping = ::CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!m_mapping) {
+		Unmap();
+		throw std::ios_base::failure(file);
+	}
+	m_view = (const uint8_t*)::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_view) {
+		Unmap();
+		throw std::ios_base::failure(file);
+	}
+
+	// sanity checks
+	m_header = (const PackageHeader*)m_view;
+	if (memcmp(m_header->magic, MASK_PACKAGE_MAGIC, sizeof(m_header->magic)) != 0 ||
+		m_header->version != MASK_PACKAGE_VERSION) {
+		Unmap();
+		throw std::invalid_argument("not a mask package, or unsupported version");
+	}
+	m_numBlobs = m_header->numBlobs;
+	if (m_header->jsonSize == 0 ||
+		!in_bounds(m_header->jsonOffset, m_header->jsonSize, m_size) ||
+		m_view[m_header->jsonOffset + m_header->jsonSize - 1] != '\0' ||
+		!in_bounds(m_header->blobTableOffset,
+			(uint64_t)m_numBlobs * sizeof(PackageBlobEntry), m_size) ||
+		(m_header->blobTableOffset % sizeof(uint64_t)) != 0) {
+		Unmap();
+		throw std::invalid_argument("mask package is truncated or malformed");
+	}
+	m_blobs = (const PackageBlobEntry*)(m_view + m_header->blobTableOffset);
+	for (size_t i = 0; i < m_numBlobs; i++) {
+		const PackageBlobEntry& entry = m_blobs[i];
+		if (!in_bounds(entry.offset, entry.size, m_size)) {
+			Unmap();
+			throw std::invalid_argument("mask package blob is out of bounds");
+		}
+		// don't let a bad header make us allocate whatever it likes
+		bool badSize = entry.rawSize > MASK_PACKAGE_MAX_BLOB_SIZE;
+		if (entry.compression == PACKAGE_COMPRESSION_NONE)
+			badSize = badSize || entry.rawSize != entry.size;
+		else if (entry.rawSize > entry.size * MASK_PACKAGE_MAX_INFLATE_RATIO)
+			badSize = true;
+		if (badSize) {
+			Unmap();
+			throw std::invalid_argument("mask package blob has a bad size");
+		}
+	}
+}
+
+Mask::Package::~Package() {
+	Unmap();
+}
+
+void Mask::Package::Unmap() {
+	if (m_view)
+		::UnmapViewOfFile(m_view);
+	if (m_mapping)
+		::CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		::CloseHandle(m_file);
+	m_view = nullptr;
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+	m_header = nullptr;
+	m_blobs = nullptr;
+	m_numBlobs = 0;
+}
+
+bool Mask::Package::IsPackage(const std::string& file) {
+	char magic[4];
+	std::fstream f(file, std::ios::in | std::ios::binary);
+	if (!f.read(magic, sizeof(magic)))
+		return false;
+	return memcmp(magic, MASK_PACKAGE_MAGIC, sizeof(magic)) == 0;
+}
+
+bool Mask::Package::IsBlobRef(const char* value) {
+	return strncmp(value, MASK_PACKAGE_BLOB_PREFIX,
+		sizeof(MASK_PACKAGE_BLOB_PREFIX) - 1) == 0;
+}
+
+const char* Mask::Package::GetJSON() const {
+	return (const char*)(m_view + m_header->jsonOffset);
+}
+
+void Mask::Package::GetBlob(const char* blobRef, Blob& blob) const {
+	if (!IsBlobRef(blobRef))
+		throw std::invalid_argument("not a blob reference");
+	char* end = nullptr;
+	const char* idx = blobRef + sizeof(MASK_PACKAGE_BLOB_PREFIX) - 1;
+	unsigned long index = strtoul(idx, &end, 10);
+	if (end == idx || *end != '\0')
+		throw std::invalid_argument("malformed blob reference");
+	GetBlob(index, blob);
+}
+
+void Mask::Package::GetBlob(size_t index, Blob& blob) const {
+	if (index >= m_numBlobs)
+		throw std::out_of_range("blob index out of range");
+
+	const PackageBlobEntry& entry = m_blobs[index];
+	const uint8_t* data = m_view + entry.offset;
+	switch (entry.compression) {
+	case PACKAGE_COMPRESSION_NONE:
+		blob.Reference(shared_from_this(), data, (size_t)entry.size);
+		break;
+	case PACKAGE_COMPRESSION_ZLIB: {
+		zlib::uLongf destLen = (zlib::uLongf)entry.rawSize;
+		uint8_t* dest = blob.Allocate((size_t)entry.rawSize);
+		if (zlib::uncompress((zlib::Bytef*)dest, &destLen,
+			(const zlib::Bytef*)data, (zlib::uLong)entry.size) != Z_OK ||
+			destLen != entry.rawSize) {
+			blob.Clear();
+			throw std::runtime_error("mask package blob failed to decompress");
+		}
+		break;
+	}
+	default:
+		throw std::invalid_argument("unknown mask package blob compression");
+	}
+}
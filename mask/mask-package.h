@@ -0,0 +1,132 @@
+/*
+ * Face Masks for SlOBS
+ * Copyright (C) 2017 General Workings Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include <inttypes.h>
+#include <string>
+#include <vector>
+#include <memory>
+
+// Mask package file layout
+//
+//   PackageHeader
+//   mask json (utf-8, null terminated)
+//   PackageBlobEntry[numBlobs]
+//   blobs, each aligned to MASK_PACKAGE_BLOB_ALIGNMENT
+//
+// The json is the regular mask json, except that every base64 data
+// field is replaced with a blob reference ("@blob:<index>"). The blobs
+// hold the already decoded data (mips, vertex/index buffers, channel
+// values, png/obj/effect files), so loading them is just a pointer
+// into the mapped file.
+//
+// Note: this header is shared with MaskMaker, keep it free of libobs.
+//
+#define MASK_PACKAGE_MAGIC				"FMPK"
+#define MASK_PACKAGE_VERSION			(1)
+#define MASK_PACKAGE_BLOB_ALIGNMENT		(16)
+#define MASK_PACKAGE_BLOB_PREFIX		"@blob:"
+#define MASK_PACKAGE_EXTENSION			".fmpk"
+// zlib can't inflate more than about 1032:1, anything claiming more is
+// corrupt, and no single blob gets bigger than this
+#define MASK_PACKAGE_MAX_INFLATE_RATIO	(1032)
+#define MASK_PACKAGE_MAX_BLOB_SIZE		(1024ULL * 1024ULL * 1024ULL)
+
+namespace Mask {
+
+	enum PackageCompression : uint32_t {
+		PACKAGE_COMPRESSION_NONE = 0,
+		PACKAGE_COMPRESSION_ZLIB = 1,
+	};
+
+	struct PackageHeader {
+		char		magic[4];
+		uint32_t	version;
+		uint32_t	numBlobs;
+		uint32_t	reserved;
+		uint64_t	jsonOffset;
+		uint64_t	jsonSize;
+		uint64_t	blobTableOffset;
+	};
+
+	struct PackageBlobEntry {
+		uint64_t	offset;			// from start of file
+		uint64_t	size;			// size as stored
+		uint64_t	rawSize;		// size after decompression
+		uint32_t	compression;	// PackageCompression
+		uint32_t	reserved;
+	};
+
+	class Package;
+
+	// Blob : data of one resource blob
+	// - points straight into the mapped package if the blob is stored
+	//   uncompressed, otherwise at our own decoded copy
+	// - keeps the package mapped for as long as it's around
+	class Blob {
+	public:
+		Blob() : m_data(nullptr), m_size(0) {}
+		Blob(Blob&& other) = default;
+		Blob& operator=(Blob&& other) = default;
+		Blob(const Blob&) = delete;
+		Blob& operator=(const Blob&) = delete;
+
+		const uint8_t*	data() const { return m_data; }
+		size_t			size() const { return m_size; }
+		bool			empty() const { return m_size == 0; }
+
+		void			Reference(std::shared_ptr<const Package> package,
+							const uint8_t* data, size_t size);
+		uint8_t*		Allocate(size_t size);
+		void			Take(std::vector<uint8_t>&& data);
+		void			Clear();
+
+	private:
+		const uint8_t*					m_data;
+		size_t							m_size;
+		std::vector<uint8_t>			m_storage;
+		std::shared_ptr<const Package>	m_package;
+	};
+
+	// Package : memory mapped mask package
+	class Package : public std::enable_shared_from_this<Package> {
+	public:
+		Package(const std::string& file);
+		~Package();
+
+		static bool IsPackage(const std::string& file);
+		static bool IsBlobRef(const char* value);
+
+		const char*	GetJSON() const;
+		size_t		GetNumBlobs() const { return m_numBlobs; }
+		void		GetBlob(const char* blobRef, Blob& blob) const;
+		void		GetBlob(size_t index, Blob& blob) const;
+
+	private:
+		void*						m_file;
+		void*						m_mapping;
+		const uint8_t*				m_view;
+		size_t						m_size;
+		const PackageHeader*		m_header;
+		const PackageBlobEntry*		m_blobs;
+		size_t						m_numBlobs;
+
+		void	Unmap();
+	};
+}
@@ -22,61 +22,43 @@
 #include "plugin/exceptions.h"
 #include "plugin/plugin.h"
 #include "plugin/utils.h"
+#include <algorithm>
+#include <climits>
 
 
-float	Mask::Resource::AnimationChannel::GetValue(int frame) {
-	float v = 0.0f;
+int	Mask::Resource::AnimationChannel::GetFrame(int frame) const {
+	if (numFrames <= 0)
+		return -1;
 
 	if (frame < 0) {
 		switch (preState) {
 		case CONSTANT:
-			if (values.size() > 0)
-				v = values[0];
-			break;
 		case LINEAR:
-			// todo
-			if (values.size() > 0)
-				v = values[0];
-			break;
+			// todo: linear
+			return 0;
 		case REPEAT:
-			while (frame < 0)
-				frame += (int)values.size();
-			if (frame < values.size())
-				v = values[frame];
-			break;
+			frame %= numFrames;
+			return frame < 0 ? frame + numFrames : frame;
 		}
 	}
-	else if (frame >= values.size()) {
+	else if (frame >= numFrames) {
 		switch (postState) {
 		case CONSTANT:
-			if (values.size() > 0)
-				v = values[values.size() - 1];
-			break;
 		case LINEAR:
-			// TODO
-			if (values.size() > 0)
-				v = values[values.size() - 1];
-			break;
+			// todo: linear
+			return numFrames - 1;
 		case REPEAT:
-			if (values.size() > 0) {
-				frame = frame % values.size();
-				v = values[frame];
-			}
-			break;
+			return frame % numFrames;
 		}
 	}
-	else {
-		v = values[frame];
-	}
-
-	return v;
+	return frame;
 }
 
 
 
 
 Mask::Resource::Animation::Animation(Mask::MaskData* parent, std::string name, obs_data_t* data)
-	: IBase(parent, name), m_speed(1.0f), m_stopOnLastFrame(false) {
+	: IBase(parent, name), m_speed(1.0f), m_stopOnLastFrame(false), m_commonFrames(0) {
 
 	if (!obs_data_has_user_value(data, S_DURATION)) {
 		PLOG_ERROR("Animation '%s' has no duration.", name.c_str());
@@ -100,6 +82,7 @@ Mask::Resource::Animation::Animation(Mask::MaskData* parent, std::string name, o
 		throw std::logic_error("Animation has no channels.");
 	}
 	obs_data_t* channels = obs_data_get_obj(data, S_CHANNELS);
+	std::vector<std::vector<float>> channelValues;
 	for (obs_data_item_t* el = obs_data_first(channels); el; obs_data_item_next(&el)) {
 		std::string channelName = obs_data_item_get_name(el);
 		obs_data_t* chand = obs_data_item_get_obj(el);
@@ -164,15 +147,102 @@ Mask::Resource::Animation::Animation(Mask::MaskData* parent, std::string name, o
 			PLOG_ERROR("Animation '%s' channel has empty values data.", name.c_str());
 			throw std::logic_error("Animation channel has empty values data.");
 		}
-		std::vector<uint8_t> decoded;
-		base64_decodeZ(base64data, decoded);
-		size_t numFloats = decoded.size() / sizeof(float);
-		channel.values.assign((float*)decoded.data(), (float*)decoded.data() + numFloats);
+		Blob decoded;
+		m_parent->GetBlob(name, "channels/" + channelName, base64data, decoded);
+
+		// channels with nothing to animate can go
+		if (channel.item == nullptr) {
+			obs_data_release(chand);
+			continue;
+		}
 
+		std::string encoding;
+		if (obs_data_has_user_value(chand, S_ENCODING))
+			encoding = obs_data_get_string(chand, S_ENCODING);
+		if (encoding == MASK_CURVE_ENCODING) {
+			AnimationCurve curve;
+			if (!curve.Load(decoded.data(), decoded.size())) {
+				obs_data_release(chand);
+				obs_data_release(channels);
+				PLOG_ERROR("Animation '%s' channel has a bad curve.", name.c_str());
+				throw std::logic_error("Animation channel has a bad curve.");
+			}
+			channel.numFrames = curve.GetNumFrames();
+			channel.curve = (int)m_curves.size();
+			m_curves.emplace_back(std::move(curve));
+			channelValues.emplace_back();
+		}
+		else if (encoding.empty()) {
+			size_t numFloats = decoded.size() / sizeof(float);
+			channel.numFrames = (int)numFloats;
+			channel.curve = -1;
+			std::vector<float> values(numFloats);
+			memcpy(values.data(), decoded.data(), numFloats * sizeof(float));
+			channelValues.emplace_back(std::move(values));
+		}
+		else {
+			obs_data_release(chand);
+			obs_data_release(channels);
+			PLOG_ERROR("Animation '%s' channel has unknown encoding '%s'.",
+				name.c_str(), encoding.c_str());
+			throw std::logic_error("Animation channel has unknown encoding.");
+		}
 		m_channels.emplace_back(channel);
 		obs_data_release(chand);
 	}
 	obs_data_release(channels);
+
+	BuildChannels(channelValues);
+}
+
+void Mask::Resource::Animation::BuildChannels(
+	const std::vector<std::vector<float>>& channelValues) {
+
+	// group the channels by target, keeping their order otherwise
+	size_t numChannels = m_channels.size();
+	std::vector<size_t> order(numChannels);
+	for (size_t i = 0; i < numChannels; i++)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+		return m_channels[a].item.get() < m_channels[b].item.get();
+	});
+	std::vector<AnimationChannel> channels;
+	channels.reserve(numChannels);
+	for (size_t i : order)
+		channels.push_back(m_channels[i]);
+	m_channels.swap(channels);
+
+	m_targets.clear();
+	m_denseChannels.clear();
+	m_channelTypes.resize(numChannels);
+	int numFrames = 0;
+	m_commonFrames = INT_MAX;
+	for (size_t i = 0; i < numChannels; i++) {
+		const AnimationChannel& ch = m_channels[i];
+		m_channelTypes[i] = ch.type;
+		if (m_targets.empty() || m_targets.back().item != ch.item.get())
+			m_targets.push_back({ ch.item.get(), i, 0 });
+		m_targets.back().count++;
+		if (ch.curve >= 0)
+			continue;
+		m_denseChannels.push_back(i);
+		if (ch.numFrames > numFrames)
+			numFrames = ch.numFrames;
+		if (ch.numFrames < m_commonFrames)
+			m_commonFrames = ch.numFrames;
+	}
+	if (m_denseChannels.empty())
+		m_commonFrames = 0;
+
+	// one row per frame, shorter channels just leave theirs unused
+	size_t numColumns = m_denseChannels.size();
+	m_frames.assign((size_t)numFrames * numColumns, 0.0f);
+	for (size_t c = 0; c < numColumns; c++) {
+		const std::vector<float>& values = channelValues[order[m_denseChannels[c]]];
+		for (size_t f = 0; f < values.size(); f++)
+			m_frames[f * numColumns + c] = values[f];
+	}
+	m_values.resize(numChannels);
 }
 
 Mask::Resource::Animation::~Animation() {}
@@ -186,8 +256,8 @@ void Mask::Resource::Animation::Update(Mask::Part* part, float time) {
 	m_parent->instanceDatas.Push(m_id);
 
 	// get our instance data
-	std::shared_ptr<AnimationInstanceData> instData =
-		m_parent->instanceDatas.GetData<AnimationInstanceData>();
+	AnimationInstanceData* instData =
+		m_parent->instanceDatas.GetData(m_instanceCache);
 
 	// time has elapsed
 	instData->elapsed += time * m_speed;
@@ -210,12 +280,38 @@ void Mask::Resource::Animation::Update(Mask::Part* part, float time) {
 
 	// process animation channels
 	int frame = (int)(instData->elapsed * m_fps);
-	for (int i = 0; i < m_channels.size(); i++) {
-		AnimationChannel& ch = m_channels[i];
-		if (ch.item != nullptr) {
-			ch.item->SetAnimatableValue(ch.GetValue(frame), ch.type);
+	size_t numChannels = m_channels.size();
+	size_t numColumns = m_denseChannels.size();
+	if (frame >= 0 && frame < m_commonFrames) {
+		// every dense channel has this frame
+		const float* row = m_frames.data() + (size_t)frame * numColumns;
+		if (numColumns == numChannels)
+			memcpy(m_values.data(), row, numChannels * sizeof(float));
+		else {
+			for (size_t c = 0; c < numColumns; c++)
+				m_values[m_denseChannels[c]] = row[c];
+		}
+	}
+	else {
+		for (size_t c = 0; c < numColumns; c++) {
+			size_t i = m_denseChannels[c];
+			int f = m_channels[i].GetFrame(frame);
+			m_values[i] = f < 0 ? 0.0f : m_frames[(size_t)f * numColumns + c];
 		}
 	}
+	if (!m_curves.empty()) {
+		for (size_t i = 0; i < numChannels; i++) {
+			const AnimationChannel& ch = m_channels[i];
+			if (ch.curve < 0)
+				continue;
+			int f = ch.GetFrame(frame);
+			m_values[i] = f < 0 ? 0.0f : m_curves[ch.curve].Evaluate(f);
+		}
+	}
+	for (const AnimationTarget& target : m_targets) {
+		target.item->SetAnimatableValues(m_values.data() + target.first,
+			m_channelTypes.data() + target.first, target.count);
+	}
 
 	m_parent->instanceDatas.Pop();
 }
@@ -229,8 +325,8 @@ void Mask::Resource::Animation::Seek(float t) {
 	m_parent->instanceDatas.Push(m_id);
 
 	// get our instance data
-	std::shared_ptr<AnimationInstanceData> instData =
-		m_parent->instanceDatas.GetData<AnimationInstanceData>();
+	AnimationInstanceData* instData =
+		m_parent->instanceDatas.GetData(m_instanceCache);
 
 	// reset time
 	instData->elapsed = t;
@@ -242,8 +338,8 @@ float   Mask::Resource::Animation::GetPosition() {
 	m_parent->instanceDatas.Push(m_id);
 
 	// get our instance data
-	std::shared_ptr<AnimationInstanceData> instData =
-		m_parent->instanceDatas.GetData<AnimationInstanceData>();
+	AnimationInstanceData* instData =
+		m_parent->instanceDatas.GetData(m_instanceCache);
 
 	m_parent->instanceDatas.Pop();
 
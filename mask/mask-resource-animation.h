@@ -19,6 +19,7 @@
 #pragma once
 #include "mask-resource.h"
 #include "mask-instance-data.h"
+#include "mask-animation-curve.h"
 #include <vector>
 extern "C" {
 #pragma warning( push )
@@ -69,6 +70,13 @@ namespace Mask {
 		class IAnimatable {
 		public:
 			virtual void SetAnimatableValue(float v, AnimationChannelType act) = 0;
+			// all of our channels for a frame in one go, animations call
+			// this once per target per frame
+			virtual void SetAnimatableValues(const float* values,
+				const AnimationChannelType* types, size_t count) {
+				for (size_t i = 0; i < count; i++)
+					SetAnimatableValue(values[i], types[i]);
+			}
 		};
 
 		class IAnimationControls {
@@ -99,9 +107,11 @@ namespace Mask {
 			AnimationChannelType			type;
 			AnimationBehaviour				preState;
 			AnimationBehaviour				postState;
-			std::vector<float>				values;
+			int								numFrames;
+			int								curve;	// index into the curves, -1 for dense values
 
-			float	GetValue(int frame);
+			// the frame we take our value from, or -1 for none
+			int		GetFrame(int frame) const;
 		};
 
 
@@ -138,14 +148,39 @@ namespace Mask {
 			const char* const S_PRESTATE = "pre-state";
 			const char* const S_POSTSTATE = "post-state";
 			const char* const S_VALUES = "values";
+			const char* const S_ENCODING = "encoding";
 
 		protected:
 			float							m_speed;
 			float							m_duration;
 			float							m_fps;
-			std::vector<AnimationChannel>	m_channels;
+
+			// Channels
+			// - grouped by target, so each target gets all of its values
+			//   in one SetAnimatableValues call
+			// - dense values are stored frame by frame, one row holds
+			//   every dense channel, so most frames are a single row copy
+			// - curve channels decode as they play, see AnimationCurve.
+			//   The curve cursors are only a cache, so instances can
+			//   share them.
+			struct AnimationTarget {
+				IAnimatable*	item;
+				size_t			first;
+				size_t			count;
+			};
+			std::vector<AnimationChannel>		m_channels;
+			std::vector<AnimationChannelType>	m_channelTypes;
+			std::vector<AnimationTarget>		m_targets;
+			std::vector<float>					m_frames;
+			std::vector<size_t>					m_denseChannels;	// channel of each row column
+			std::vector<AnimationCurve>			m_curves;
+			int									m_commonFrames;
+			std::vector<float>					m_values;
 			bool							m_stopOnLastFrame;
 
+			InstanceDataCache<AnimationInstanceData>	m_instanceCache;
+
+			void BuildChannels(const std::vector<std::vector<float>>& channelValues);
 			AnimationChannelType AnimationTypeFromString(const std::string& s);
 			AnimationBehaviour AnimationBehaviourFromString(const std::string& s);
 		};
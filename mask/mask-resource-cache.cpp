@@ -0,0 +1,259 @@
+/*
+ * Face Masks for SlOBS
+ * Copyright (C) 2017 General Workings Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "mask-resource.h"
+
+
+// ------------------------------------------------------------------------- //
+// Cache Pools
+// ------------------------------------------------------------------------- //
+
+const size_t Mask::Resource::Cache::DEFAULT_BUDGET = 512 * 1024 * 1024;
+
+Mask::Resource::Cache::Cache() : m_bytes(0), m_budget(DEFAULT_BUDGET),
+	m_hits(0), m_misses(0), m_evictions(0) {}
+
+bool Mask::Resource::Cache::add_permanent(CacheableType resource_type, std::string name, void *resource) {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto pool_it = permanent_cache.find(name);
+	if (pool_it == permanent_cache.end()) {
+		permanent_cache[name] = std::make_pair(resource_type, resource);
+		return true;
+	}
+	return false;
+}
+
+std::string Mask::Resource::Cache::item_key(CacheableType resource_type, const std::string& key) {
+	// same data could make both a texture and an effect
+	return std::to_string((int)resource_type) + ":" + key;
+}
+
+void Mask::Resource::Cache::make_idle(const std::string& ikey, CacheItem& item) {
+	item.idle_list = (item.use_count > 1) ? &m_idleReused : &m_idleOnce;
+	item.idle_list->push_front(ikey);
+	item.idle_it = item.idle_list->begin();
+}
+
+void Mask::Resource::Cache::make_active(CacheItem& item) {
+	if (item.idle_list) {
+		item.idle_list->erase(item.idle_it);
+		item.idle_list = nullptr;
+	}
+}
+
+void Mask::Resource::Cache::evict(size_t needed, Destructions& destructions) {
+	// least recently used first, things only used once before re-used ones
+	while (m_bytes + needed > m_budget) {
+		std::list<std::string>* list = !m_idleOnce.empty() ? &m_idleOnce :
+			!m_idleReused.empty() ? &m_idleReused : nullptr;
+		if (!list)
+			break;
+		auto it = m_items.find(list->back());
+		list->pop_back();
+		destructions.emplace_back(it->second.type, it->second.resource);
+		m_bytes -= it->second.bytes;
+		m_items.erase(it);
+		m_evictions++;
+	}
+}
+
+void Mask::Resource::Cache::destruct_all(const Destructions& destructions) {
+	// never called holding m_mutex: destructing enters the graphics
+	// context, and graphics threads call into us
+	for (const auto& d : destructions)
+		destruct_by_type(d.second, d.first);
+}
+
+bool Mask::Resource::Cache::add(CacheableType resource_type, const std::string& key, 
+	void *resource, size_t bytes) {
+	if (key.empty() || resource == nullptr)
+		return false;
+
+	Destructions destructions;
+	bool added = false;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		std::string ikey = item_key(resource_type, key);
+		auto it = m_items.find(ikey);
+		if (it != m_items.end()) {
+			// someone else beat us to it, the caller keeps its own copy
+			if (it->second.active_count > 0)
+				return false;
+			// no one is using the old one, replace it
+			make_active(it->second);
+			destructions.emplace_back(it->second.type, it->second.resource);
+			m_bytes -= it->second.bytes;
+			m_items.erase(it);
+		}
+
+		// make room, we can't cache it if it still doesn't fit
+		evict(bytes, destructions);
+		if (m_bytes + bytes <= m_budget) {
+			CacheItem& item = m_items[ikey];
+			item.resource = resource;
+			item.type = resource_type;
+			item.bytes = bytes;
+			item.use_count = 1;
+			item.active_count = 1;
+			item.idle_list = nullptr;
+			m_bytes += bytes;
+			added = true;
+		}
+	}
+	destruct_all(destructions);
+	return added;
+}
+
+void Mask::Resource::Cache::load(CacheableType resource_type, const std::string& key, void **resource_ptr) {
+	*resource_ptr = nullptr;
+	if (key.empty())
+		return;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto it = m_items.find(item_key(resource_type, key));
+	if (it == m_items.end()) {
+		m_misses++;
+		return;
+	}
+	CacheItem& item = it->second;
+	make_active(item);
+	item.active_count++;
+	item.use_count++;
+	m_hits++;
+	*resource_ptr = item.resource;
+}
+
+void Mask::Resource::Cache::load_permanent(std::string name, void **resource_ptr) {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto item = permanent_cache.find(name);
+	if (item != permanent_cache.end()) {
+		*resource_ptr = item->second.second;
+	}
+	else
+		*resource_ptr = nullptr;
+}
+
+void Mask::Resource::Cache::destruct_by_type(void *resource, CacheableType resource_type) {
+	if (resource == nullptr) return;
+
+	obs_enter_graphics();
+	switch (resource_type)
+	{
+	case CacheableType::Texture:
+	{
+		gs_texture_t *texture = reinterpret_cast<gs_texture_t*>(resource);
+
+		switch (gs_get_texture_type(texture)) {
+		case GS_TEXTURE_2D:
+			gs_texture_destroy(texture);
+			break;
+		case GS_TEXTURE_3D:
+			gs_voltexture_destroy(texture);
+			break;
+		case GS_TEXTURE_CUBE:
+			gs_cubetexture_destroy(texture);
+			break;
+		}
+	}
+	break;
+	case CacheableType::Effect:
+	{
+		gs_effect_t *effect = reinterpret_cast<gs_effect_t*>(resource);
+		gs_effect_destroy(effect);
+	}
+	break;
+	case CacheableType::OBSData:
+	{
+		obs_data_t *data = reinterpret_cast<obs_data_t*>(resource);
+		obs_data_release(data);
+	}
+	break;
+	}
+	obs_leave_graphics();
+}
+
+void Mask::Resource::Cache::try_destroy_resource(const std::string& key, void *resource, CacheableType resource_type) {
+	Destructions destructions;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		// only destroy if the resource is not managed by the pool
+		auto it = key.empty() ? m_items.end() : m_items.find(item_key(resource_type, key));
+		if (it == m_items.end() || it->second.resource != resource) {
+			destructions.emplace_back(resource_type, resource);
+		}
+		else if (it->second.active_count > 0 && --it->second.active_count == 0) {
+			// keep it around for the next mask, within budget
+			make_idle(it->first, it->second);
+			evict(0, destructions);
+		}
+	}
+	destruct_all(destructions);
+}
+
+void Mask::Resource::Cache::set_budget(size_t bytes) {
+	Destructions destructions;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_budget = bytes;
+		evict(0, destructions);
+	}
+	destruct_all(destructions);
+}
+
+Mask::Resource::Cache::Stats Mask::Resource::Cache::get_stats() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	Stats stats;
+	stats.hits = m_hits;
+	stats.misses = m_misses;
+	stats.evictions = m_evictions;
+	stats.items = m_items.size();
+	stats.bytes = m_bytes;
+	stats.budget = m_budget;
+	return stats;
+}
+
+void Mask::Resource::Cache::destroy() {
+	Stats stats = get_stats();
+	blog(LOG_INFO, "[Face Mask] Resource cache: %zu hits, %zu misses, %zu evictions, "
+		"%zu items, %zu of %zu bytes", stats.hits, stats.misses, stats.evictions,
+		stats.items, stats.bytes, stats.budget);
+
+	Destructions destructions;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		// pool-managed resources
+		for (auto &ent : m_items)
+			destructions.emplace_back(ent.second.type, ent.second.resource);
+		m_items.clear();
+		m_idleOnce.clear();
+		m_idleReused.clear();
+		m_bytes = 0;
+
+		// permanent resources
+		for (auto &ent : permanent_cache)
+			destructions.push_back(ent.second);
+		permanent_cache.clear();
+	}
+
+	obs_enter_graphics();
+	destruct_all(destructions);
+	obs_leave_graphics();
+}
@@ -18,6 +18,7 @@
 */
 
 #include "mask-resource-effect.h"
+#include "mask.h"
 #include "plugin/exceptions.h"
 #include "plugin/plugin.h"
 #include "plugin/utils.h"
@@ -100,9 +101,16 @@ Mask::Resource::Effect::Effect(Mask::MaskData* parent, std::string name, obs_dat
 		throw std::logic_error("Effect has empty data.");
 	}
 
-	// write to temp file
-	m_filename = Utils::Base64ToTempFile(base64data);
-	m_filenameIsTemp = true;
+	// keep the code, skipping any utf-8 bom like os_quick_read_utf8_file does
+	Blob blob;
+	m_parent->GetBlob(name, S_DATA, base64data, blob);
+	const char* code = (const char*)blob.data();
+	size_t codeSize = blob.size();
+	if (codeSize >= 3 && memcmp(code, "\xEF\xBB\xBF", 3) == 0) {
+		code += 3;
+		codeSize -= 3;
+	}
+	m_code.assign(code, codeSize);
 
 	// cache
 	m_cache = cache;
@@ -112,7 +120,6 @@ Mask::Resource::Effect::Effect(Mask::MaskData* parent, std::string name, std::st
 	: IBase(parent, name) {
 
 	m_filename = filename;
-	m_filenameIsTemp = false;
 
 	// cache
 	m_cache = cache;
@@ -135,12 +142,14 @@ void Mask::Resource::Effect::Render(Mask::Part* part) {
 	UNUSED_PARAMETER(part);
 	if (m_Effect == nullptr) {
 
-		m_Effect = Effect::compile(m_name, m_filename, m_cache);
-
-		if (m_filenameIsTemp) {
-			Utils::DeleteTempFile(m_filename);
+		if (m_code.length() > 0) {
+			m_Effect = std::make_shared<GS::Effect>(m_code, m_name, m_cache);
+			m_code.clear();
+		}
+		else {
+			m_Effect = Effect::compile(m_name, m_filename, m_cache);
+			m_filename.clear();
 		}
-		m_filename.clear();
 	}
 
 	return;
@@ -54,7 +54,7 @@ namespace Mask {
 
 			// for delayed gs creation
 			std::string		m_filename;
-			bool			m_filenameIsTemp;
+			std::string		m_code;
 
 			// for dynamic shader creation
 			std::vector<std::string> m_active_textures;
@@ -20,6 +20,7 @@
 #include "mask-resource-emitter.h"
 #include "plugin/exceptions.h"
 #include "plugin/plugin.h"
+#include <emmintrin.h>
 
 
 Mask::Resource::Emitter::Emitter(Mask::MaskData* parent, std::string name, obs_data_t* data)
@@ -184,10 +185,6 @@ Mask::Resource::Emitter::Emitter(Mask::MaskData* parent, std::string name, obs_d
 	if (obs_data_has_user_value(data, S_INVERSE_RATE)) {
 		m_inverseRate = obs_data_get_bool(data, S_INVERSE_RATE);
 	}
-
-	// Seed rand
-	time_t seconds_since_epoch = ::time(0);
-	srand((unsigned int)seconds_since_epoch);
 }
 
 Mask::Resource::Emitter::~Emitter() {
@@ -198,8 +195,36 @@ Mask::Resource::Type Mask::Resource::Emitter::GetType() {
 	return Mask::Resource::Type::Emitter;
 }
 
-float Mask::Resource::Emitter::RandFloat(float min, float max) {
-	float a = (float)rand() / (float)RAND_MAX;
+// xorshift32, one step
+static inline uint32_t NextRandom(uint32_t& state) {
+	uint32_t x = state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	state = x;
+	return x;
+}
+
+// xorshift32, four lanes at a time
+static inline __m128i NextRandom4(__m128i& state) {
+	__m128i x = state;
+	x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+	x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+	state = x;
+	return x;
+}
+
+// four random floats in [min, min + range)
+static inline __m128 RandFloat4(__m128i& state, __m128 min, __m128 range) {
+	// top 24 bits convert to float exactly
+	__m128 a = _mm_cvtepi32_ps(_mm_srli_epi32(NextRandom4(state), 8));
+	a = _mm_mul_ps(a, _mm_set1_ps(1.0f / 16777216.0f));
+	return _mm_add_ps(_mm_mul_ps(a, range), min);
+}
+
+float Mask::Resource::Emitter::RandFloat(uint32_t& state, float min, float max) {
+	float a = (float)(NextRandom(state) >> 8) * (1.0f / 16777216.0f);
 	return a * (max - min) + min; 
 }
 
@@ -209,20 +234,20 @@ void Mask::Resource::Emitter::Update(Mask::Part* part, float time) {
 	m_parent->instanceDatas.Push(m_id);
 
 	// get our instance data
-	std::shared_ptr<EmitterInstanceData> instData =
-		m_parent->instanceDatas.GetData<EmitterInstanceData>();
-	instData->Init(m_numParticles, this);
+	EmitterInstanceData* instData =
+		m_parent->instanceDatas.GetData(m_instanceCache);
+	instData->Init(m_numParticles, (uint32_t)::time(0) ^ (uint32_t)m_id);
 
 	// update our model
-	Particle* p = instData->particles;
-	for (int i = 0; i < m_numParticles; i++, p++) {
-		if (p->state == Particle::State::ALIVE) {
-			m_parent->instanceDatas.Push(p->id);
-			m_model->Update(part, time);
-			m_parent->instanceDatas.Pop();
-		}
+	for (int i = 0; i < instData->numPlaced; i++) {
+		m_parent->instanceDatas.Push(instData->ids[i]);
+		m_model->Update(part, time);
+		m_parent->instanceDatas.Pop();
 	}
 
+	// Update particles
+	Integrate(instData, time);
+
 	// use scale to control emission
 	bool zeroScale = false;
 	if (part->global.x.x < 0.000001f &&
@@ -239,110 +264,169 @@ void Mask::Resource::Emitter::Update(Mask::Part* part, float time) {
 		int numToEmit = 1;
 		if (instData->delta_time > 0.000001f)
 			numToEmit = (int)(instData->elapsed / instData->delta_time);
+		uint32_t& rng = instData->rng[0];
 		while (numToEmit-- > 0) {
-			// find dead particle
-			p = instData->particles;
-			int idx = 0;
-			for (idx = 0; idx < m_numParticles; idx++, p++) {
-				if (p->state == Particle::State::DEAD)
-					break;
-			}
-			if (idx < m_numParticles) {
-				// actually spawn a new particle
-				instData->elapsed = 0.0f;
-				p->elapsed = 0.0f;
-				p->state = Particle::State::SPAWNED;
-
-				// we will set up transform when rendering
-				vec3_zero(&p->position);
-				vec3_set(&p->velocity,
-					RandFloat(m_initialVelocityMin.x, m_initialVelocityMax.x) * time,
-					RandFloat(m_initialVelocityMin.y, m_initialVelocityMax.y) * time,
-					RandFloat(m_initialVelocityMin.z, m_initialVelocityMax.z) * time);
-			}
+			int idx = instData->Spawn();
+			if (idx < 0)
+				break;
+
+			// actually spawn a new particle
+			instData->elapsed = 0.0f;
+			instData->age[idx] = 0.0f;
+
+			// we will set up transform when rendering
+			instData->positionX[idx] = 0.0f;
+			instData->positionY[idx] = 0.0f;
+			instData->positionZ[idx] = 0.0f;
+			instData->velocityX[idx] =
+				RandFloat(rng, m_initialVelocityMin.x, m_initialVelocityMax.x) * time;
+			instData->velocityY[idx] =
+				RandFloat(rng, m_initialVelocityMin.y, m_initialVelocityMax.y) * time;
+			instData->velocityZ[idx] =
+				RandFloat(rng, m_initialVelocityMin.z, m_initialVelocityMax.z) * time;
 		}
 
 		// random emit rate
 		if (m_inverseRate)
 			// seconds between particles
-			instData->delta_time = RandFloat(m_rateMin, m_rateMax);
+			instData->delta_time = RandFloat(rng, m_rateMin, m_rateMax);
 		else
 			// particles / second
-			instData->delta_time = 1.0f / RandFloat(m_rateMin, m_rateMax);
+			instData->delta_time = 1.0f / RandFloat(rng, m_rateMin, m_rateMax);
 	}
 
-	// Update particles
-	p = instData->particles;
-	for (int i = 0; i < m_numParticles; i++, p++) {
-		if (p->state == Particle::State::ALIVE) {
-			p->elapsed += time;
-			if (p->elapsed > m_lifetime) {
-				// kill particle
-				p->state = Particle::State::DEAD;
-				continue;
-			}
+	m_parent->instanceDatas.Pop();
+}
 
-			// velocity
-			vec3 v;
-			vec3_mulf(&v, &p->velocity, time);
-			vec3_add(&p->position, &p->position, &v);
-			// friction
-			vec3_mulf(&p->velocity, &p->velocity, 
-				RandFloat(m_frictionMin, m_frictionMax));
-			// force
-			vec3 f;
-			vec3_set(&f,
-				RandFloat(m_forceMin.x, m_forceMax.x),
-				RandFloat(m_forceMin.y, m_forceMax.y),
-				RandFloat(m_forceMin.z, m_forceMax.z));
-			vec3_mulf(&f, &f, time);
-			vec3_add(&p->velocity, &p->velocity, &f);
-		}
+void Mask::Resource::Emitter::Integrate(EmitterInstanceData* instData, float time) {
+	int count = instData->numPlaced;
+	float* px = instData->positionX.data();
+	float* py = instData->positionY.data();
+	float* pz = instData->positionZ.data();
+	float* vx = instData->velocityX.data();
+	float* vy = instData->velocityY.data();
+	float* vz = instData->velocityZ.data();
+	float* age = instData->age.data();
+
+	// four at a time
+	const __m128 dt = _mm_set1_ps(time);
+	const __m128 frictionMin = _mm_set1_ps(m_frictionMin);
+	const __m128 frictionRange = _mm_set1_ps(m_frictionMax - m_frictionMin);
+	const __m128 forceMinX = _mm_set1_ps(m_forceMin.x);
+	const __m128 forceMinY = _mm_set1_ps(m_forceMin.y);
+	const __m128 forceMinZ = _mm_set1_ps(m_forceMin.z);
+	const __m128 forceRangeX = _mm_set1_ps(m_forceMax.x - m_forceMin.x);
+	const __m128 forceRangeY = _mm_set1_ps(m_forceMax.y - m_forceMin.y);
+	const __m128 forceRangeZ = _mm_set1_ps(m_forceMax.z - m_forceMin.z);
+	__m128i rng = _mm_loadu_si128((const __m128i*)instData->rng);
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(age + i, _mm_add_ps(_mm_loadu_ps(age + i), dt));
+
+		__m128 x = _mm_loadu_ps(vx + i);
+		__m128 y = _mm_loadu_ps(vy + i);
+		__m128 z = _mm_loadu_ps(vz + i);
+
+		// velocity
+		_mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(x, dt)));
+		_mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(y, dt)));
+		_mm_storeu_ps(pz + i, _mm_add_ps(_mm_loadu_ps(pz + i), _mm_mul_ps(z, dt)));
+
+		// friction
+		__m128 f = RandFloat4(rng, frictionMin, frictionRange);
+		x = _mm_mul_ps(x, f);
+		y = _mm_mul_ps(y, f);
+		z = _mm_mul_ps(z, f);
+
+		// force
+		x = _mm_add_ps(x, _mm_mul_ps(RandFloat4(rng, forceMinX, forceRangeX), dt));
+		y = _mm_add_ps(y, _mm_mul_ps(RandFloat4(rng, forceMinY, forceRangeY), dt));
+		z = _mm_add_ps(z, _mm_mul_ps(RandFloat4(rng, forceMinZ, forceRangeZ), dt));
+
+		_mm_storeu_ps(vx + i, x);
+		_mm_storeu_ps(vy + i, y);
+		_mm_storeu_ps(vz + i, z);
+	}
+	_mm_storeu_si128((__m128i*)instData->rng, rng);
+
+	// the rest
+	uint32_t& r = instData->rng[0];
+	for (; i < count; i++) {
+		age[i] += time;
+
+		// velocity
+		px[i] += vx[i] * time;
+		py[i] += vy[i] * time;
+		pz[i] += vz[i] * time;
+		// friction
+		float f = RandFloat(r, m_frictionMin, m_frictionMax);
+		vx[i] *= f;
+		vy[i] *= f;
+		vz[i] *= f;
+		// force
+		vx[i] += RandFloat(r, m_forceMin.x, m_forceMax.x) * time;
+		vy[i] += RandFloat(r, m_forceMin.y, m_forceMax.y) * time;
+		vz[i] += RandFloat(r, m_forceMin.z, m_forceMax.z) * time;
+	}
+
+	// kill old particles
+	for (i = 0; i < instData->numPlaced;) {
+		if (age[i] > m_lifetime)
+			instData->Kill(i);
+		else
+			i++;
 	}
-
-	m_parent->instanceDatas.Pop();
 }
 
 void Mask::Resource::Emitter::Render(Mask::Part* part) {
 
 	m_parent->instanceDatas.Push(m_id);
 
-	// get our global matrix
-	matrix4 global;
-	gs_matrix_get(&global);
-
 	// get our instance data
-	std::shared_ptr<EmitterInstanceData> instData =
-		m_parent->instanceDatas.GetData<EmitterInstanceData>();
-	if (instData->particles == nullptr) {
+	EmitterInstanceData* instData =
+		m_parent->instanceDatas.GetData(m_instanceCache);
+	if (instData->numAlive == 0) {
 		m_parent->instanceDatas.Pop();
 		return;
 	}
 
-	// add particles as sorted draw objects 
-	Particle* p = instData->particles;
-	for (int i = 0; i < m_numParticles; i++, p++) {
-		if (p->state != Particle::State::DEAD) {
-			// first time spawned
-			if (p->state == Particle::State::SPAWNED) {
-				if (m_worldSpace) {
-					p->position.x = global.t.x;
-					p->position.y = global.t.y;
-					p->position.z = global.t.z;
-					vec3_transform(&(p->velocity), &(p->velocity), &global);
-				}
-				p->state = Particle::State::ALIVE;
+	// place particles spawned since we last rendered
+	if (instData->numPlaced < instData->numAlive) {
+		// get our global matrix
+		matrix4 global;
+		gs_matrix_get(&global);
+
+		for (int i = instData->numPlaced; i < instData->numAlive; i++) {
+			if (m_worldSpace) {
+				instData->positionX[i] = global.t.x;
+				instData->positionY[i] = global.t.y;
+				instData->positionZ[i] = global.t.z;
+				vec3 v;
+				vec3_set(&v, instData->velocityX[i],
+					instData->velocityY[i], instData->velocityZ[i]);
+				vec3_transform(&v, &v, &global);
+				instData->velocityX[i] = v.x;
+				instData->velocityY[i] = v.y;
+				instData->velocityZ[i] = v.z;
 			}
-			p->sortDrawPart = part;
-			m_parent->instanceDatas.Push(p->id);
-			m_parent->AddSortedDrawObject(p);
-			m_parent->instanceDatas.Pop();
 		}
+		instData->numPlaced = instData->numAlive;
 	}
 
+	// all our particles are drawn as one sorted draw object
+	sortDrawPart = part;
+	m_parent->AddSortedDrawObject(this);
+
 	m_parent->instanceDatas.Pop();
 }
 
+void Mask::Resource::Emitter::RenderFaces(Mask::Part* part,
+	const matrix4* faceTransforms, size_t count) {
+	// particles only need adding to the sorted list
+	// once, the sorted pass draws them for every face
+	IBase::RenderFaces(part, faceTransforms, count > 0 ? 1 : 0);
+}
+
 bool Mask::Resource::Emitter::IsDepthOnly() {
 	return false;
 }
@@ -351,51 +435,101 @@ bool Mask::Resource::Emitter::IsOpaque() {
 	return false;
 }
 
-
-
-float Mask::Resource::Particle::SortDepth() {
-	float z = position.z;
-	if (!emitter->m_worldSpace) {
+float Mask::Resource::Emitter::SortDepth() {
+	// the emitter sorts by the average depth of its particles
+	EmitterInstanceData* instData =
+		m_parent->instanceDatas.GetData(m_instanceCache);
+	float z = 0.0f;
+	for (int i = 0; i < instData->numPlaced; i++)
+		z += instData->positionZ[i];
+	if (instData->numPlaced > 0)
+		z /= (float)instData->numPlaced;
+	if (!m_worldSpace) {
 		matrix4 m;
 		gs_matrix_get(&m);
 		z += m.t.z;
 	}
 	// Z sorting offset. Useful for forcing particles in front of transparent objects.
-	z += emitter->m_zSortOffset;
+	z += m_zSortOffset;
 
 	return z;
 }
 
-void Mask::Resource::Particle::SortedRender() {
+void Mask::Resource::Emitter::SortedRender() {
+
+	EmitterInstanceData* instData =
+		m_parent->instanceDatas.GetData(m_instanceCache);
+	int count = instData->numPlaced;
+	if (count == 0)
+		return;
 
 	// global alpha
-	std::shared_ptr<AlphaInstanceData> aid =
-		emitter->GetParent()->instanceDatas.GetData<AlphaInstanceData>
+	AlphaInstanceData* aid =
+		m_parent->instanceDatas.GetData<AlphaInstanceData>
 		(AlphaInstanceDataId);
-
 	float saved_alpha = aid->alpha;
 
 	matrix4 m;
 	gs_matrix_get(&m);
-
-	gs_matrix_push();
-	gs_matrix_identity();
-
-	gs_matrix_translate(&position);
-	if (!emitter->m_worldSpace) {
-		gs_matrix_translate3f(m.t.x, m.t.y, m.t.z);
+	vec3 offset;
+	vec3_zero(&offset);
+	if (!m_worldSpace)
+		vec3_set(&offset, m.t.x, m.t.y, m.t.z);
+
+	// back to front
+	m_drawOrder.resize(count);
+	for (int i = 0; i < count; i++)
+		m_drawOrder[i] = i;
+	const float* pz = instData->positionZ.data();
+	std::sort(m_drawOrder.begin(), m_drawOrder.end(),
+		[pz](int a, int b) { return pz[a] < pz[b]; });
+
+	// transforms and alphas
+	// - the particle is flipped 180 degrees around x, then z, which
+	//   is just negating x and z
+	m_drawTransforms.resize(count);
+	m_drawAlphas.resize(count);
+	for (int i = 0; i < count; i++) {
+		int p = m_drawOrder[i];
+		float lambda = instData->age[p] / m_lifetime;
+		float s = lambda * (m_scaleEnd - m_scaleStart) + m_scaleStart;
+
+		matrix4& w = m_drawTransforms[i];
+		vec4_set(&w.x, -s, 0.0f, 0.0f, 0.0f);
+		vec4_set(&w.y, 0.0f, s, 0.0f, 0.0f);
+		vec4_set(&w.z, 0.0f, 0.0f, -s, 0.0f);
+		vec4_set(&w.t, instData->positionX[p] + offset.x,
+			instData->positionY[p] + offset.y,
+			instData->positionZ[p] + offset.z, 1.0f);
+
+		float alpha = lambda * (m_alphaEnd - m_alphaStart) + m_alphaStart;
+		m_drawAlphas[i] = alpha * saved_alpha;
+	}
+
+	if (m_model->GetMaterial()->HasSequences()) {
+		// sequences play per particle, so each needs its own Loop
+		gs_matrix_push();
+		for (int i = 0; i < count; i++) {
+			m_parent->instanceDatas.Push(instData->ids[m_drawOrder[i]]);
+			gs_matrix_set(&m_drawTransforms[i]);
+			aid->alpha = m_drawAlphas[i];
+			m_model->DirectRender(sortDrawPart);
+			m_parent->instanceDatas.Pop();
+		}
+		gs_matrix_pop();
+	}
+	else {
+		// otherwise they all share one Loop
+		m_parent->instanceDatas.Push(instData->ids[m_drawOrder[0]]);
+		aid->alpha = m_drawAlphas[0];
+		m_model->DirectRenderInstances(sortDrawPart,
+			m_drawTransforms.data(), m_drawAlphas.data(), count);
+		m_parent->instanceDatas.Pop();
 	}
-	gs_matrix_rotaa4f(1.0f, 0.0f, 0.0f, M_PI);
-	gs_matrix_rotaa4f(0.0f, 0.0f, 1.0f, M_PI);
-
-	float lambda = elapsed / emitter->m_lifetime;
-	float s = lambda * (emitter->m_scaleEnd - emitter->m_scaleStart) + emitter->m_scaleStart;
-	gs_matrix_scale3f(s, s, s);
-	aid->alpha = lambda * (emitter->m_alphaEnd - emitter->m_alphaStart) + emitter->m_alphaStart;
-	aid->alpha *= saved_alpha;
-
-	emitter->m_model->DirectRender(sortDrawPart);
 
-	gs_matrix_pop();
 	aid->alpha = saved_alpha;
 }
+
+size_t Mask::Resource::Emitter::SortMaterialId() {
+	return m_model->GetMaterial()->GetId();
+}
@@ -27,77 +27,97 @@ extern "C" {
 	#pragma warning( pop )
 }
 #include <time.h>
+#include <vector>
+#include <algorithm>
 
 namespace Mask {
 	namespace Resource {
 
-		class Emitter;
-
-		class Particle : public SortedDrawObject {
-		public:
-			enum State : uint8_t {
-				DEAD,
-				SPAWNED,
-				ALIVE,
-				NUM_STATES
-			};
-
-			std::size_t		id;
-			vec3			position;
-			vec3			velocity;
-			Emitter*		emitter;
-			float			elapsed;
-			State			state;
-
-			Particle* next;
-
-			Particle() : state(DEAD), emitter(nullptr) {}
-
-			virtual float	SortDepth() override;
-			virtual void	SortedRender() override;
-		};
-
+		// EmitterInstanceData
+		// - particles are kept as structure of arrays, so the update
+		//   can step four of them at a time
+		// - live particles are packed at the front. Spawned particles
+		//   are only placed when we next render, they sit at the end
+		//   of the live ones until then: [0, numPlaced) are placed,
+		//   [numPlaced, numAlive) are waiting
+		// - killing a particle swaps the last live one into its slot,
+		//   so spawning never has to look for a free one
 		struct EmitterInstanceData : public InstanceData {
-			Particle*	particles;
+			std::vector<float>			positionX, positionY, positionZ;
+			std::vector<float>			velocityX, velocityY, velocityZ;
+			std::vector<float>			age;
+			std::vector<std::size_t>	ids;
 			int			numParticles;
+			int			numAlive;
+			int			numPlaced;
 			float		elapsed;
 			float		delta_time;
+			uint32_t	rng[4];
 
-			EmitterInstanceData() : particles(nullptr), 
-				numParticles(0), elapsed(0.0f), delta_time(0.0f) {}
+			EmitterInstanceData() : numParticles(0), numAlive(0), numPlaced(0),
+				elapsed(0.0f), delta_time(0.0f) {
+				rng[0] = rng[1] = rng[2] = rng[3] = 1;
+			}
 
-			inline void Init(int num_particles, Emitter* e) {
-				numParticles = num_particles;
+			inline void Init(int num_particles, uint32_t seed) {
 				// only init once
-				if (particles != nullptr)
+				if (!ids.empty())
 					return;
-				particles = new Particle[numParticles];
-				Particle* p = particles;
+				numParticles = num_particles;
+				positionX.resize(numParticles);
+				positionY.resize(numParticles);
+				positionZ.resize(numParticles);
+				velocityX.resize(numParticles);
+				velocityY.resize(numParticles);
+				velocityZ.resize(numParticles);
+				age.resize(numParticles);
+				ids.resize(numParticles);
 				std::hash<int> hasher;
-				for (int i = 0; i < numParticles; i++,p++) {
-					p->id = hasher(i);
-					p->emitter = e;
+				for (int i = 0; i < numParticles; i++) {
+					ids[i] = hasher(i);
+				}
+				// xorshift lanes, must never be zero
+				for (int i = 0; i < 4; i++) {
+					seed = seed * 1664525 + 1013904223;
+					rng[i] = seed ? seed : 1;
 				}
 			}
 
-			void Reset() override {
-				elapsed = 0.0f;
-				if (particles == nullptr)
+			// index of a new particle, or -1 if we're full
+			inline int Spawn() {
+				if (numAlive >= numParticles)
+					return -1;
+				return numAlive++;
+			}
+
+			inline void Kill(int i) {
+				// keep both the placed and waiting ranges packed
+				Swap(i, --numPlaced);
+				Swap(numPlaced, --numAlive);
+			}
+
+			inline void Swap(int a, int b) {
+				if (a == b)
 					return;
-				Particle* p = particles;
-				for (int i = 0; i < numParticles; i++, p++) {
-					p->state = Particle::DEAD;
-				}
+				std::swap(positionX[a], positionX[b]);
+				std::swap(positionY[a], positionY[b]);
+				std::swap(positionZ[a], positionZ[b]);
+				std::swap(velocityX[a], velocityX[b]);
+				std::swap(velocityY[a], velocityY[b]);
+				std::swap(velocityZ[a], velocityZ[b]);
+				std::swap(age[a], age[b]);
+				// ids go with the particle, so its model instance does too
+				std::swap(ids[a], ids[b]);
 			}
 
-			~EmitterInstanceData() {
-				if (particles) {
-					delete[] particles;
-				}
+			void Reset() override {
+				elapsed = 0.0f;
+				numAlive = 0;
+				numPlaced = 0;
 			}
 		};
 
-		class Emitter : public IBase {
+		class Emitter : public IBase, public SortedDrawObject {
 		public:
 			Emitter(Mask::MaskData* parent, std::string name, obs_data_t* data);
 			virtual ~Emitter();
@@ -105,8 +125,14 @@ namespace Mask {
 			virtual Type GetType() override;
 			virtual void Update(Mask::Part* part, float time) override;
 			virtual void Render(Mask::Part* part) override;
+			virtual void RenderFaces(Mask::Part* part,
+				const matrix4* faceTransforms, size_t count) override;
 			virtual bool IsDepthOnly() override;
-			
+
+			virtual float	SortDepth() override;
+			virtual void	SortedRender() override;
+			virtual size_t	SortMaterialId() override;
+
 			bool IsOpaque();
 
 		private:
@@ -134,9 +160,6 @@ namespace Mask {
 			const char* const S_Z_SORT_OFFSET = "z-sort-offset";
 
 		protected:
-			// allow Particle class to access protected vars
-			friend class Particle;
-
 			float		m_rateMin, m_rateMax;
 			float		m_lifetime;
 			float		m_frictionMin, m_frictionMax;
@@ -149,8 +172,15 @@ namespace Mask {
 			bool		m_worldSpace;
 			bool		m_inverseRate;
 			std::shared_ptr<Model> m_model;
+			InstanceDataCache<EmitterInstanceData> m_instanceCache;
+
+			// draw lists, back to front
+			std::vector<int>		m_drawOrder;
+			std::vector<matrix4>	m_drawTransforms;
+			std::vector<float>		m_drawAlphas;
 
-			static	float RandFloat(float min, float max);
+			void	Integrate(EmitterInstanceData* instData, float time);
+			static	float RandFloat(uint32_t& state, float min, float max);
 		};
 	}
 }
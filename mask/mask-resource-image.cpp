@@ -54,7 +54,7 @@ Mask::Resource::Image::Image(Mask::MaskData* parent, std::string name, obs_data_
 		}
 
 		// save for later
-		m_tempFile = Utils::Base64ToTempFile(base64data);
+		m_parent->GetBlob(name, S_DATA, base64data, m_encoded);
 	}
 
 	// RAW DATA?
@@ -106,9 +106,8 @@ Mask::Resource::Image::Image(Mask::MaskData* parent, std::string name, obs_data_
 				PLOG_ERROR("Image '%s' has empty data.", name.c_str());
 				throw std::logic_error("Image has empty data.");
 			}
-			std::vector<uint8_t> decoded;
-			base64_decodeZ(base64data, decoded);
-			m_decoded_mips.emplace_back(decoded);
+			Blob decoded;
+			m_parent->GetBlob(name, mipdat, base64data, decoded);
 			if (decoded.size() != (w * h * bpp)) {
 				size_t ds = decoded.size();
 
@@ -116,6 +115,7 @@ Mask::Resource::Image::Image(Mask::MaskData* parent, std::string name, obs_data_
 					name.c_str(), (w*h*bpp), ds);
 				throw std::logic_error("Image size doesnt add up.");
 			}
+			m_decoded_mips.emplace_back(std::move(decoded));
 			w /= 2;
 			h /= 2;
 		}
@@ -183,9 +183,8 @@ Mask::Resource::Image::Image(Mask::MaskData* parent, std::string name, obs_data_
 					PLOG_ERROR("Image '%s' has empty data.", name.c_str());
 					throw std::logic_error("Image has empty data.");
 				}
-				std::vector<uint8_t> decoded;
-				base64_decodeZ(base64data, decoded);
-				m_decoded_mips.emplace_back(decoded);
+				Blob decoded;
+				m_parent->GetBlob(name, side_mipdat, base64data, decoded);
 				if (decoded.size() != (w * h * bpp * fmt_size)) {
 					size_t ds = decoded.size();
 
@@ -193,6 +192,7 @@ Mask::Resource::Image::Image(Mask::MaskData* parent, std::string name, obs_data_
 						name.c_str(), (w*h*bpp), ds);
 					throw std::logic_error("Image size doesnt add up.");
 				}
+				m_decoded_mips.emplace_back(std::move(decoded));
 				w /= 2;
 				h /= 2;
 			}
@@ -204,11 +204,10 @@ Mask::Resource::Image::Image(Mask::MaskData* parent, std::string name, obs_data_
 	}
 
 
-	// temp file?
-	if (m_tempFile.length() > 0) {
-		m_Texture = std::make_shared<GS::Texture>(m_tempFile, m_cache);
-		Utils::DeleteTempFile(m_tempFile);
-		m_tempFile.clear();
+	// encoded image?
+	if (!m_encoded.empty()) {
+		m_Texture = std::make_shared<GS::Texture>(m_encoded.data(), m_encoded.size(), m_cache);
+		m_encoded.Clear();
 	}
 	else {
 		if (m_is_cubemap) {
@@ -255,11 +254,10 @@ void Mask::Resource::Image::Render(Mask::Part* part) {
 	UNUSED_PARAMETER(part);
 	if (m_Texture == nullptr) {
 
-		// temp file?
-		if (m_tempFile.length() > 0) {
-			m_Texture = std::make_shared<GS::Texture>(m_tempFile, m_cache);
-			Utils::DeleteTempFile(m_tempFile);
-			m_tempFile.clear();
+		// encoded image?
+		if (!m_encoded.empty()) {
+			m_Texture = std::make_shared<GS::Texture>(m_encoded.data(), m_encoded.size(), m_cache);
+			m_encoded.Clear();
 		}
 		else {
 			if (m_is_cubemap) {
@@ -73,8 +73,8 @@ namespace Mask {
 			int				m_width, m_height;
 			int				m_mipLevels;
 			gs_color_format m_fmt;
-			std::string		m_tempFile;
-			std::vector<std::vector<uint8_t>> m_decoded_mips;
+			Blob			m_encoded;
+			std::vector<Blob>	m_decoded_mips;
 		};
 	}
 }
@@ -144,8 +144,8 @@ void Mask::Resource::Light::Update(Mask::Part* part, float time) {
 
 	// get our instance data
 	// NOTE: lights are global; not instanced
-	std::shared_ptr<LightInstanceData> instData =
-		m_parent->instanceDatas.GetData<LightInstanceData>(m_id);
+	LightInstanceData* instData =
+		m_parent->instanceDatas.GetData(m_id, m_instanceCache);
 	if (instData->lightType == UNDEFINED) {
 		// initialize light data
 		*instData = m_idat;
@@ -89,6 +89,7 @@ namespace Mask {
 
 		protected:
 			LightInstanceData m_idat;
+			InstanceDataCache<LightInstanceData> m_instanceCache;
 
 			LightType GetLightType(obs_data_t* data);
 		};
@@ -55,6 +55,7 @@ static const char* const PARAM_WORLD = "World";
 static const char* const PARAM_TEXMAT = "TexMat";
 static const char* const PARAM_ALPHA = "alpha";
 static const char* const PARAM_NUMBONES = "numBones";
+static const char* const PARAM_BONES = "bones";
 static const char* const PARAM_NUMLIGHTS = "numLights";
 
 static const char* const PARAM_NUM_RENDER_LAYERS = "numRenderLayers";
@@ -64,7 +65,10 @@ static const char* const PARAM_RENDER_LAYER = "renderLayer";
 
 Mask::Resource::Material::Material(Mask::MaskData* parent, std::string name, obs_data_t* data)
 	: IBase(parent, name), m_effect(nullptr), m_looping(false), m_currentTechnique(nullptr),
-	m_samplerState(nullptr), m_depthOnly(false), m_static(false), m_opaque(true), m_alphaWrite(true), m_rotationDisable(false) {
+	m_samplerState(nullptr), m_depthOnly(false), m_static(false), m_opaque(true), m_alphaWrite(true), m_rotationDisable(false), m_hasSequences(false),
+	m_boundEffect(nullptr), m_worldParam(nullptr), m_texMatParam(nullptr), m_alphaParam(nullptr),
+	m_numBonesParam(nullptr), m_bonesParam(nullptr), m_numLightsParam(nullptr), m_numRenderLayersParam(nullptr),
+	m_renderLayerParam(nullptr), m_videoLightingParam(nullptr), m_emptyTexture(nullptr) {
 
 	std::hash<std::string> hasher;
 	char temp[64];
@@ -321,8 +325,11 @@ Mask::Resource::Material::Material(Mask::MaskData* parent, std::string name, obs
 	}
 
 	std::vector<std::string> active_textures;
+	m_hasSequences = false;
 	for (const auto &e : m_imageParameters) {
 		active_textures.push_back(e.first);
+		if (e.second->GetType() == Type::Sequence)
+			m_hasSequences = true;
 	}
 
 	if (m_effect->GetName() == S_PBR_EFFECT) {
@@ -368,6 +375,73 @@ void Mask::Resource::Material::Render(Mask::Part* part) {
 	return;
 }
 
+void Mask::Resource::Material::BindParameters(gs_effect_t* eff) {
+	m_boundEffect = eff;
+
+	// our parameters, only those the effect has with a matching type
+	m_boundParameters.clear();
+	for (const auto& kv : m_parameters) {
+		gs_eparam_t* param = gs_effect_get_param_by_name(eff, kv.first.c_str());
+		if (!param)
+			continue;
+		GS::EffectParameter el(param);
+		if (el.GetType() != kv.second.type)
+			continue;
+		m_boundParameters.push_back({ el, &kv.second });
+	}
+
+	// image params (image/sequence), or the empty texture
+	m_parent->GetCache()->load_permanent("empty_texture", (void**)&m_emptyTexture);
+	m_boundTextures.clear();
+	for (const auto& tex_type_ent : Mask::Resource::Effect::g_textureTypes) {
+		gs_eparam_t* param = gs_effect_get_param_by_name(eff, tex_type_ent.first.c_str());
+		if (!param)
+			continue;
+		auto kv = m_imageParameters.find(tex_type_ent.first);
+		if (kv != m_imageParameters.end()) {
+			if (GS::EffectParameter(param).GetType() == GS::EffectParameter::Type::Texture &&
+				(kv->second->GetType() == Type::Image ||
+				kv->second->GetType() == Type::Sequence))
+				m_boundTextures.push_back({ param, kv->second.get() });
+		}
+		else {
+			m_boundTextures.push_back({ param, nullptr });
+		}
+	}
+
+	m_worldParam = gs_effect_get_param_by_name(eff, PARAM_WORLD);
+	m_texMatParam = gs_effect_get_param_by_name(eff, PARAM_TEXMAT);
+	m_alphaParam = gs_effect_get_param_by_name(eff, PARAM_ALPHA);
+	m_numBonesParam = gs_effect_get_param_by_name(eff, PARAM_NUMBONES);
+	m_bonesParam = gs_effect_get_param_by_name(eff, PARAM_BONES);
+	m_numLightsParam = gs_effect_get_param_by_name(eff, PARAM_NUMLIGHTS);
+	m_numRenderLayersParam = gs_effect_get_param_by_name(eff, PARAM_NUM_RENDER_LAYERS);
+	m_renderLayerParam = gs_effect_get_param_by_name(eff, PARAM_RENDER_LAYER);
+	m_videoLightingParam = gs_effect_get_param_by_name(eff, PARAM_VIDEO_LIGHTING_TEX);
+
+	// lights
+	char temp[64];
+	for (int i = 0; i < (int)m_lightParams.size(); i++) {
+		LightParameters& lp = m_lightParams[i];
+		snprintf(temp, sizeof(temp), "light%dType", i);
+		lp.type = gs_effect_get_param_by_name(eff, temp);
+		snprintf(temp, sizeof(temp), "light%dPosition", i);
+		lp.position = gs_effect_get_param_by_name(eff, temp);
+		snprintf(temp, sizeof(temp), "light%dDirection", i);
+		lp.direction = gs_effect_get_param_by_name(eff, temp);
+		snprintf(temp, sizeof(temp), "light%dAttenuation", i);
+		lp.attenuation = gs_effect_get_param_by_name(eff, temp);
+		snprintf(temp, sizeof(temp), "light%dAmbient", i);
+		lp.ambient = gs_effect_get_param_by_name(eff, temp);
+		snprintf(temp, sizeof(temp), "light%dDiffuse", i);
+		lp.diffuse = gs_effect_get_param_by_name(eff, temp);
+		snprintf(temp, sizeof(temp), "light%dSpecular", i);
+		lp.specular = gs_effect_get_param_by_name(eff, temp);
+		snprintf(temp, sizeof(temp), "light%dAngle", i);
+		lp.angle = gs_effect_get_param_by_name(eff, temp);
+	}
+}
+
 bool Mask::Resource::Material::Loop(Mask::Part* part, BonesList* bones) {
 
 	m_parent->instanceDatas.Push(m_id);
@@ -375,60 +449,59 @@ bool Mask::Resource::Material::Loop(Mask::Part* part, BonesList* bones) {
 
 		m_effect->Render(part);
 
+		// get the effect object
+		gs_effect_t* eff = m_effect->GetEffect()->GetObject();
+		if (eff != m_boundEffect)
+			BindParameters(eff);
+
 		// Apply Parameters
-		for (auto kv : m_parameters) {
-			try {
-				auto el = m_effect->GetEffect()->GetParameterByName(kv.first);
-
-				switch (kv.second.type) {
-				case GS::EffectParameter::Type::Float:
-					el.SetFloat(kv.second.floatValue);
-					break;
-				case GS::EffectParameter::Type::Float2:
-					el.SetFloat2(kv.second.floatArray[0],
-						kv.second.floatArray[1]);
-					break;
-				case GS::EffectParameter::Type::Float3:
-					el.SetFloat3(kv.second.floatArray[0],
-						kv.second.floatArray[1],
-						kv.second.floatArray[2]);
-					break;
-				case GS::EffectParameter::Type::Float4:
-					el.SetFloat4(kv.second.floatArray[0],
-						kv.second.floatArray[1], 
-						kv.second.floatArray[2], 
-						kv.second.floatArray[3]);
-					break;
-				case GS::EffectParameter::Type::Integer:
-					el.SetInteger(kv.second.intValue);
-					break;
-				case GS::EffectParameter::Type::Integer2:
-					el.SetInteger2(kv.second.intArray[0],
-						kv.second.intArray[1]);
-					break;
-				case GS::EffectParameter::Type::Integer3:
-					el.SetInteger3(kv.second.intArray[0],
-						kv.second.intArray[1], 
-						kv.second.intArray[2]);
-					break;
-				case GS::EffectParameter::Type::Integer4:
-					el.SetInteger4(kv.second.intArray[0],
-						kv.second.intArray[1],
-						kv.second.intArray[2],
-						kv.second.intArray[3]);
-					break;
-				case GS::EffectParameter::Type::Matrix:
-					el.SetMatrix(kv.second.matrix);
-					break;
-				}
+		for (BoundParameter& bp : m_boundParameters) {
+			const Parameter& value = *bp.value;
+			switch (value.type) {
+			case GS::EffectParameter::Type::Float:
+				bp.param.SetFloat(value.floatValue);
+				break;
+			case GS::EffectParameter::Type::Float2:
+				bp.param.SetFloat2(value.floatArray[0],
+					value.floatArray[1]);
+				break;
+			case GS::EffectParameter::Type::Float3:
+				bp.param.SetFloat3(value.floatArray[0],
+					value.floatArray[1],
+					value.floatArray[2]);
+				break;
+			case GS::EffectParameter::Type::Float4:
+				bp.param.SetFloat4(value.floatArray[0],
+					value.floatArray[1], 
+					value.floatArray[2], 
+					value.floatArray[3]);
+				break;
+			case GS::EffectParameter::Type::Integer:
+				bp.param.SetInteger(value.intValue);
+				break;
+			case GS::EffectParameter::Type::Integer2:
+				bp.param.SetInteger2(value.intArray[0],
+					value.intArray[1]);
+				break;
+			case GS::EffectParameter::Type::Integer3:
+				bp.param.SetInteger3(value.intArray[0],
+					value.intArray[1], 
+					value.intArray[2]);
+				break;
+			case GS::EffectParameter::Type::Integer4:
+				bp.param.SetInteger4(value.intArray[0],
+					value.intArray[1],
+					value.intArray[2],
+					value.intArray[3]);
+				break;
+			case GS::EffectParameter::Type::Matrix: {
+				matrix4 m = value.matrix;
+				bp.param.SetMatrix(m);
+				break;
 			}
-			catch (...) {
 			}
 		}
 
-		// get the effect object
-		gs_effect_t* eff = m_effect->GetEffect()->GetObject();
-
 		// Set up the sampler state
 		// TODO: move this to gs::effectparameter?
 		if (!m_samplerState) {
@@ -448,91 +521,56 @@ bool Mask::Resource::Material::Loop(Mask::Part* part, BonesList* bones) {
 		gs_set_cull_mode(m_culling);
 
 		// set up image params (image/sequence)
-		bool texmatset = false;
 		bool is_instance_visible = true;
-		for (auto tex_type_ent : Mask::Resource::Effect::g_textureTypes) {
-			try {
-				auto kv = m_imageParameters.find(tex_type_ent.first);
-				if (m_imageParameters.find(tex_type_ent.first) != m_imageParameters.end())
-				{
-					auto el = m_effect->GetEffect()->GetParameterByName(kv->first);
-					if (kv->second->GetType() == Type::Image) {
-						std::shared_ptr<Image> img = std::dynamic_pointer_cast<Image>(kv->second);
-						img->Render(part);
-						el.SetTexture(img->GetTexture());
-						el.SetSampler(m_samplerState);
-					}
-					else if (kv->second->GetType() == Type::Sequence) {
-						std::shared_ptr<Sequence> seq = std::dynamic_pointer_cast<Sequence>(kv->second);
-						seq->Render(part);
-						std::shared_ptr<Image> img = seq->GetImage();
-						el.SetTexture(img->GetTexture());
-						el.SetSampler(m_samplerState);
-
-						// set up texture matrix
-						// NOTE: there is no gs_effect_set_matrix3. bummer.
-						// - might be better as translate/scale/rot (vec2/vec2/float)
-						matrix4 texmat;
-						seq->SetTextureMatrix(part, &texmat);
-						gs_eparam_t* effparm = gs_effect_get_param_by_name(eff, PARAM_TEXMAT);
-						texmatset = true;
-						if (effparm)
-							gs_effect_set_matrix4(effparm, &texmat);
-
-						// should we delay rendering?
-						is_instance_visible = seq->IsInstancePlaying();
-					}
-				}
-				else
-				{
-					gs_eparam_t* param = gs_effect_get_param_by_name(m_effect->GetEffect()->GetObject(), tex_type_ent.first.c_str());
-					gs_texture_t *tex = nullptr;
-					m_parent->GetCache()->load_permanent("empty_texture", (void**)&tex);
-					if (param && tex)
-					{
-						gs_effect_set_texture(param, tex);
-						gs_effect_set_next_sampler(param, m_samplerState);
-					}
-				}
-
+		for (BoundTexture& bt : m_boundTextures) {
+			gs_texture_t* tex = m_emptyTexture;
+			if (bt.resource && bt.resource->GetType() == Type::Image) {
+				Image* img = static_cast<Image*>(bt.resource);
+				img->Render(part);
+				tex = img->GetTexture()->GetObject();
+			}
+			else if (bt.resource) {
+				Sequence* seq = static_cast<Sequence*>(bt.resource);
+				seq->Render(part);
+				tex = seq->GetImage()->GetTexture()->GetObject();
+
+				// set up texture matrix
+				// NOTE: there is no gs_effect_set_matrix3. bummer.
+				// - might be better as translate/scale/rot (vec2/vec2/float)
+				matrix4 texmat;
+				seq->SetTextureMatrix(part, &texmat);
+				if (m_texMatParam)
+					gs_effect_set_matrix4(m_texMatParam, &texmat);
+
+				// should we delay rendering?
+				is_instance_visible = seq->IsInstancePlaying();
 			}
-			catch (...) {
+			if (tex) {
+				gs_effect_set_texture(bt.param, tex);
+				gs_effect_set_next_sampler(bt.param, m_samplerState);
 			}
 		}
 
 		// attach video texture
-		gs_eparam_t* param = gs_effect_get_param_by_name(m_effect->GetEffect()->GetObject(), PARAM_VIDEO_LIGHTING_TEX);
 		gs_texture_t *tex = nullptr;
 		if (m_use_video_lighting)
 			tex = m_parent->GetVideoLightingTexture();
 		else
-			m_parent->GetCache()->load_permanent("empty_texture", (void**)&tex);
-		if (param && tex)
+			tex = m_emptyTexture;
+		if (m_videoLightingParam && tex)
 		{
-			gs_effect_set_texture(param, tex);
-			gs_effect_set_next_sampler(param, m_samplerState);
+			gs_effect_set_texture(m_videoLightingParam, tex);
+			gs_effect_set_next_sampler(m_videoLightingParam, m_samplerState);
 		}
 
 		// attach render layer params from the model resource and mask data
-		if (part != nullptr && part->resources.size() > 0) {
-			gs_eparam_t* param_num_layers = gs_effect_get_param_by_name(eff, PARAM_NUM_RENDER_LAYERS);
-			gs_eparam_t* param_layer = gs_effect_get_param_by_name(eff, PARAM_RENDER_LAYER);
-			std::shared_ptr<SortedDrawObject> model = std::dynamic_pointer_cast<SortedDrawObject>(part->resources[0]);
-			if (param_num_layers && param_layer)
-			{
-				if (model)
-				{
-					gs_effect_set_int(param_num_layers, m_parent->GetNumRenderLayers());
-					gs_effect_set_int(param_layer, model->m_render_layer);
-				}
-				else
-				{
-					// use default render layer for model types that don't have
-					// SortedDrawObject interface, like emitter
-					gs_effect_set_int(param_num_layers, m_parent->GetNumRenderLayers());
-					gs_effect_set_int(param_layer, 0);
-				}
-			}
+		if (part != nullptr && part->resources.size() > 0 &&
+			m_numRenderLayersParam && m_renderLayerParam) {
+			SortedDrawObject* model = dynamic_cast<SortedDrawObject*>(part->resources[0].get());
+			gs_effect_set_int(m_numRenderLayersParam, m_parent->GetNumRenderLayers());
+			// use default render layer for model types that don't have
+			// SortedDrawObject interface, like emitter
+			gs_effect_set_int(m_renderLayerParam, model ? model->m_render_layer : 0);
 		}
 
 		// set params for lighting
@@ -542,17 +580,15 @@ bool Mask::Resource::Material::Loop(Mask::Part* part, BonesList* bones) {
 		SetSkinningParameters(bones);
 
 		// set global alpha
-		gs_eparam_t* effparm = gs_effect_get_param_by_name(eff, PARAM_ALPHA);
-		if (effparm) {
-			std::shared_ptr<AlphaInstanceData> aid =
+		if (m_alphaParam) {
+			AlphaInstanceData* aid =
 				m_parent->instanceDatas.GetData<AlphaInstanceData>
 				(AlphaInstanceDataId);
-			gs_effect_set_float(effparm, is_instance_visible ? aid->alpha : 0.0);
+			gs_effect_set_float(m_alphaParam, is_instance_visible ? aid->alpha : 0.0f);
 		}
 
 		// get the technique
-		m_currentTechnique = gs_effect_get_technique(m_effect->GetEffect()->GetObject(),
-			m_technique.c_str());
+		m_currentTechnique = gs_effect_get_technique(eff, m_technique.c_str());
 		if (!m_currentTechnique) {
 			m_parent->instanceDatas.Pop();
 			return false;
@@ -593,130 +629,106 @@ gs_address_mode Mask::Resource::Material::StringToAddressMode(std::string s) {
 	return GS_ADDRESS_CLAMP; 
 }
 
+bool Mask::Resource::Material::SetWorldMatrix() {
+	if (!m_worldParam)
+		return false;
+
+	// go obs. need to transpose matrices sent to shaders from gs.
+	matrix4 w;
+	gs_matrix_get(&w);
+	matrix4_transpose(&w, &w);
+	gs_effect_set_matrix4(m_worldParam, &w);
+	return true;
+}
+
+bool Mask::Resource::Material::SetAlpha(float alpha) {
+	if (!m_alphaParam)
+		return false;
+	gs_effect_set_float(m_alphaParam, alpha);
+	return true;
+}
+
 void Mask::Resource::Material::SetLightingParameters(Mask::Part* part) {
 	UNUSED_PARAMETER(part);
-	// get the effect object
-	gs_effect_t* eff = m_effect->GetEffect()->GetObject();
-	
-	gs_eparam_t* param;
 
 	// Set up world matrix for lighting 
-	param = gs_effect_get_param_by_name(eff, PARAM_WORLD);
-	if (param) {
-		// go obs. need to transpose matrices sent to shaders from gs.
-		matrix4 w;
-		gs_matrix_get(&w);
-		matrix4_transpose(&w, &w);
-		gs_effect_set_matrix4(param, &w);
-	}
-	else {
+	if (!SetWorldMatrix()) {
 		// No World matrix param - assume this effect doesn't support
 		// lighting
 		return;
 	}
 
-
 	// Look for light instance data
-	char temp[64];
 	int numLights = 0;
 	for (int i = 0; i < 8; i++) {
 
-		std::shared_ptr<LightInstanceData> lightData =
+		LightInstanceData* lightData =
 			m_parent->instanceDatas.FindDataDontCreate<LightInstanceData>(m_lightIds[i]);
 		if (!lightData)
 			break;
 
 		numLights++;
+		const LightParameters& lp = m_lightParams[i];
 
 		// light type
-		snprintf(temp, sizeof(temp), "light%dType", i);
-		param = gs_effect_get_param_by_name(eff, temp);
-		if (param)
-			gs_effect_set_int(param, (int)lightData->lightType);
+		if (lp.type)
+			gs_effect_set_int(lp.type, (int)lightData->lightType);
 		
 		// position
-		snprintf(temp, sizeof(temp), "light%dPosition", i);
-		param = gs_effect_get_param_by_name(eff, temp);
-		if (param)
-			gs_effect_set_vec3(param, &lightData->position);
+		if (lp.position)
+			gs_effect_set_vec3(lp.position, &lightData->position);
 
 		// direction
-		snprintf(temp, sizeof(temp), "light%dDirection", i);
-		param = gs_effect_get_param_by_name(eff, temp);
-		if (param)
-			gs_effect_set_vec3(param, &lightData->direction);
+		if (lp.direction)
+			gs_effect_set_vec3(lp.direction, &lightData->direction);
 
 		// attenuation
-		snprintf(temp, sizeof(temp), "light%dAttenuation", i);
-		param = gs_effect_get_param_by_name(eff, temp);
-		if (param) { 
+		if (lp.attenuation) { 
 			vec3 att;
 			vec3_set(&att, lightData->att0, lightData->att1, lightData->att2);
-			gs_effect_set_vec3(param, &att);
+			gs_effect_set_vec3(lp.attenuation, &att);
 		}
 		 
 		// ambient color
-		snprintf(temp, sizeof(temp), "light%dAmbient", i);
-		param = gs_effect_get_param_by_name(eff, temp);
-		if (param) 
-			gs_effect_set_vec3(param, &lightData->ambient);
+		if (lp.ambient) 
+			gs_effect_set_vec3(lp.ambient, &lightData->ambient);
 		
 		// diffuse color
-		snprintf(temp, sizeof(temp), "light%dDiffuse", i);
-		param = gs_effect_get_param_by_name(eff, temp);
-		if (param)
-			gs_effect_set_vec3(param, &lightData->diffuse);
+		if (lp.diffuse)
+			gs_effect_set_vec3(lp.diffuse, &lightData->diffuse);
 		
 		// specular color 
-		snprintf(temp, sizeof(temp), "light%dSpecular", i);
-		param = gs_effect_get_param_by_name(eff, temp);
-		if (param)
-			gs_effect_set_vec3(param, &lightData->specular); 
+		if (lp.specular)
+			gs_effect_set_vec3(lp.specular, &lightData->specular); 
 		 
 		// spot angle
-		snprintf(temp, sizeof(temp), "light%dAngle", i);
-		param = gs_effect_get_param_by_name(eff, temp);
-		if (param)
-			gs_effect_set_float(param, lightData->outerAngle / 2.0f);
+		if (lp.angle)
+			gs_effect_set_float(lp.angle, lightData->outerAngle / 2.0f);
 	} 
 
 	// num lights
-	if (numLights > 0) {
-		param = gs_effect_get_param_by_name(eff, PARAM_NUMLIGHTS);
-		if (param)
-			gs_effect_set_int(param, numLights);
-	}
+	if (numLights > 0 && m_numLightsParam)
+		gs_effect_set_int(m_numLightsParam, numLights);
 }
 
 
 void Mask::Resource::Material::SetSkinningParameters(
 	Mask::Resource::BonesList* bones) {
-	// get the effect object
-	gs_effect_t* eff = m_effect->GetEffect()->GetObject();
-	gs_eparam_t* param;
-
 	if (bones == nullptr || bones->numBones < 1) {
 		// numBones
-		param = gs_effect_get_param_by_name(eff, PARAM_NUMBONES);
-		if (param)
-			gs_effect_set_int(param, 0);
+		if (m_numBonesParam)
+			gs_effect_set_int(m_numBonesParam, 0);
 		return;
 	}
 
-	char temp[64];
 	int nb = bones->numBones;
 
 	// numBones
-	param = gs_effect_get_param_by_name(eff, PARAM_NUMBONES);
-	if (param)
-		gs_effect_set_int(param, nb);
-
-	// bone matrices
-	for (int i = 0; i < nb; i++) {
-		snprintf(temp, sizeof(temp), "bone%d", i);
-		param = gs_effect_get_param_by_name(eff, temp);
-		if (param) {
-			gs_effect_set_matrix4(param, bones->bones[i]);
-		}
-	}
+	if (m_numBonesParam)
+		gs_effect_set_int(m_numBonesParam, nb);
+
+	// bone matrices, the whole palette in one go
+	if (m_bonesParam)
+		gs_effect_set_val(m_bonesParam, bones->bones,
+			sizeof(matrix4) * MAX_BONES_PER_SKIN);
 }
@@ -40,6 +40,12 @@ namespace Mask {
 			virtual void Render(Mask::Part* part) override;
 
 			bool Loop(Mask::Part* part, BonesList* bones = nullptr);
+			// the world matrix is the only state that changes between
+			// faces drawn in one Loop, call after changing the transform
+			bool SetWorldMatrix();
+			// likewise for the global alpha, when instances drawn in one
+			// Loop fade separately
+			bool SetAlpha(float alpha);
 
 			bool IsDepthOnly() override { return m_depthOnly; }
 			bool IsStatic() override { return m_static; }
@@ -47,6 +53,9 @@ namespace Mask {
 			bool IsOpaque() { return m_opaque; }
 			bool WriteAlpha() { return m_alphaWrite; }
 			bool IsPBR();
+			// sequences animate per instance, so instances of materials
+			// with them can't share one Loop
+			bool HasSequences() { return m_hasSequences; }
 
 		private:
 			struct Parameter {
@@ -60,6 +69,44 @@ namespace Mask {
 				};
 			};
 
+			// Effect parameter handles
+			// - resolved once for the effect object we're bound to, so
+			//   drawing never looks anything up by name
+			struct BoundParameter {
+				GS::EffectParameter	param;
+				const Parameter*	value;
+			};
+			struct BoundTexture {
+				gs_eparam_t*	param;
+				IBase*			resource;	// nullptr for the empty texture
+			};
+			struct LightParameters {
+				gs_eparam_t* type;
+				gs_eparam_t* position;
+				gs_eparam_t* direction;
+				gs_eparam_t* attenuation;
+				gs_eparam_t* ambient;
+				gs_eparam_t* diffuse;
+				gs_eparam_t* specular;
+				gs_eparam_t* angle;
+			};
+			gs_effect_t*					m_boundEffect;
+			std::vector<BoundParameter>		m_boundParameters;
+			std::vector<BoundTexture>		m_boundTextures;
+			std::array<LightParameters, 8>	m_lightParams;
+			gs_eparam_t*					m_worldParam;
+			gs_eparam_t*					m_texMatParam;
+			gs_eparam_t*					m_alphaParam;
+			gs_eparam_t*					m_numBonesParam;
+			gs_eparam_t*					m_bonesParam;
+			gs_eparam_t*					m_numLightsParam;
+			gs_eparam_t*					m_numRenderLayersParam;
+			gs_eparam_t*					m_renderLayerParam;
+			gs_eparam_t*					m_videoLightingParam;
+			gs_texture_t*					m_emptyTexture;
+
+			void BindParameters(gs_effect_t* eff);
+
 		protected:
 			std::shared_ptr<Effect> m_effect;
 			std::string m_technique;
@@ -87,6 +134,7 @@ namespace Mask {
 			bool m_opaque;
 			bool m_alphaWrite;
 			bool m_use_video_lighting;
+			bool m_hasSequences;
 
 			gs_address_mode StringToAddressMode(std::string s);
 			void SetLightingParameters(Mask::Part* part);
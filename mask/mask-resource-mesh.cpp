@@ -26,7 +26,6 @@
 #include <iterator>
 #include <algorithm>
 #include <unordered_map>
-#include <tiny_obj_loader.h>
 #include <opencv2/opencv.hpp>
 #include "mask.h"
 #include "mask-resource-model.h"
@@ -47,9 +46,10 @@ static const char* const S_INDEX_BUFFER = "index-buffer";
 static const char* const S_CENTER = "center";
 
 Mask::Resource::Mesh::Mesh(Mask::MaskData* parent, std::string name, obs_data_t* data)
-	: IBase(parent, name), m_part(nullptr) {
+	: IBase(parent, name), m_part(nullptr), m_numIndices(0) {
 
 	// We could be an embedded OBJ file, or raw geometry
+	Blob vertexBlob, indexBlob, objBlob;
 
 	// Raw geometry?
 	if (obs_data_has_user_value(data, S_VERTEX_BUFFER)) {
@@ -59,12 +59,6 @@ Mask::Resource::Mesh::Mesh(Mask::MaskData* parent, std::string name, obs_data_t*
 			PLOG_ERROR("Mesh '%s' has empty vertex data.", name.c_str());
 			throw std::logic_error("Mesh has empty vertex data.");
 		}
-		std::vector<uint8_t> decodedVertices;
-		base64_decode(vertex64data, decodedVertices);
-		// add extra to buffer size to allow for alignment
-		size_t vertBuffSize = zlib_size(decodedVertices) + 16;
-		m_rawVertices = new uint8_t[vertBuffSize];
-		zlib_decode(decodedVertices, (uint8_t*)ALIGN_16(m_rawVertices));
 
 		// Index Buffer
 		if (!obs_data_has_user_value(data, S_INDEX_BUFFER)) {
@@ -76,13 +70,11 @@ Mask::Resource::Mesh::Mesh(Mask::MaskData* parent, std::string name, obs_data_t*
 			PLOG_ERROR("Mesh '%s' has empty index buffer data.", name.c_str());
 			throw std::logic_error("Mesh has empty index buffer data.");
 		}
-		std::vector<uint8_t> decodedIndices;
-		base64_decode(index64data, decodedIndices);
-		size_t idxBuffSize = zlib_size(decodedIndices);
-		m_numIndices = (int)(idxBuffSize / sizeof(uint32_t));
-		// add extra to buffer size to allow for alignment
-		m_rawIndices = new uint8_t[idxBuffSize + 16];
-		zlib_decode(decodedIndices, (uint8_t*)ALIGN_16(m_rawIndices));
+
+		// already decoded if we are a package, or were predecoded
+		m_parent->GetBlob(name, S_VERTEX_BUFFER, vertex64data, vertexBlob);
+		m_parent->GetBlob(name, S_INDEX_BUFFER, index64data, indexBlob);
+		m_numIndices = (int)(indexBlob.size() / sizeof(uint32_t));
 	}
 	
 	// OBJ data?
@@ -96,7 +88,7 @@ Mask::Resource::Mesh::Mesh(Mask::MaskData* parent, std::string name, obs_data_t*
 			PLOG_ERROR("Mesh '%s' has empty data.", name.c_str());
 			throw std::logic_error("Mesh has empty data.");
 		}
-		m_tempFile = Utils::Base64ToTempFile(base64data);
+		m_parent->GetBlob(name, S_DATA, base64data, objBlob);
 	}
 
 	// center?
@@ -108,14 +100,16 @@ Mask::Resource::Mesh::Mesh(Mask::MaskData* parent, std::string name, obs_data_t*
 	vec4_set(&m_center, center.x, center.y, center.z, 1.0f);
 
 	// create GS resources
-	if (m_tempFile.length() > 0) {
-		LoadObj(m_tempFile);
-		Utils::DeleteTempFile(m_tempFile);
-		m_tempFile.clear();
+	if (!objBlob.empty()) {
+		LoadObj(objBlob.data(), objBlob.size());
 	}
 	else {
-		m_VertexBuffer = std::make_shared<GS::VertexBuffer>(m_rawVertices);
-		m_IndexBuffer = std::make_shared<GS::IndexBuffer>(m_rawIndices, m_numIndices);
+		// the index buffer gets handed over to libobs, so it needs its
+		// own copy
+		m_VertexBuffer = std::make_shared<GS::VertexBuffer>(vertexBlob.data(), vertexBlob.size());
+		uint32_t* indices = (uint32_t*)bmalloc(sizeof(uint32_t) * m_numIndices);
+		memcpy(indices, indexBlob.data(), sizeof(uint32_t) * m_numIndices);
+		m_IndexBuffer = std::make_shared<GS::IndexBuffer>(indices, m_numIndices);
 	}
 } 
 
@@ -163,16 +157,44 @@ void Mask::Resource::Mesh::LoadObj(std::string file) {
 		blog(LOG_ERROR, err.c_str());
 		return;
 	}
+	MakeObjBuffers(attrib, shapes);
+}
+
+// read only stream buffer over memory we don't own
+class MemoryStreamBuffer : public std::streambuf {
+public:
+	MemoryStreamBuffer(const uint8_t* data, size_t size) {
+		char* p = (char*)data;
+		setg(p, p, p + size);
+	}
+};
+
+void Mask::Resource::Mesh::LoadObj(const uint8_t* data, size_t size) {
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+	tinyobj::attrib_t attrib;
+	std::string err;
+	MemoryStreamBuffer buffer(data, size);
+	std::istream stream(&buffer);
+	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, &stream)) {
+		blog(LOG_ERROR, "Unable to load OBJ data for mesh: %s", m_name.c_str());
+		blog(LOG_ERROR, err.c_str());
+		return;
+	}
+	MakeObjBuffers(attrib, shapes);
+}
 
+void Mask::Resource::Mesh::MakeObjBuffers(const tinyobj::attrib_t& attrib,
+	const std::vector<tinyobj::shape_t>& shapes) {
 	// Create GPU mesh from tinyobj format.
 	char keybuff[128];
 	std::vector<GS::Vertex> vertices;
 	std::vector<std::string> vertexKeys;
 	std::vector<uint32_t> indices;
 	for (size_t i = 0; i < shapes.size(); i++) {
-		tinyobj::shape_t& shape = shapes[i];
+		const tinyobj::shape_t& shape = shapes[i];
 		for (size_t j = 0; j < shape.mesh.indices.size(); j++) {
-			tinyobj::index_t& index = shape.mesh.indices[j];
+			const tinyobj::index_t& index = shape.mesh.indices[j];
 
 			snprintf(keybuff, sizeof(keybuff), "%d-%d-%d", index.vertex_index, index.normal_index,
 				index.texcoord_index);
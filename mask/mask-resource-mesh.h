@@ -20,6 +20,7 @@
 #include "mask-resource.h"
 #include "gs/gs-vertexbuffer.h"
 #include "gs/gs-indexbuffer.h"
+#include <tiny_obj_loader.h>
 
 namespace Mask {
 	namespace Resource {
@@ -44,6 +45,9 @@ namespace Mask {
 
 		private:
 			void LoadObj(std::string file);
+			void LoadObj(const uint8_t* data, size_t size);
+			void MakeObjBuffers(const tinyobj::attrib_t& attrib,
+				const std::vector<tinyobj::shape_t>& shapes);
 
 		protected:
 			std::shared_ptr<GS::VertexBuffer>	m_VertexBuffer;
@@ -54,9 +58,6 @@ namespace Mask {
 			std::shared_ptr<Mask::Part>			m_part;
 
 			// for delayed gs creation
-			std::string				m_tempFile;
-			uint8_t*				m_rawVertices;
-			uint8_t*				m_rawIndices;
 			int						m_numIndices;
 
 			vec3 CalculateTangent(const GS::Vertex& v1,
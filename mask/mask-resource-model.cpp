@@ -121,6 +121,72 @@ void Mask::Resource::Model::DirectRender(Mask::Part* part) {
 	m_parent->instanceDatas.Pop();
 }
 
+void Mask::Resource::Model::RenderFaces(Mask::Part* part,
+	const matrix4* faceTransforms, size_t count) {
+	// transparent models only need adding to the sorted
+	// list once, the sorted pass draws them for every face
+	if (!IsOpaque()) {
+		IBase::RenderFaces(part, faceTransforms, count > 0 ? 1 : 0);
+		return;
+	}
+	DirectRender(part, faceTransforms, count);
+}
+
+void Mask::Resource::Model::DirectRender(Mask::Part* part,
+	const matrix4* faceTransforms, size_t count) {
+	if (count == 0)
+		return;
+
+	if (m_material->WriteAlpha())
+		gs_enable_color(true, true, true, true);
+	else
+		gs_enable_color(true, true, true, false);
+
+	// material state is bound once, only the world matrix
+	// changes between faces
+	matrix4 world;
+	matrix4_mul(&world, &part->global, &faceTransforms[0]);
+	gs_matrix_set(&world);
+
+	m_parent->instanceDatas.Push(m_id);
+	while (m_material->Loop(part)) {
+		for (size_t i = 0; i < count; i++) {
+			matrix4_mul(&world, &part->global, &faceTransforms[i]);
+			gs_matrix_set(&world);
+			m_material->SetWorldMatrix();
+			m_mesh->Render(part);
+		}
+	}
+	m_parent->instanceDatas.Pop();
+}
+
+void Mask::Resource::Model::DirectRenderInstances(Mask::Part* part,
+	const matrix4* worldTransforms, const float* alphas, size_t count) {
+	if (count == 0)
+		return;
+
+	if (m_material->WriteAlpha())
+		gs_enable_color(true, true, true, true);
+	else
+		gs_enable_color(true, true, true, false);
+
+	gs_matrix_push();
+	gs_matrix_set(&worldTransforms[0]);
+
+	m_parent->instanceDatas.Push(m_id);
+	while (m_material->Loop(part)) {
+		for (size_t i = 0; i < count; i++) {
+			gs_matrix_set(&worldTransforms[i]);
+			m_material->SetWorldMatrix();
+			m_material->SetAlpha(alphas[i]);
+			m_mesh->Render(part);
+		}
+	}
+	m_parent->instanceDatas.Pop();
+
+	gs_matrix_pop();
+}
+
 
 bool Mask::Resource::Model::IsDepthOnly() {
 	if (m_material != nullptr) {
@@ -166,3 +232,8 @@ void Mask::Resource::Model::SortedRender() {
 	DirectRender(sortDrawPart);
 }
 
+void Mask::Resource::Model::SortedRenderFaces(const matrix4* faceTransforms,
+	size_t count) {
+	DirectRender(sortDrawPart, faceTransforms, count);
+}
+
@@ -36,14 +36,25 @@ namespace Mask {
 			virtual Type GetType() override;
 			virtual void Update(Mask::Part* part, float time) override;
 			virtual void Render(Mask::Part* part) override;
+			virtual void RenderFaces(Mask::Part* part,
+				const matrix4* faceTransforms, size_t count) override;
 			virtual bool IsDepthOnly() override;
 			virtual bool IsStatic() override;
 			virtual bool IsRotationDisabled() override;
 
 			virtual float	SortDepth() override;
 			virtual void	SortedRender() override;
+			virtual void	SortedRenderFaces(const matrix4* faceTransforms,
+				size_t count) override;
+			virtual size_t	SortMaterialId() override { return m_material->GetId(); }
 
 			void DirectRender(Mask::Part* part);
+			void DirectRender(Mask::Part* part,
+				const matrix4* faceTransforms, size_t count);
+			// draws the mesh once per world transform, fading each by
+			// its alpha, with the material bound once
+			void DirectRenderInstances(Mask::Part* part,
+				const matrix4* worldTransforms, const float* alphas, size_t count);
 
 			bool IsOpaque();
 
@@ -127,29 +127,37 @@ bool Mask::Resource::Morph::IsDepthOnly() {
 
 void Mask::Resource::Morph::SetAnimatableValue(float v,
 	Mask::Resource::AnimationChannelType act) {
+	SetAnimatableValues(&v, &act, 1);
+}
+
+void Mask::Resource::Morph::SetAnimatableValues(const float* values,
+	const Mask::Resource::AnimationChannelType* types, size_t count) {
 	// sanity
-	if (act < MORPH_CHANNEL_FIRST || act >= MORPH_CHANNEL_LAST) {
-		PLOG_ERROR("Bad channel sent to Morph::SetAnimatableValue");
-		throw std::logic_error("Bad channel sent to Morph::SetAnimatableValue.");
+	for (size_t i = 0; i < count; i++) {
+		if (types[i] < MORPH_CHANNEL_FIRST || types[i] >= MORPH_CHANNEL_LAST) {
+			PLOG_ERROR("Bad channel sent to Morph::SetAnimatableValue");
+			throw std::logic_error("Bad channel sent to Morph::SetAnimatableValue.");
+		}
 	}
 
-	// get indices into deltas
-	int deltaIdx = (int)act - (int)MORPH_LANDMARK_0_X;
-	int deltaMod = deltaIdx % 3;
-	deltaIdx /= 3;
+	// deltas are vec3s, and channels index their floats
+	// note: vec3 is padded to 4 floats
+	const smll::DeltaList& current = m_morphData.GetDeltas();
+	bool changed = !m_morphData.IsValid();
+	for (size_t i = 0; i < count && !changed; i++) {
+		int deltaIdx = (int)types[i] - (int)MORPH_LANDMARK_0_X;
+		if (current[deltaIdx / 3].ptr[deltaIdx % 3] != values[i])
+			changed = true;
+	}
 
-	// set new value
+	// stamping sends the morph off to be triangulated again, so
+	// only do it once, and only if something changed
+	if (!changed)
+		return;
 	smll::DeltaList& deltas = m_morphData.GetDeltasAndStamp();
-	switch (deltaMod) {
-	case 0:
-		deltas[deltaIdx].x = v;
-		break;
-	case 1:
-		deltas[deltaIdx].y = v;
-		break;
-	case 2:
-		deltas[deltaIdx].z = v;
-		break;
+	for (size_t i = 0; i < count; i++) {
+		int deltaIdx = (int)types[i] - (int)MORPH_LANDMARK_0_X;
+		deltas[deltaIdx / 3].ptr[deltaIdx % 3] = values[i];
 	}
 }
 
@@ -172,7 +180,7 @@ void Mask::Resource::Morph::MakeFaceIndexBuffers() {
 void Mask::Resource::Morph::RenderMorphVideo(gs_texture* vidtex,
 	const smll::TriangulationResult& trires) {
 
-	if (trires.vertexBuffer == nullptr)
+	if (!trires.IsValid())
 		return;
 
 	MakeFaceIndexBuffers();
@@ -56,6 +56,8 @@ namespace Mask {
 			// IAnimatable
 			void SetAnimatableValue(float v,
 				Resource::AnimationChannelType act) override;
+			void SetAnimatableValues(const float* values,
+				const Resource::AnimationChannelType* types, size_t count) override;
 
 		protected:
 
@@ -118,8 +118,8 @@ void Mask::Resource::Sequence::Update(Mask::Part* part, float time) {
 	m_parent->instanceDatas.Push(m_id);
 
 	// get our instance data
-	std::shared_ptr<SequenceInstanceData> instData =
-		m_parent->instanceDatas.GetData<SequenceInstanceData>();
+	SequenceInstanceData* instData =
+		m_parent->instanceDatas.GetData(m_instanceCache);
 	if (instData->current < 0) {
 		if (m_randomStart) {
 			instData->Reset(m_first, m_last);
@@ -255,8 +255,8 @@ bool Mask::Resource::Sequence::IsInstancePlaying() {
 	m_parent->instanceDatas.Push(m_id);
 
 	// get our instance data
-	std::shared_ptr<SequenceInstanceData> instData =
-		m_parent->instanceDatas.GetData<SequenceInstanceData>();
+	SequenceInstanceData* instData =
+		m_parent->instanceDatas.GetData(m_instanceCache);
 
 	bool is_playing = instData->delay == 0 || instData->current > 0;
 	bool not_ended = instData->playback_ended;
@@ -274,8 +274,8 @@ void Mask::Resource::Sequence::SetTextureMatrix(Mask::Part* part, matrix4* texma
 	m_parent->instanceDatas.Push(m_id);
 
 	// get our instance data
-	std::shared_ptr<SequenceInstanceData> instData =
-		m_parent->instanceDatas.GetData<SequenceInstanceData>();
+	SequenceInstanceData* instData =
+		m_parent->instanceDatas.GetData(m_instanceCache);
 
 	int curr = instData->current;
 	if (curr < 0)
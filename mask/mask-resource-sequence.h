@@ -91,6 +91,8 @@ namespace Mask {
 			Mode					m_mode;
 			bool					m_randomStart;
 
+			InstanceDataCache<SequenceInstanceData>	m_instanceCache;
+
 			Mode StringToMode(std::string m);
 			bool IsMultiFrameMode() {
 				return (m_mode == Mask::Resource::Sequence::ONCE ||
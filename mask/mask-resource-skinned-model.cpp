@@ -29,6 +29,8 @@ extern "C" {
 	#pragma warning( pop )
 }
 #include <sstream>
+#include <cstring>
+#include <xmmintrin.h>
 
 static const char* const S_MATERIAL = "material";
 static const char* const S_BONES = "bones";
@@ -48,14 +50,6 @@ static const char* const S_DEPTH_BIAS = "depth-bias";
 Mask::Resource::SkinnedModel::SkinnedModel(Mask::MaskData* parent, std::string name, obs_data_t* data)
 	: IBase(parent, name) {
 
-	// cache hash ids for bones 
-	std::hash<std::string> hasher;
-	char temp[64];
-	for (int i = 0; i < 8; i++) {
-		snprintf(temp, sizeof(temp), "bone%d", i);
-		m_boneIds[i] = hasher(temp);
-	}
-
 	// Material
 	if (!obs_data_has_user_value(data, S_MATERIAL)) {
 		PLOG_ERROR("Skinned Model '%s' has no material.", name.c_str());
@@ -109,7 +103,12 @@ Mask::Resource::SkinnedModel::SkinnedModel(Mask::MaskData* parent, std::string n
 		}
 
 		std::string partName = obs_data_get_string(boneData, S_NAME);
-		bone.part = parent->GetPart(partName);
+		bone.part = parent->GetPart(partName).get();
+		if (bone.part == nullptr) {
+			PLOG_ERROR("<Skinned Model '%s'> Bone part '%s' could not be resolved.",
+				m_name.c_str(), partName.c_str());
+			throw std::logic_error("Skinned Model bone depends on non-existing part.");
+		}
 
 		// Read offset transform data
 		vec3 position, scale; 
@@ -134,7 +133,6 @@ Mask::Resource::SkinnedModel::SkinnedModel(Mask::MaskData* parent, std::string n
 		matrix4_translate3f(&bone.offset, &bone.offset,
 			position.x, position.y, position.z);
 
-		matrix4_identity(&bone.global);
 		obs_data_release(boneData);
 	}
 
@@ -187,8 +185,21 @@ Mask::Resource::SkinnedModel::SkinnedModel(Mask::MaskData* parent, std::string n
 
 		for (obs_data_item_t* itm2 = obs_data_first(skinBonesData); itm2; obs_data_item_next(&itm2)) {
 			int boneIdx = (int)obs_data_item_get_int(itm2);
+			if (boneIdx < 0 || boneIdx >= (int)m_bones.size()) {
+				PLOG_ERROR("<Skinned Model '%s'> Skin '%s' has bad bone index %d.",
+					m_name.c_str(), skinName.c_str(), boneIdx);
+				throw std::logic_error("Skinned Model skin has bad bone index.");
+			}
 			skin.bones.push_back(boneIdx);
 		}
+		if (skin.bones.size() > MAX_BONES_PER_SKIN) {
+			PLOG_ERROR("<Skinned Model '%s'> Skin '%s' has %d bones, the most we can do is %d.",
+				m_name.c_str(), skinName.c_str(), (int)skin.bones.size(), MAX_BONES_PER_SKIN);
+			throw std::logic_error("Skinned Model skin has too many bones.");
+		}
+		// the effect takes the whole array, unused entries stay zero
+		skin.palette.resize(MAX_BONES_PER_SKIN);
+		memset(skin.palette.data(), 0, sizeof(matrix4) * MAX_BONES_PER_SKIN);
 
 		m_skins.emplace_back(skin);
 		obs_data_release(skinData);
@@ -205,6 +216,8 @@ Mask::Resource::SkinnedModel::SkinnedModel(Mask::MaskData* parent, std::string n
 		obs_data_item_release(&skinsItem);
 	}
 
+	m_boneMatrices.resize(m_bones.size());
+
 	if (obs_data_has_user_value(data, S_ORDER)) {
 		m_render_order = obs_data_get_int(data, S_ORDER);
 	}
@@ -230,16 +243,41 @@ void Mask::Resource::SkinnedModel::Update(Mask::Part* part, float time) {
 		m_skins[i].mesh->Update(part, time);
 	}
 	// update bone matrices
-	for (unsigned int i = 0; i < m_bones.size(); i++) {
-		Bone& bone = m_bones[i];
+	UpdatePalettes();
+	m_parent->instanceDatas.Pop();
+}
 
-		// concat offset and bone matrices
-		matrix4_mul(&bone.global, &bone.offset, &bone.part->global);
+void Mask::Resource::SkinnedModel::UpdatePalettes() {
+	// concat offset and bone matrices, and transpose, since we
+	// are passing to a shader
+	for (size_t i = 0; i < m_bones.size(); i++) {
+		const Bone& bone = m_bones[i];
+		const matrix4& b = bone.part->global;
+		__m128 r[4];
+		const vec4* rows[4] = { &bone.offset.x, &bone.offset.y,
+			&bone.offset.z, &bone.offset.t };
+		for (int j = 0; j < 4; j++) {
+			const vec4* a = rows[j];
+			r[j] = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a->x), b.x.m),
+					_mm_mul_ps(_mm_set1_ps(a->y), b.y.m)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a->z), b.z.m),
+					_mm_mul_ps(_mm_set1_ps(a->w), b.t.m)));
+		}
+		_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+		matrix4& m = m_boneMatrices[i];
+		m.x.m = r[0];
+		m.y.m = r[1];
+		m.z.m = r[2];
+		m.t.m = r[3];
+	}
 
-		// need to transpose, since we are passing to a shader
-		matrix4_transpose(&bone.global, &bone.global);
+	// gather each skin's palette
+	for (Skin& skin : m_skins) {
+		for (size_t j = 0; j < skin.bones.size(); j++) {
+			skin.palette[j] = m_boneMatrices[skin.bones[j]];
+		}
 	}
-	m_parent->instanceDatas.Pop();
 }
 
 void Mask::Resource::SkinnedModel::Render(Mask::Part* part) {
@@ -267,11 +305,9 @@ void Mask::Resource::SkinnedModel::DirectRender(Mask::Part* part) {
 	for (unsigned int i = 0; i < m_skins.size(); i++) {
 		const Skin& skin = m_skins[i];
 
-		// set up bones list
+		// bones list
 		bone_list.numBones = (int)skin.bones.size();
-		for (int j = 0; j < skin.bones.size(); j++) {
-			bone_list.bones[j] = &(m_bones[skin.bones[j]].global);
-		}
+		bone_list.bones = skin.palette.data();
 		// draw
 		while (m_material->Loop(part, &bone_list)) {
 			skin.mesh->Render(part);
@@ -280,6 +316,45 @@ void Mask::Resource::SkinnedModel::DirectRender(Mask::Part* part) {
 	m_parent->instanceDatas.Pop();
 }
 
+void Mask::Resource::SkinnedModel::RenderFaces(Mask::Part* part,
+	const matrix4* faceTransforms, size_t count) {
+	// transparent models only need adding to the sorted
+	// list once, the sorted pass draws them for every face
+	if (!IsOpaque()) {
+		IBase::RenderFaces(part, faceTransforms, count > 0 ? 1 : 0);
+		return;
+	}
+	DirectRender(part, faceTransforms, count);
+}
+
+void Mask::Resource::SkinnedModel::DirectRender(Mask::Part* part,
+	const matrix4* faceTransforms, size_t count) {
+	if (count == 0)
+		return;
+
+	// transform comes from bones, so the face transform is all
+	// we need, and it's the only state that changes between faces
+	m_parent->instanceDatas.Push(m_id);
+	BonesList bone_list;
+	for (unsigned int i = 0; i < m_skins.size(); i++) {
+		const Skin& skin = m_skins[i];
+
+		// bones list
+		bone_list.numBones = (int)skin.bones.size();
+		bone_list.bones = skin.palette.data();
+		// draw
+		gs_matrix_set(&faceTransforms[0]);
+		while (m_material->Loop(part, &bone_list)) {
+			for (size_t f = 0; f < count; f++) {
+				gs_matrix_set(&faceTransforms[f]);
+				m_material->SetWorldMatrix();
+				skin.mesh->Render(part);
+			}
+		}
+	}
+	m_parent->instanceDatas.Pop();
+}
+
 
 bool Mask::Resource::SkinnedModel::IsDepthOnly() {
 	if (m_material != nullptr) {
@@ -335,3 +410,8 @@ void Mask::Resource::SkinnedModel::SortedRender() {
 	DirectRender(sortDrawPart);
 }
 
+void Mask::Resource::SkinnedModel::SortedRenderFaces(const matrix4* faceTransforms,
+	size_t count) {
+	DirectRender(sortDrawPart, faceTransforms, count);
+}
+
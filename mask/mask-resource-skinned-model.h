@@ -28,11 +28,15 @@
 namespace Mask {
 	namespace Resource {
 
-		static const int MAX_BONES_PER_SKIN = 8;
+		// keep in sync with the bones array in the effects
+		static const int MAX_BONES_PER_SKIN = 32;
 
+		// BonesList
+		// - a skin's palette, MAX_BONES_PER_SKIN transposed matrices
+		//   one after the other, uploaded to the effect in one go
 		struct BonesList {
-			int											numBones;
-			std::array<matrix4*, MAX_BONES_PER_SKIN>	bones;
+			int					numBones;
+			const matrix4*		bones;
 		};
 
 		class SkinnedModel : public IBase, public SortedDrawObject {
@@ -43,14 +47,21 @@ namespace Mask {
 			virtual Type GetType() override;
 			virtual void Update(Mask::Part* part, float time) override;
 			virtual void Render(Mask::Part* part) override;
+			virtual void RenderFaces(Mask::Part* part,
+				const matrix4* faceTransforms, size_t count) override;
 			virtual bool IsDepthOnly() override;
 			virtual bool IsStatic() override;
 			virtual bool IsRotationDisabled() override;
 
 			virtual float	SortDepth() override;
 			virtual void	SortedRender() override;
+			virtual void	SortedRenderFaces(const matrix4* faceTransforms,
+				size_t count) override;
+			virtual size_t	SortMaterialId() override { return m_material->GetId(); }
 
 			void DirectRender(Mask::Part* part);
+			void DirectRender(Mask::Part* part,
+				const matrix4* faceTransforms, size_t count);
 
 			bool IsOpaque();
 
@@ -61,26 +72,25 @@ namespace Mask {
 		protected:
 
 			struct Bone {
-				std::shared_ptr<Part>	part;
+				Part*					part;
 				matrix4					offset;
-				matrix4					global;
-				//Bone& operator=(const Bone& b) {
-				//	part = b.part;
-				//	matrix4_copy(&offset, &(b.offset));
-				//	matrix4_copy(&global, &(b.global));
-				//	return *this;
-				//}
 			};
 			struct Skin {
 				std::shared_ptr<Mesh>	mesh;
 				std::vector<int>		bones;
+				// offset * bone global, transposed for the shader,
+				// in skin bone order
+				std::vector<matrix4>	palette;
 			};
 
 			std::vector<Bone>			m_bones;
 			std::vector<Skin>			m_skins;
 			std::shared_ptr<Material>	m_material;
 
-			std::array<size_t, 8>		m_boneIds;
+			// bone matrices for this frame, shared by the skins
+			std::vector<matrix4>		m_boneMatrices;
+
+			void	UpdatePalettes();
 		};
 	}
 }
@@ -48,6 +48,17 @@ Mask::Resource::IBase::~IBase() {
 
 }
 
+void Mask::Resource::IBase::RenderFaces(Mask::Part* part,
+	const matrix4* faceTransforms, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		gs_matrix_set(&faceTransforms[i]);
+		gs_matrix_push();
+		gs_matrix_mul(&part->global);
+		Render(part);
+		gs_matrix_pop();
+	}
+}
+
 std::shared_ptr<Mask::Resource::IBase> Mask::Resource::IBase::Load(Mask::MaskData* parent, std::string name, obs_data_t* data, Cache *cache) {
 	static const char* const S_TYPE = "type";
 
@@ -188,226 +199,3 @@ std::shared_ptr<Mask::Resource::IBase> Mask::Resource::IBase::LoadDefault(Mask::
 
 	return p;
 }
-
-
-// ------------------------------------------------------------------------- //
-// Cache Pools
-// ------------------------------------------------------------------------- //
-
-const size_t Mask::Resource::Cache::POOL_SIZE = 10;
-
-bool Mask::Resource::Cache::add_permanent(CacheableType resource_type, std::string name, void *resource) {
-	auto pool_it = permanent_cache.find(name);
-	if (pool_it == permanent_cache.end()) {
-		permanent_cache[name] = std::make_pair(resource_type, resource);
-		return true;
-	}
-	return false;
-}
-
-bool Mask::Resource::Cache::add(CacheableType resource_type, std::string name, void *resource) {
-	auto pool_it = pool_map.find(resource_type);
-	if (pool_it == pool_map.end()) {
-		pool_map[resource_type] = CachePool();
-		pool_it = pool_map.find(resource_type);
-	}
-	CachePool &pool = pool_it->second;
-
-	auto it = pool.find(name);
-	if (it != pool.end()) {
-		if (it->second.resource != nullptr)
-		{
-			if (it->second.active_count == 0) {
-				// no one is using the old one
-				// probably a name clash from an older mask load
-				// can safely replace
-				//blog(LOG_DEBUG, "Caching resource (replacing inactive older version): %s", name.c_str());
-				pool[name] = CacheItem(resource);
-				return true;
-			}
-			else
-				throw "Incorrect use of add before calling load";
-		}
-		else {
-			//blog(LOG_DEBUG, "Caching resource (re-bind): %s", name.c_str());
-			pool[name] = CacheItem(resource);
-			return true;
-		}
-	}
-	else if (pool.size() < POOL_SIZE)
-	{
-		//blog(LOG_DEBUG, "Caching resource: %s", name.c_str());
-		pool[name] = CacheItem(resource);
-		return true;
-	}
-	else
-	{
-		// remove the least re-used resource
-		auto min_it = pool.begin();
-		size_t min_ref = min_it->second.use_count;
-		for (auto it = pool.begin(); it != pool.end(); it++)
-		{
-			if (min_ref > it->second.use_count)
-			{
-				min_ref = it->second.use_count;
-				min_it = it;
-			}
-		}
-		// if the least re-used resource is actively used
-		// by 2 or more, we cannot remove it
-		// let's search for the currently least active resource
-		if (min_it->second.active_count > 2)
-		{
-			min_it = pool.begin();
-			min_ref = min_it->second.active_count;
-			for (auto it = pool.begin(); it != pool.end(); it++)
-			{
-				if (min_ref > it->second.active_count)
-				{
-					min_ref = it->second.active_count;
-					min_it = it;
-				}
-			}
-		}
-
-		//blog(LOG_DEBUG, "Pool full. Removing least used/active resource: %s, #active = %d, #use = %d",
-		//	min_it->first.c_str(), min_it->second.active_count, min_it->second.use_count);
-
-		if (min_it->second.active_count == 1)
-		{
-			// only remove from the pool
-			// the one active user will
-			// correctly destruct the resource
-			pool.erase(min_it);
-		}
-		else if (min_it->second.active_count == 0)
-		{
-			// no one were using this resource
-			// let's destruct it ourselves
-			destruct_by_type(min_it->second.resource, resource_type);
-			pool.erase(min_it);
-		}
-		else
-		{
-			// sorry we cannot cache
-			// the pool is full and
-			// no one can leave it currently
-			//blog(LOG_DEBUG, "Caching failed because the pool is full, and no one is willing to leave. Resource: %s", name.c_str());
-			return false;
-		}
-
-		//blog(LOG_DEBUG, "Caching resource: %s", name.c_str());
-
-		pool[name] = CacheItem(resource);
-
-		return true;
-	}
-}
-
-void Mask::Resource::Cache::load(CacheableType resource_type, std::string name, void **resource_ptr) {
-	auto pool_it = pool_map.find(resource_type);
-	if (pool_it == pool_map.end()) {
-		*resource_ptr = nullptr;
-		return;
-	}
-	CachePool &pool = pool_it->second;
-	if (pool.find(name) != pool.end()) {
-		//blog(LOG_DEBUG, "Re-using resource: %s", name.c_str());
-		pool[name].active_count++;
-		pool[name].use_count++;
-		*resource_ptr = pool[name].resource;
-	}
-	else
-		*resource_ptr = nullptr;
-}
-
-void Mask::Resource::Cache::load_permanent(std::string name, void **resource_ptr) {
-	auto item = permanent_cache.find(name);
-	if (item != permanent_cache.end()) {
-		*resource_ptr = item->second.second;
-	}
-	else
-		*resource_ptr = nullptr;
-}
-
-void Mask::Resource::Cache::destruct_by_type(void *resource, CacheableType resource_type) {
-	if (resource == nullptr) return;
-
-	obs_enter_graphics();
-	switch (resource_type)
-	{
-	case CacheableType::Texture:
-	{
-		gs_texture_t *texture = reinterpret_cast<gs_texture_t*>(resource);
-
-		switch (gs_get_texture_type(texture)) {
-		case GS_TEXTURE_2D:
-			gs_texture_destroy(texture);
-			break;
-		case GS_TEXTURE_3D:
-			gs_voltexture_destroy(texture);
-			break;
-		case GS_TEXTURE_CUBE:
-			gs_cubetexture_destroy(texture);
-			break;
-		}
-	}
-	break;
-	case CacheableType::Effect:
-	{
-		gs_effect_t *effect = reinterpret_cast<gs_effect_t*>(resource);
-		gs_effect_destroy(effect);
-	}
-	break;
-	case CacheableType::OBSData:
-	{
-		obs_data_t *data = reinterpret_cast<obs_data_t*>(resource);
-		obs_data_release(data);
-	}
-	break;
-	}
-	obs_leave_graphics();
-}
-
-void Mask::Resource::Cache::try_destroy_resource(std::string name, void *resource, CacheableType resource_type) {
-	// only destroy if the resource is not managed by the pool
-	auto pool_it = pool_map.find(resource_type);
-	if (pool_it == pool_map.end()) return;
-	CachePool &pool = pool_it->second;
-
-	auto it = pool.find(name);
-	if (it == pool.end()) {
-		destruct_by_type(resource, resource_type);
-	}
-	else {
-		//blog(LOG_DEBUG, "Delaying destroying managed resource: %s, #active = %d", name.c_str(), it->second.active_count);
-		it->second.active_count--;
-	}
-}
-
-void Mask::Resource::Cache::destroy() {
-	obs_enter_graphics();
-
-	// destroy pool-managed caches
-	for (auto &pool_ent : pool_map)
-	{
-		CachePool &pool = pool_ent.second;
-		for (auto &ent : pool) {
-			//blog(LOG_DEBUG, "Cache Destroy: destroying managed resource: %s", ent.first.c_str());
-			destruct_by_type(ent.second.resource, pool_ent.first);
-			ent.second.resource = nullptr;
-		}
-	}
-
-	// destroy permanent cache
-	for (auto &ent : permanent_cache) {
-		//blog(LOG_DEBUG, "Cache Destroy: destroying permanent resource: %s", ent.first.c_str());
-		// ent.second = pair<CacheableType, void *resource>
-		destruct_by_type(ent.second.second, ent.second.first);
-		ent.second.second = nullptr;
-	}
-
-	obs_leave_graphics();
-
-}
-
@@ -23,11 +23,16 @@
 #include <functional>
 #include <memory>
 #include <thread>
+#include <mutex>
+#include <list>
+#include <vector>
+#include <unordered_map>
 extern "C" {
 	#pragma warning( push )
 	#pragma warning( disable: 4201 )
 	#include <libobs/obs-module.h>
 	#include <libobs/obs-data.h>
+	#include <libobs/graphics/matrix4.h>
 	#pragma warning( pop )
 }
 
@@ -51,34 +56,19 @@ namespace Mask {
 			Animation,
 		};
 
+		// Cache : pool of gs resources shared between masks
+		// - keyed by a content hash of the resource data (see
+		//   Utils::HashData), so the same texture embedded in two masks
+		//   under different names is only loaded once
+		// - bounded by bytes, only idle resources (active_count == 0)
+		//   can be evicted, as whoever uses the others destroys them
+		// - idle resources sit in two LRU lists: used once and used
+		//   more than once, and we evict from the first before the
+		//   second, so a resource that gets re-used hangs around longer
 		class Cache {
 		public:
-			// each cache pool will try to cap at this number
-			static const size_t POOL_SIZE;
-
-			struct CacheItem {
-				// if a resource is used many times
-				// we should try to keep it in the pool
-				size_t use_count;
-				// if we want a resource to leave the pool
-				// the number of instances this resource is
-				// actively used in will tell us if it is safe
-				// for it to leave the pool.
-				// e.g. if no one is using it, no one will
-				// care. if one is using it, that
-				// resource will take care of destructing
-				// but if two are using it, it
-				// is unsafe, as both of them will try to
-				// destruct the same resource
-				size_t active_count;
-				void *resource;
-				CacheItem():resource(nullptr) {}
-				CacheItem(void *resource) :resource(resource) {
-					active_count = use_count = 1;
-				}
-			};
-			// map < resource name, cache item >
-			using CachePool = std::map<std::string, CacheItem>;
+			// default budget for pooled resources, gpu and cpu memory
+			static const size_t DEFAULT_BUDGET;
 
 			enum class CacheableType {
 				Texture,
@@ -86,18 +76,66 @@ namespace Mask {
 				OBSData
 			};
 			using PermanentResource = std::pair<CacheableType, void*>;
-			 
-			bool add(CacheableType resource_type, std::string name, void *resource);
+
+			struct Stats {
+				size_t hits;
+				size_t misses;
+				size_t evictions;
+				size_t items;
+				size_t bytes;
+				size_t budget;
+			};
+
+			Cache();
+
+			// add returns false if the resource was not pooled, in which
+			// case the caller owns it, as with an empty key
+			bool add(CacheableType resource_type, const std::string& key, 
+				void *resource, size_t bytes = 0);
 			bool add_permanent(CacheableType resource_type, std::string name, void *resource);
 
-			void load(CacheableType resource_type, std::string name, void **resource_ptr);
+			void load(CacheableType resource_type, const std::string& key, void **resource_ptr);
 			void load_permanent(std::string name, void **resource_ptr);
 
 			void destruct_by_type(void *resource, CacheableType resource_type);
-			void try_destroy_resource(std::string name, void *resource, CacheableType resource_type);
+			void try_destroy_resource(const std::string& key, void *resource, CacheableType resource_type);
 			void destroy();
+
+			void	set_budget(size_t bytes);
+			Stats	get_stats();
+
 		private:
-			std::map<CacheableType, CachePool> pool_map;
+			struct CacheItem {
+				void *resource;
+				CacheableType type;
+				size_t bytes;
+				// if a resource is used many times
+				// we should try to keep it in the pool
+				size_t use_count;
+				// number of instances this resource is
+				// actively used in, we can only let go of it
+				// once no one is using it
+				size_t active_count;
+				// where we are in the idle lists
+				std::list<std::string>* idle_list;
+				std::list<std::string>::iterator idle_it;
+			};
+			using ItemMap = std::unordered_map<std::string, CacheItem>;
+			using Destructions = std::vector<PermanentResource>;
+
+			std::string	item_key(CacheableType resource_type, const std::string& key);
+			void		make_idle(const std::string& ikey, CacheItem& item);
+			void		make_active(CacheItem& item);
+			void		evict(size_t needed, Destructions& destructions);
+			void		destruct_all(const Destructions& destructions);
+
+			std::mutex				m_mutex;
+			ItemMap					m_items;
+			std::list<std::string>	m_idleOnce;		// most recent first
+			std::list<std::string>	m_idleReused;	// most recent first
+			size_t					m_bytes;
+			size_t					m_budget;
+			size_t					m_hits, m_misses, m_evictions;
 			std::map<std::string, PermanentResource> permanent_cache;
 		};
 
@@ -119,6 +157,12 @@ namespace Mask {
 			Mask::MaskData* GetParent() { return m_parent; }
 			virtual void Update(Mask::Part* part, float time) = 0;
 			virtual void Render(Mask::Part* part) = 0;
+			// Render for every face
+			// - faceTransforms are the face poses, without the part transform
+			// - the default calls Render once per face, resources that can
+			//   keep their state bound across faces override this
+			virtual void RenderFaces(Mask::Part* part,
+				const matrix4* faceTransforms, size_t count);
 			virtual bool IsDepthOnly() { return false; }
 			virtual bool IsStatic() { return false; }
 			virtual bool IsRotationDisabled() { return false; }
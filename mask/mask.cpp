@@ -37,7 +37,7 @@ static float FOVA(float aspect) {
 Mask::Part::Part(std::shared_ptr<Part> p_parent,
 	std::shared_ptr<Resource::IBase> p_resource) :
 	parent(p_parent), 
-	localdirty(true), dirty(true), isquat(false) {
+	localdirty(true), isquat(false) {
 	vec3_zero(&position);
 	vec3_zero(&rotation);
 	vec3_set(&scale, 1, 1, 1);
@@ -49,42 +49,51 @@ Mask::Part::Part(std::shared_ptr<Part> p_parent,
 }
 
 
-void Mask::Part::SetAnimatableValue(float v, 
+static float* PartAnimatableValue(Mask::Part* part,
 	Mask::Resource::AnimationChannelType act) {
-	// set value
 	switch (act) {
 	case Mask::Resource::PART_POSITION_X:
-		position.x = v;
-		break;
+		return &part->position.x;
 	case Mask::Resource::PART_POSITION_Y:
-		position.y = v;
-		break;
+		return &part->position.y;
 	case Mask::Resource::PART_POSITION_Z:
-		position.z = v;
-		break;
+		return &part->position.z;
 	case Mask::Resource::PART_QROTATION_X:
-		qrotation.x = v;
-		break;
+		return &part->qrotation.x;
 	case Mask::Resource::PART_QROTATION_Y:
-		qrotation.y = v;
-		break;
+		return &part->qrotation.y;
 	case Mask::Resource::PART_QROTATION_Z:
-		qrotation.z = v;
-		break;
+		return &part->qrotation.z;
 	case Mask::Resource::PART_QROTATION_W:
-		qrotation.w = v;
-		break;
+		return &part->qrotation.w;
 	case Mask::Resource::PART_SCALE_X:
-		scale.x = v;
-		break;
+		return &part->scale.x;
 	case Mask::Resource::PART_SCALE_Y:
-		scale.y = v;
-		break;
+		return &part->scale.y;
 	case Mask::Resource::PART_SCALE_Z:
-		scale.z = v;
-		break;
+		return &part->scale.z;
+	}
+	return nullptr;
+}
+
+void Mask::Part::SetAnimatableValue(float v, 
+	Mask::Resource::AnimationChannelType act) {
+	SetAnimatableValues(&v, &act, 1);
+}
+
+void Mask::Part::SetAnimatableValues(const float* values,
+	const Mask::Resource::AnimationChannelType* types, size_t count) {
+	// channels are set every frame, only a change dirties us
+	bool changed = false;
+	for (size_t i = 0; i < count; i++) {
+		float* value = PartAnimatableValue(this, types[i]);
+		if (value && *value != values[i]) {
+			*value = values[i];
+			changed = true;
+		}
 	}
-	localdirty = true;
+	if (changed)
+		localdirty = true;
 }
 
 static const char* const JSON_METADATA_NAME = "name";
@@ -101,21 +110,24 @@ static const char* const JSON_INTRO_FADE_TIME = "intro_fade_time";
 static const char* const JSON_INTRO_DURATION = "intro_duration";
 
 
-static const int NUM_DRAW_BUCKETS = 1024;
-static const float BUCKETS_MAX_Z = 10.0f;
-static const float BUCKETS_MIN_Z = -100.0f;
+// sort keys: render order | depth | material
+static const int SORT_DEPTH_BITS = 24;
+static const int SORT_MATERIAL_BITS = 24;
+static const uint64_t SORT_ORDER_MASK = 0xFFFF;
+static const uint64_t SORT_DEPTH_MASK = (1ULL << SORT_DEPTH_BITS) - 1;
+static const uint64_t SORT_MATERIAL_MASK = (1ULL << SORT_MATERIAL_BITS) - 1;
+static const float SORT_MAX_Z = 10.0f;
+static const float SORT_MIN_Z = -100.0f;
 
 Mask::MaskData::MaskData(Cache *cache) : m_data(nullptr), m_morph(nullptr),
-m_cache(cache), m_elapsedTime(0.0f) {
-	m_drawBuckets = new Mask::SortedDrawObject*[NUM_DRAW_BUCKETS];
-	ClearSortedDrawObjects();
+m_cache(cache), m_elapsedTime(0.0f), m_graphValid(false),
+m_currentFaceTransforms(nullptr) {
 	m_vidLightTex = nullptr;
 	m_num_render_layers = 1;
 	m_num_render_orders = 1;
 }
 
 Mask::MaskData::~MaskData() {
-	delete[] m_drawBuckets;
 	Clear();
 }
 
@@ -132,20 +144,39 @@ bool Mask::MaskData::NeedsPBRLighting() {
 
 void Mask::MaskData::Clear() {
 	m_parts.clear();
+	m_graphParts.clear();
+	m_graphParents.clear();
+	m_graphChainStart.clear();
+	m_graphChain.clear();
+	m_graphDirty.clear();
+	m_drawParts.clear();
+	m_graphValid = false;
 	m_resources.clear();
+	m_decoder.Stop();
 	if (m_data) {
 		obs_data_release(m_data);
 		m_data = nullptr;
 	}
+	m_package.reset();
 	m_morph = nullptr;
 }
 
 void Mask::MaskData::Load(const std::string& file) {
+	m_decoder.Stop();
 	if (m_data) {
 		obs_data_release(m_data);
 		m_data = nullptr;
 	}
-	m_data = obs_data_create_from_json_file(file.c_str());
+	m_package.reset();
+
+	// binary package, or plain json?
+	if (Package::IsPackage(file)) {
+		m_package = std::make_shared<Package>(file);
+		m_data = obs_data_create_from_json(m_package->GetJSON());
+	}
+	else {
+		m_data = obs_data_create_from_json_file(file.c_str());
+	}
 	if (!m_data)
 		throw std::ios_base::failure(file);
 
@@ -199,6 +230,10 @@ void Mask::MaskData::Load(const std::string& file) {
 	else
 		m_introDuration = 10.0f;
 
+	// Decode the resource data on worker threads while we go, so that
+	// creating the resources below is mostly just graphics uploads.
+	StartDecoder();
+
 	// yield
 	::Sleep(0);
 
@@ -272,7 +307,8 @@ void Mask::MaskData::Load(const std::string& file) {
 	std::multiset<RenderObj, decltype(comp_order)> order_set(comp_order);
 	for (const auto &kv : m_resources) {
 		std::shared_ptr<SortedDrawObject> model = std::dynamic_pointer_cast<SortedDrawObject>(kv.second);
-		if (model)
+		// emitters draw their particles in the default layer and order
+		if (model && kv.second->GetType() != Resource::Type::Emitter)
 		{
 			layer_set.insert(model);
 			order_set.insert(model);
@@ -307,6 +343,56 @@ void Mask::MaskData::Load(const std::string& file) {
 	}
 	m_num_render_orders = current_order + 1;
 
+	// flatten the part hierarchy
+	CompilePartGraph();
+
+	// anything left over belongs to resources nobody uses
+	m_decoder.Stop();
+}
+
+void Mask::MaskData::StartDecoder() {
+	m_decoder.Stop();
+
+	// Queue the data strings of every resource. This has to happen
+	// here, obs_data isn't safe to walk from several threads.
+	obs_data_t* resources = obs_data_get_obj(m_data, JSON_RESOURCES);
+	if (!resources)
+		return;
+	for (obs_data_item_t* el = obs_data_first(resources); el; obs_data_item_next(&el)) {
+		obs_data_t* resd = obs_data_item_get_obj(el);
+		if (!resd)
+			continue;
+		std::string resourceName = obs_data_item_get_name(el);
+		std::string resourceType = obs_data_get_string(resd, JSON_TYPE);
+		if (resourceType == "image" || resourceType == "mesh" || resourceType == "effect") {
+			for (obs_data_item_t* itm = obs_data_first(resd); itm; obs_data_item_next(&itm)) {
+				if (obs_data_item_gettype(itm) != OBS_DATA_STRING)
+					continue;
+				std::string key = obs_data_item_get_name(itm);
+				if (key == "data" || key == "vertex-buffer" || key == "index-buffer" ||
+					key.find("mip-data-") != std::string::npos)
+					m_decoder.Add(BlobDecoder::Key(resourceName, key),
+						obs_data_item_get_string(itm));
+			}
+		}
+		else if (resourceType == "animation") {
+			obs_data_t* channels = obs_data_get_obj(resd, "channels");
+			for (obs_data_item_t* ch = obs_data_first(channels); ch; obs_data_item_next(&ch)) {
+				obs_data_t* chand = obs_data_item_get_obj(ch);
+				if (!chand)
+					continue;
+				std::string channelName = obs_data_item_get_name(ch);
+				m_decoder.Add(BlobDecoder::Key(resourceName, "channels/" + channelName),
+					obs_data_get_string(chand, "values"));
+				obs_data_release(chand);
+			}
+			obs_data_release(channels);
+		}
+		obs_data_release(resd);
+	}
+	obs_data_release(resources);
+
+	m_decoder.Start(m_package);
 }
 
 void Mask::MaskData::AddResource(const std::string& name, std::shared_ptr<Mask::Resource::IBase> resource) {
@@ -320,6 +406,24 @@ void Mask::MaskData::AddResource(const std::string& name, std::shared_ptr<Mask::
 	m_resources.emplace(name, resource);
 }
 
+void Mask::MaskData::GetBlob(const std::string& resource, const std::string& field,
+	const char* value, Blob& blob) {
+	if (m_decoder.Take(BlobDecoder::Key(resource, field), blob))
+		return;
+	if (Package::IsBlobRef(value)) {
+		if (!m_package) {
+			PLOG_ERROR("Blob reference '%s' in a mask that is not a package.", value);
+			throw std::logic_error("Blob reference in a mask that is not a package.");
+		}
+		m_package->GetBlob(value, blob);
+	}
+	else {
+		std::vector<uint8_t> decoded;
+		base64_decodeZ(value, strlen(value), decoded);
+		blob.Take(std::move(decoded));
+	}
+}
+
 std::shared_ptr<Mask::Resource::IBase> Mask::MaskData::GetResource(const std::string& name, bool force_reload) {
 	std::string res_name = name;
 	if (res_name.length() == 0)
@@ -475,6 +579,7 @@ void Mask::MaskData::AddPart(const std::string& name, std::shared_ptr<Mask::Part
 	part->hash_id = hasher(name);
 	part->name = name;
 	m_parts.emplace(name, part);
+	m_graphValid = false;
 }
 
 std::shared_ptr<Mask::Part> Mask::MaskData::GetPart(const std::string& name) {
@@ -536,6 +641,7 @@ std::shared_ptr<Mask::Part> Mask::MaskData::RemovePart(const std::string& name)
 	if (kv != m_parts.end()) {
 		el = kv->second;
 		m_parts.erase(kv);
+		m_graphValid = false;
 	}
 	return el;
 }
@@ -559,46 +665,69 @@ std::shared_ptr<Mask::Part> Mask::MaskData::GetPart(int index) {
 
 
 
-void  Mask::MaskData::ClearSortedDrawObjects() {
-	SortedDrawObject** sdo = m_drawBuckets;
-	for (unsigned int i = 0; i < NUM_DRAW_BUCKETS; i++) {
-		*sdo = nullptr;
-		sdo++;
+void Mask::SortedDrawObject::SortedRenderFaces(const matrix4* faceTransforms,
+	size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		gs_matrix_set(&faceTransforms[i]);
+		gs_matrix_push();
+		gs_matrix_mul(&sortDrawPart->global);
+		SortedRender();
+		gs_matrix_pop();
 	}
 }
 
+void  Mask::MaskData::ClearSortedDrawObjects() {
+	m_sortedDraws.clear();
+}
+
 void  Mask::MaskData::AddSortedDrawObject(SortedDrawObject* obj) {
 	float z = obj->SortDepth() + obj->m_depth_bias;
-	if (z > BUCKETS_MAX_Z)
-		z = BUCKETS_MAX_Z;
-	if (z < BUCKETS_MIN_Z)
-		z = BUCKETS_MIN_Z;
-	z = (z - BUCKETS_MIN_Z) / (BUCKETS_MAX_Z - BUCKETS_MIN_Z);
-	int idx = (int)(z * (float)(NUM_DRAW_BUCKETS - 1));
-
-	if (m_drawBuckets[idx] != nullptr)
-	{
-		float z2=m_drawBuckets[idx]->SortDepth();
-		if (z < z2)
-		{
-			// add new obj before current
-			obj->nextDrawObject = m_drawBuckets[idx];
-			m_drawBuckets[idx] = obj;
-		}
-		else
-		{
-			// add it after current
-			obj->nextDrawObject = m_drawBuckets[idx]->nextDrawObject;
-			m_drawBuckets[idx]->nextDrawObject = obj;
-		}
-	}
-	else {
-		obj->nextDrawObject = m_drawBuckets[idx]; // which is nullptr
-		m_drawBuckets[idx] = obj;
-	}
+	if (z > SORT_MAX_Z)
+		z = SORT_MAX_Z;
+	if (z < SORT_MIN_Z)
+		z = SORT_MIN_Z;
+	z = (z - SORT_MIN_Z) / (SORT_MAX_Z - SORT_MIN_Z);
+	uint64_t depth = (uint64_t)(z * (float)SORT_DEPTH_MASK);
+
+	uint64_t order = obj->m_render_order < 0 ? 0 : (uint64_t)obj->m_render_order;
+	if (order > SORT_ORDER_MASK)
+		order = SORT_ORDER_MASK;
+
+	SortedDraw draw;
+	draw.key = (order << (SORT_DEPTH_BITS + SORT_MATERIAL_BITS)) |
+		(depth << SORT_MATERIAL_BITS) |
+		(obj->SortMaterialId() & SORT_MATERIAL_MASK);
+	draw.obj = obj;
+	draw.part = obj->sortDrawPart;
+	draw.instanceId = instanceDatas.CurrentId();
+	draw.faceTransforms = m_currentFaceTransforms;
+	m_sortedDraws.push_back(draw);
+}
 
-	obj->instanceId = instanceDatas.CurrentId();
+void Mask::MaskData::SortDrawList() {
+	// lsd radix sort, a byte at a time, skipping the
+	// bytes all keys share (most of the order bits)
+	size_t n = m_sortedDraws.size();
+	if (n < 2)
+		return;
+	m_sortedScratch.resize(n);
+	for (int shift = 0; shift < 64; shift += 8) {
+		size_t counts[256] = { 0 };
+		for (const SortedDraw& d : m_sortedDraws)
+			counts[(d.key >> shift) & 0xFF]++;
+		if (counts[(m_sortedDraws[0].key >> shift) & 0xFF] == n)
+			continue;
 
+		size_t offset = 0;
+		for (int b = 0; b < 256; b++) {
+			size_t c = counts[b];
+			counts[b] = offset;
+			offset += c;
+		}
+		for (const SortedDraw& d : m_sortedDraws)
+			m_sortedScratch[counts[(d.key >> shift) & 0xFF]++] = d;
+		m_sortedDraws.swap(m_sortedScratch);
+	}
 }
 
 void Mask::MaskData::Decompose(const matrix4 *src, vec3 *s, matrix4 *R, vec3 *t)
@@ -632,190 +761,235 @@ void Mask::MaskData::Decompose(const matrix4 *src, vec3 *s, matrix4 *R, vec3 *t)
 
 }
 
-void  Mask::MaskData::PartCalcMatrix(Part *part) {
-
-	// Only if we're dirty
-	if (part->dirty) {
-		Mask::Part* current_part = part;
-
-		// pre-check dirty status for the local chain
-		// we check if *any* of local transform nodes are dirty
-		// if there's one, we will recalculate the local matrix
-		bool local_chain_dirty = true;
-		Mask::Part* temp_part = part;
-		do {
-			if (temp_part->localdirty) {
-				local_chain_dirty = true;
-				break;
-			}
-			temp_part = temp_part->parent.get();
+void Mask::MaskData::CompilePartGraph() {
+	m_graphParts.clear();
+	m_graphParents.clear();
+	m_graphChainStart.clear();
+	m_graphChain.clear();
+	m_graphDirty.clear();
+	m_drawParts.clear();
+
+	// every part that isn't a local transform of another part gets a
+	// node, along with whatever it inherits its transform from
+	std::unordered_map<Part*, int> index;
+	for (const auto& kv : m_parts) {
+		Part* part = kv.second.get();
+		if (part->local_to.length() == 0)
+			CompilePart(part, index);
+		if (part->resources.size() > 0)
+			m_drawParts.push_back(part);
+	}
+	m_graphChainStart.push_back(m_graphChain.size());
+	m_graphDirty.assign(m_graphParts.size(), 1);
+
+	// nothing we computed before can be trusted
+	for (Part* part : m_graphParts)
+		part->localdirty = true;
+	for (Part* part : m_graphChain)
+		part->localdirty = true;
+	m_graphValid = true;
+}
+
+int Mask::MaskData::CompilePart(Part* part, std::unordered_map<Part*, int>& index) {
+	auto it = index.find(part);
+	if (it != index.end()) {
+		if (it->second < 0)
+			PLOG_ERROR("Part '%s' is its own ancestor.", part->name.c_str());
+		return it->second;
+	}
+	index[part] = -1;
+
+	// walk up the local transform chain, the part we inherit our
+	// global transform from is the first one past it
+	std::vector<Part*> chain;
+	Part* parent = part->parent.get();
+	while (parent && parent->local_to.length() > 0 && parent->local_to == part->name) {
+		chain.push_back(parent);
+		parent = parent->parent.get();
+	}
+
+	// parents first
+	int parentIndex = parent ? CompilePart(parent, index) : -1;
+
+	int i = (int)m_graphParts.size();
+	m_graphParts.push_back(part);
+	m_graphParents.push_back(parentIndex);
+	m_graphChainStart.push_back(m_graphChain.size());
+	m_graphChain.insert(m_graphChain.end(), chain.begin(), chain.end());
+	index[part] = i;
+	return i;
+}
+
+void Mask::MaskData::PartCalcLocal(Part* part) {
+	matrix4_identity(&part->local);
+
+	matrix4_scale3f(&part->local, &part->local,
+		part->scale.x, part->scale.y, part->scale.z);
+	if (part->isquat) {
+		matrix4 qm;
+		matrix4_from_quat(&qm, &part->qrotation);
+		matrix4_mul(&part->local, &part->local, &qm);
+	}
+	else {
+		matrix4_rotate_aa4f(&part->local, &part->local,
+			1.0f, 0.0f, 0.0f, part->rotation.x);
+		matrix4_rotate_aa4f(&part->local, &part->local,
+			0.0f, 1.0f, 0.0f, part->rotation.y);
+		matrix4_rotate_aa4f(&part->local, &part->local,
+			0.0f, 0.0f, 1.0f, part->rotation.z);
+	}
+	matrix4_translate3f(&part->local, &part->local,
+		part->position.x, part->position.y, part->position.z);
+}
+
+void Mask::MaskData::PartCalcGlobal(Part* part, const Part* parent) {
+	matrix4_copy(&part->global, &part->local);
+	if (!parent)
+		return;
+
+	if (part->inherit_type == Part::Inherit_RSrs) {
+		matrix4_mul(&part->global, &part->global, &parent->global);
+	}
+	else {
+		/*
+			The other two types of inherit types are more complex, and need
+			several matrix decompositions. The details of the process can
+			be seen in FBX SDK example here:
+			http://help.autodesk.com/cloudhelp/2018/ENU/FBX-Developer-Help/cpp_ref/_transformations_2main_8cxx-example.html
+
+			Naming reference:
+			L: Local
+			G: Global
+			P: Parent
+			M: Matrix
+			v: Vector
+			R: rotation
+			T: translation
+		*/
+
+		// Local Matrix
+		const matrix4 &LM = part->local;
+		vec3 ls_v, lt_v;
+		matrix4 LR, LS;
+		Decompose(&LM, &ls_v, &LR, &lt_v);
+
+		matrix4_identity(&LS);
+		matrix4_scale(&LS, &LS, &ls_v);
+
+		// Parent Global Matrix
+		const matrix4 &PGM = parent->global;
+		vec3 pgs_v, pgt_v;
+		matrix4 PGR;
+		Decompose(&PGM, &pgs_v, &PGR, &pgt_v);
+
+		// pgs_v will have scale information
+		// if we need to have shear information as well
+		// we'll have to find PGS matrix using the following:
+		// PGS = PGM * inv_PGT * inv_PGR
+		matrix4 PGS;
+		matrix4_identity(&PGS);
+		matrix4_scale(&PGS, &PGS, &pgs_v);
+
+		// Global Rotation x Scale Matrix
+		matrix4 GSR;
+		matrix4_identity(&GSR);
+
+		if (part->inherit_type == Part::Inherit_Rrs) {
+			
+			// Parent Local Matrix
+			const matrix4 &PLM = parent->local;
+			vec3 pls_v, plt_v;
+			matrix4 PLR;
+			Decompose(&PLM, &pls_v, &PLR, &plt_v);
+
+			matrix4 PGS_nolocal;
+			matrix4_scale3f(&PGS_nolocal, &PGS, 1 / pls_v.x, 1 / pls_v.y, 1 / pls_v.z);
+
+			// GSR = LS x PGS_nolocal x LR x PGR
+			matrix4_mul(&GSR, &GSR, &LS);
+			matrix4_mul(&GSR, &GSR, &PGS_nolocal);
+			matrix4_mul(&GSR, &GSR, &LR);
+			matrix4_mul(&GSR, &GSR, &PGR);
 		}
-		while (temp_part && temp_part->local_to.length() > 0 && temp_part->local_to == part->name);
-
-
-		if (local_chain_dirty) {
-			do {
-				// Calculate local matrix
-				matrix4_identity(&current_part->local);
-
-				matrix4_scale3f(&current_part->local, &current_part->local,
-					current_part->scale.x, current_part->scale.y, current_part->scale.z);
-				if (current_part->isquat) {
-					matrix4 qm;
-					matrix4_from_quat(&qm, &current_part->qrotation);
-					matrix4_mul(&current_part->local, &current_part->local, &qm);
-				}
-				else {
-					matrix4_rotate_aa4f(&current_part->local, &current_part->local,
-						1.0f, 0.0f, 0.0f, current_part->rotation.x);
-					matrix4_rotate_aa4f(&current_part->local, &current_part->local,
-						0.0f, 1.0f, 0.0f, current_part->rotation.y);
-					matrix4_rotate_aa4f(&current_part->local, &current_part->local,
-						0.0f, 0.0f, 1.0f, current_part->rotation.z);
-				}
-				matrix4_translate3f(&current_part->local, &current_part->local,
-					current_part->position.x, current_part->position.y, current_part->position.z);
-
-				current_part->localdirty = false;
-
-				// a local child node?
-				if (current_part != part)
-					matrix4_mul(&part->local, &part->local, &current_part->local);
-
-				current_part = current_part->parent.get();
-
-			} while (current_part && current_part->local_to.length() > 0 && current_part->local_to == part->name);
+		else if (part->inherit_type == Part::Inherit_RrSs) {
+			// GSR = LS x PGS x LR x PGR
+			matrix4_mul(&GSR, &GSR, &LS);
+			matrix4_mul(&GSR, &GSR, &PGS);
+			matrix4_mul(&GSR, &GSR, &LR);
+			matrix4_mul(&GSR, &GSR, &PGR);
 		}
-		// Calculate global
-		matrix4_copy(&part->global, &part->local);
-		if (current_part) {
-			PartCalcMatrix(current_part);
-			if (part->inherit_type == Part::Inherit_RSrs) {
-				matrix4_mul(&part->global, &part->global, &current_part->global);
-			}
-			else {
-				/*
-					The other two types of inherit types are more complex, and need
-					several matrix decompositions. The details of the process can
-					be seen in FBX SDK example here:
-					http://help.autodesk.com/cloudhelp/2018/ENU/FBX-Developer-Help/cpp_ref/_transformations_2main_8cxx-example.html
-
-					Naming reference:
-					L: Local
-					G: Global
-					P: Parent
-					M: Matrix
-					v: Vector
-					R: rotation
-					T: translation
-				*/
-
-				// Local Matrix
-				const matrix4 &LM = part->local;
-				vec3 ls_v, lt_v;
-				matrix4 LR, LS;
-				Decompose(&LM, &ls_v, &LR, &lt_v);
-
-				matrix4_identity(&LS);
-				matrix4_scale(&LS, &LS, &ls_v);
-
-				// Parent Global Matrix
-				const matrix4 &PGM = current_part->global;
-				vec3 pgs_v, pgt_v;
-				matrix4 PGR;
-				Decompose(&PGM, &pgs_v, &PGR, &pgt_v);
-
-				// pgs_v will have scale information
-				// if we need to have shear information as well
-				// we'll have to find PGS matrix using the following:
-				// PGS = PGM * inv_PGT * inv_PGR
-				matrix4 PGS;
-				matrix4_identity(&PGS);
-				matrix4_scale(&PGS, &PGS, &pgs_v);
-
-				// Global Rotation x Scale Matrix
-				matrix4 GSR;
-				matrix4_identity(&GSR);
-
-				if (part->inherit_type == Part::Inherit_Rrs) {
-					
-					// Parent Local Matrix
-					const matrix4 &PLM = current_part->local;
-					vec3 pls_v, plt_v;
-					matrix4 PLR;
-					Decompose(&PLM, &pls_v, &PLR, &plt_v);
-
-					matrix4 PGS_nolocal;
-					matrix4_scale3f(&PGS_nolocal, &PGS, 1 / pls_v.x, 1 / pls_v.y, 1 / pls_v.z);
-
-					// GSR = LS x PGS_nolocal x LR x PGR
-					matrix4_mul(&GSR, &GSR, &LS);
-					matrix4_mul(&GSR, &GSR, &PGS_nolocal);
-					matrix4_mul(&GSR, &GSR, &LR);
-					matrix4_mul(&GSR, &GSR, &PGR);
-				}
-				else if (part->inherit_type == Part::Inherit_RrSs) {
-					// GSR = LS x PGS x LR x PGR
-					matrix4_mul(&GSR, &GSR, &LS);
-					matrix4_mul(&GSR, &GSR, &PGS);
-					matrix4_mul(&GSR, &GSR, &LR);
-					matrix4_mul(&GSR, &GSR, &PGR);
-				}
-
-				vec3 gt_v;
-				matrix4 GT;
-				vec3_transform(&gt_v, &lt_v, &PGM);
-
-				matrix4_identity(&GT);
-				matrix4_translate3v(&GT, &GT, &gt_v);
-
-				matrix4_mul(&part->global, &GSR, &GT);
 
-			}
-		}
-		part->dirty = false;
+		vec3 gt_v;
+		matrix4 GT;
+		vec3_transform(&gt_v, &lt_v, &PGM);
+
+		matrix4_identity(&GT);
+		matrix4_translate3v(&GT, &GT, &gt_v);
+
+		matrix4_mul(&part->global, &GSR, &GT);
 	}
 }
 
 void Mask::MaskData::Tick(float time) {
 	// update animations with the first Part
-	Part* p = nullptr;
-	for (auto aakv : m_animations) {
+	Part* p = m_parts.size() > 0 ? m_parts.begin()->second.get() : nullptr;
+	for (const auto& aakv : m_animations) {
 		if (aakv.second) {
-			if (!p) {
-				for (auto kv : m_parts) {
-					p = kv.second.get();
-					break;
-				}
-			}
 			aakv.second->Update(p, time);
 		}
 	}
 
-	// mark parts dirty
-	for (auto kv : m_parts) {
-		kv.second->dirty = true;
-	}
-	// calculate transforms 
-	for (auto kv : m_parts) {
-		if (kv.second->local_to.length() == 0)
-		{
-			PartCalcMatrix(kv.second.get());
+	if (!m_graphValid)
+		CompilePartGraph();
+
+	// calculate transforms, parents before children
+	// - only parts whose local transform changed, or whose parent
+	//   moved, get recalculated; the rest keep last frame's global
+	size_t numNodes = m_graphParts.size();
+	for (size_t i = 0; i < numNodes; i++) {
+		Part* part = m_graphParts[i];
+		size_t chainStart = m_graphChainStart[i];
+		size_t chainEnd = m_graphChainStart[i + 1];
+
+		bool localDirty = part->localdirty;
+		for (size_t c = chainStart; c < chainEnd && !localDirty; c++)
+			localDirty = m_graphChain[c]->localdirty;
+
+		int parent = m_graphParents[i];
+		bool dirty = localDirty || (parent >= 0 && m_graphDirty[parent]);
+		m_graphDirty[i] = dirty;
+		if (!dirty)
+			continue;
+
+		if (localDirty) {
+			PartCalcLocal(part);
+			for (size_t c = chainStart; c < chainEnd; c++) {
+				Part* node = m_graphChain[c];
+				PartCalcLocal(node);
+				matrix4_mul(&part->local, &part->local, &node->local);
+			}
 		}
+		PartCalcGlobal(part, parent < 0 ? nullptr : m_graphParts[parent]);
 	}
+	// cleared afterwards, a part can be both in the graph and in
+	// another part's local chain
+	for (Part* part : m_graphParts)
+		part->localdirty = false;
+	for (Part* part : m_graphChain)
+		part->localdirty = false;
+
 	// update part resources
-	for (auto kv : m_parts) {
-		instanceDatas.Push(kv.second->hash_id);
-		for (auto it = kv.second->resources.begin();
-			it != kv.second->resources.end(); it++) {
-			(*it)->Update(kv.second.get(), time);
+	for (Part* part : m_drawParts) {
+		instanceDatas.Push(part->hash_id);
+		for (const auto& res : part->resources) {
+			res->Update(part, time);
 		}
 		instanceDatas.Pop();
 	}
 	
 	// DO INTRO ANIMATION FADING
 	if (m_isIntroAnim) {
-		std::shared_ptr<Mask::AlphaInstanceData> aid =
+		Mask::AlphaInstanceData* aid =
 			instanceDatas.GetData<Mask::AlphaInstanceData>(Mask::AlphaInstanceDataId);
 
 		float DF = m_introDuration - m_introFadeTime;
@@ -878,71 +1052,54 @@ void Mask::MaskData::Render(const smll::DetectionResults &faces, int width, int
 	// save a matrix for face transforms
 	gs_matrix_push();
 
-	// OPAQUE
-	for (auto kv : m_parts) {
-		if (kv.second->resources.size() == 0)
-			continue;
-		instanceDatas.Push(kv.second->hash_id);
-		for (auto  it = kv.second->resources.begin();
-			it != kv.second->resources.end(); it++) {
-
-			if ((*it)->IsDepthOnly() != depthOnly) continue;
-
-			bool billboard = (*it)->IsRotationDisabled();
-
+	// the face transforms are the same for every resource, work them
+	// out once up front
+	for (int sp = 0; sp < 2; sp++) {
+		for (int bb = 0; bb < 2; bb++) {
+			std::vector<matrix4>& transforms = m_faceTransforms[sp][bb];
+			transforms.resize(faces.length);
 			for (int i = 0; i < faces.length; i++) {
-				// NOTE for some reason, some masks
-				// have their depth head set to static
-				if ((*it)->IsStatic() && (*it)->IsDepthOnly() == false)
-					SetTransform(faces[i].startPose, billboard);
-				else
-					SetTransform(faces[i].pose, billboard);
-
-				gs_matrix_push();
-				gs_matrix_mul(&kv.second->global);
-
-				(*it)->Render(kv.second.get());
-
-				gs_matrix_pop();
+				SetTransform(sp ? faces[i].startPose : faces[i].pose, bb != 0);
+				gs_matrix_get(&transforms[i]);
 			}
 		}
+	}
+
+	// OPAQUE
+	if (!m_graphValid)
+		CompilePartGraph();
+	for (Part* part : m_drawParts) {
+		instanceDatas.Push(part->hash_id);
+		for (const auto& res : part->resources) {
+
+			if (res->IsDepthOnly() != depthOnly) continue;
+
+			// NOTE for some reason, some masks
+			// have their depth head set to static
+			bool startPose = res->IsStatic() && res->IsDepthOnly() == false;
+			bool billboard = res->IsRotationDisabled();
+			const std::vector<matrix4>& transforms = m_faceTransforms[startPose][billboard];
+
+			m_currentFaceTransforms = &transforms;
+			res->RenderFaces(part, transforms.data(), transforms.size());
+		}
 		instanceDatas.Pop();
 	}
+	m_currentFaceTransforms = nullptr;
 
 	// TRANSPARENT
 	gs_blend_function_separate(gs_blend_type::GS_BLEND_SRCALPHA,
 		gs_blend_type::GS_BLEND_INVSRCALPHA, gs_blend_type::GS_BLEND_ONE, gs_blend_type::GS_BLEND_INVSRCALPHA);
 
-	for (size_t current_order = 0; current_order < m_num_render_orders; current_order++)
-	{
-		for (unsigned int i = 0; i < NUM_DRAW_BUCKETS; i++) {
-			SortedDrawObject* sdo = m_drawBuckets[i];
-			Resource::IBase* res = dynamic_cast<Resource::IBase*>(sdo);
-			if (!res) continue; // skip if sdo is not a resource type
-			while (sdo) {
-				if (sdo->m_render_order == current_order)
-				{
-					Part* part = sdo->sortDrawPart;
-					instanceDatas.PushDirect(sdo->instanceId);
-					
-					bool billboard = res->IsRotationDisabled();
-
-					for (int i = 0; i < faces.length; i++) {
-						if (res->IsStatic())
-							SetTransform(faces[i].startPose, billboard);
-						else
-							SetTransform(faces[i].pose, billboard);
-
-						gs_matrix_push();
-						gs_matrix_mul(&part->global);
-						sdo->SortedRender();
-						gs_matrix_pop();
-					}
-					instanceDatas.Pop();
-				}
-				sdo = sdo->nextDrawObject;
-			}
-		}
+	SortDrawList();
+	for (const SortedDraw& draw : m_sortedDraws) {
+		if (!draw.faceTransforms)
+			continue;
+		instanceDatas.PushDirect(draw.instanceId);
+		draw.obj->sortDrawPart = draw.part;
+		draw.obj->SortedRenderFaces(draw.faceTransforms->data(),
+			draw.faceTransforms->size());
+		instanceDatas.Pop();
 	}
 
 	gs_matrix_pop();
@@ -1030,13 +1187,13 @@ std::shared_ptr<Mask::Part> Mask::MaskData::LoadPart(std::string name, obs_data_
 }
 
 float	Mask::MaskData::GetGlobalAlpha() {
-	std::shared_ptr<Mask::AlphaInstanceData> aid =
+	Mask::AlphaInstanceData* aid =
 		instanceDatas.GetData<Mask::AlphaInstanceData>(Mask::AlphaInstanceDataId);
 	return aid->alpha;
 }
 
 void	Mask::MaskData::SetGlobalAlpha(float alpha) {
-	std::shared_ptr<Mask::AlphaInstanceData> aid =
+	Mask::AlphaInstanceData* aid =
 		instanceDatas.GetData<Mask::AlphaInstanceData>(Mask::AlphaInstanceDataId);
 	aid->alpha = alpha;
 }
@@ -1184,7 +1341,7 @@ bool Mask::MaskData::RenderMorphVideo(gs_texture* vidtex, uint32_t width, uint32
 
 	GetMorph();
 
-	std::shared_ptr<Mask::AlphaInstanceData> aid =
+	Mask::AlphaInstanceData* aid =
 		instanceDatas.GetData<Mask::AlphaInstanceData>(Mask::AlphaInstanceDataId);
 
 	// Add an empty morph resource if they want to use 
@@ -1196,7 +1353,7 @@ bool Mask::MaskData::RenderMorphVideo(gs_texture* vidtex, uint32_t width, uint32
 		AddResource(n, r);
 	}
 
-	if (m_morph && aid->alpha > 0.0f && trires.vertexBuffer) {
+	if (m_morph && aid->alpha > 0.0f && trires.IsValid()) {
 		didMorph = true;
 		m_morph->RenderMorphVideo(vidtex, trires);
 	}
@@ -1220,10 +1377,7 @@ bool Mask::MaskData::RenderMorphVideo(gs_texture* vidtex, uint32_t width, uint32
 void Mask::MaskData::ResetInstanceDatas() {
 
 	// reset instance datas
-	std::vector<std::shared_ptr<InstanceData>> idatas = instanceDatas.GetInstances();
-	for (auto id : idatas) {
-		id->Reset();
-	}
+	instanceDatas.ResetAll();
 }
 
 
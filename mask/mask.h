@@ -21,12 +21,15 @@
 #include "mask-resource.h"
 #include "mask-instance-data.h"
 #include "mask-resource-morph.h"
+#include "mask-package.h"
+#include "mask-blob-decoder.h"
 #include "smll/TriangulationResult.hpp"
 #include "smll/DetectionResults.hpp"
 #include <string>
 #include <vector>
 #include <memory>
 #include <queue>
+#include <unordered_map>
 #include <thread>
 extern "C" {
 	#pragma warning( push )
@@ -59,6 +62,8 @@ namespace Mask {
 		// IAnimatable
 		void SetAnimatableValue(float v, 
 			Resource::AnimationChannelType act) override;
+		void SetAnimatableValues(const float* values,
+			const Resource::AnimationChannelType* types, size_t count) override;
 
 		std::vector<std::shared_ptr<Resource::IBase>> resources;
 		std::shared_ptr<Part> parent;
@@ -73,8 +78,9 @@ namespace Mask {
 
 		// Internal
 		matrix4 local, global;
+		// set when position/rotation/scale change, the matrices are
+		// only recalculated for dirty parts and their children
 		bool localdirty;
-		bool dirty;
 		bool isquat;
 		// FBX Inherit Type
 		// RrSs: Apply parent scaling after child scaling.
@@ -91,17 +97,19 @@ namespace Mask {
 			m_render_layer = 0;
 			m_depth_bias = 0.0;
 			sortDrawPart = nullptr;
-			nextDrawObject = nullptr;
-			instanceId = 0;
 		}
 		virtual ~SortedDrawObject() {}
 
 		virtual float	SortDepth() = 0;
 		virtual void	SortedRender() = 0;
+		// sorted render for every face, see IBase::RenderFaces
+		virtual void	SortedRenderFaces(const matrix4* faceTransforms,
+			size_t count);
+		// objects with the same id share render state, and are drawn
+		// together when they sort to the same depth
+		virtual size_t	SortMaterialId() { return 0; }
 
 		Part*				sortDrawPart;
-		SortedDrawObject*	nextDrawObject;
-		size_t				instanceId;
 
 		int		m_render_order;
 		int		m_render_layer;
@@ -132,6 +140,15 @@ namespace Mask {
 		std::shared_ptr<Resource::IBase> GetResource(Resource::Type type, int which);
 		std::shared_ptr<Resource::IBase> RemoveResource(const std::string& name);
 
+		// resource data
+		// - value is a blob reference if we were loaded from a package,
+		//   otherwise the base64 (zlib) string from the json
+		// - resource and field say where it came from, so we can hand
+		//   out data the decoder already got to
+		void GetBlob(const std::string& resource, const std::string& field,
+			const char* value, Blob& blob);
+		bool IsPackage() { return m_package != nullptr; }
+
 		// parts
 		void AddPart(const std::string& name, std::shared_ptr<Part> part);
 		std::shared_ptr<Part> GetPart(const std::string& name);
@@ -194,9 +211,14 @@ namespace Mask {
 
 	private:
 		std::shared_ptr<Part> LoadPart(std::string name, obs_data_t* data);
-		static void PartCalcMatrix(Part *part);
+		void StartDecoder();
+		void CompilePartGraph();
+		int CompilePart(Part* part, std::unordered_map<Part*, int>& index);
+		static void PartCalcLocal(Part* part);
+		static void PartCalcGlobal(Part* part, const Part* parent);
 		static void Decompose(const matrix4 *src, vec3 *s, matrix4 *R, vec3 *t);
 		void SetTransform(const smll::ThreeDPose& pose, bool billboard);
+		void SortDrawList();
 
 		struct {
 			std::string name;
@@ -208,10 +230,48 @@ namespace Mask {
 		std::map<std::string, std::shared_ptr<Part>> m_parts;
 		std::map<std::string, std::shared_ptr<Resource::Animation>> m_animations;
 		obs_data_t* m_data;
+		std::shared_ptr<Package> m_package;
 		std::shared_ptr<Mask::Part> m_partWorld;
-		SortedDrawObject**	m_drawBuckets;
+
+		// part graph
+		// - the part hierarchy flattened at load time, parents always
+		//   come before their children, so transforms are one linear
+		//   pass with no recursion or map walking
+		// - the local-to nodes of part i are m_graphChain[
+		//   m_graphChainStart[i] .. m_graphChainStart[i+1] ]
+		// - m_graphDirty is set for parts recalculated this tick, so
+		//   children know to follow
+		// - m_drawParts are the parts with resources, in update/render order
+		std::vector<Part*>		m_graphParts;
+		std::vector<int>		m_graphParents;
+		std::vector<size_t>		m_graphChainStart;
+		std::vector<Part*>		m_graphChain;
+		std::vector<uint8_t>	m_graphDirty;
+		std::vector<Part*>		m_drawParts;
+		bool					m_graphValid;
+
+		// resource data decoded ahead on worker threads, only while loading
+		BlobDecoder			m_decoder;
 		Resource::Morph*	m_morph;
 
+		// face transforms for this render, by [startPose][billboard]
+		std::vector<matrix4>	m_faceTransforms[2][2];
+
+		// sorted draw list
+		// - everything added during the opaque pass, keyed by render
+		//   order, quantized depth and material, radix sorted and then
+		//   drawn back to front in one go
+		struct SortedDraw {
+			uint64_t					key;
+			SortedDrawObject*			obj;
+			Part*						part;
+			size_t						instanceId;
+			const std::vector<matrix4>*	faceTransforms;
+		};
+		std::vector<SortedDraw>		m_sortedDraws;
+		std::vector<SortedDraw>		m_sortedScratch;
+		const std::vector<matrix4>*	m_currentFaceTransforms;
+
 		// video light data
 		gs_texture_t* m_vidLightTex;
 
@@ -16,10 +16,9 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
-#include <Windows.h>
-
 #include "base64.h"
 #include <iostream>
+#include <cstring>
 
 namespace zlib {
 #include <zlib.h>
@@ -32,12 +31,30 @@ static const unsigned char ZLIB_BYTE2 = 156;
 
 static const std::string base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-static inline bool is_base64(uint8_t c) {
-	return (isalnum(c) || (c == '+') || (c == '/'));
-}
+// decoding table: base64 char -> 6 bit value, 0xFF for anything else
+static const uint8_t base64_values[256] = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+	0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+	0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+static const uint8_t BASE64_INVALID = 0xFF;
 
 std::string base64_encode(uint8_t const* buf, size_t bufLen) {
 	std::string ret;
+	ret.reserve(((bufLen + 2) / 3) * 4);
 	int i = 0;
 	int j = 0;
 	uint8_t char_array_3[3];
@@ -77,45 +94,64 @@ std::string base64_encode(uint8_t const* buf, size_t bufLen) {
 }
 
 
-void base64_decode(std::string const& encoded_string, std::vector<uint8_t>& ret) {
-	size_t in_len = encoded_string.size();
-	int i = 0;
-	int j = 0;
-	int in_ = 0;
-	uint8_t char_array_4[4], char_array_3[3];
-
-	while (in_len-- && (encoded_string[in_] != '=') && is_base64(encoded_string[in_])) {
-		char_array_4[i++] = encoded_string[in_]; in_++;
-		if (i == 4) {
-			for (i = 0; i < 4; i++)
-				char_array_4[i] = (uint8_t)base64_chars.find(char_array_4[i]);
-
-			char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-			char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-			char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+size_t base64_decoded_size(const char* inbuf, size_t len) {
+	// padding doesn't decode to anything
+	if (len > 0 && inbuf[len - 1] == '=') len--;
+	if (len > 0 && inbuf[len - 1] == '=') len--;
+	size_t rem = len % 4;
+	return (len / 4) * 3 + (rem ? rem - 1 : 0);
+}
 
-			for (i = 0; (i < 3); i++)
-				ret.push_back(char_array_3[i]);
-			i = 0;
-		}
+size_t base64_decode(const char* inbuf, size_t len, uint8_t* outbuf) {
+	const uint8_t* in = (const uint8_t*)inbuf;
+	const uint8_t* end = in + len;
+	uint8_t* out = outbuf;
+
+	// whole quads
+	while (end - in >= 4) {
+		uint8_t a = base64_values[in[0]];
+		uint8_t b = base64_values[in[1]];
+		uint8_t c = base64_values[in[2]];
+		uint8_t d = base64_values[in[3]];
+		// any invalid char has the top bit set
+		if ((a | b | c | d) & 0x80)
+			break;
+		uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+		out[0] = (uint8_t)(v >> 16);
+		out[1] = (uint8_t)(v >> 8);
+		out[2] = (uint8_t)v;
+		in += 4;
+		out += 3;
 	}
 
-	if (i) {
-		for (j = i; j < 4; j++)
-			char_array_4[j] = 0;
+	// tail, or a quad with padding (or garbage) in it:
+	// decode whatever is valid up to the first bad char
+	uint8_t q[4] = { 0, 0, 0, 0 };
+	int i = 0;
+	while (in < end && i < 4 && base64_values[*in] != BASE64_INVALID)
+		q[i++] = base64_values[*in++];
+	if (i > 1) {
+		uint32_t v = (q[0] << 18) | (q[1] << 12) | (q[2] << 6) | q[3];
+		out[0] = (uint8_t)(v >> 16);
+		if (i > 2)
+			out[1] = (uint8_t)(v >> 8);
+		if (i > 3)
+			out[2] = (uint8_t)v;
+		out += i - 1;
+	}
 
-		for (j = 0; j < 4; j++)
-			char_array_4[j] = (uint8_t)base64_chars.find(char_array_4[j]);
+	return out - outbuf;
+}
 
-		char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-		char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-		char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+void base64_decode(const char* inbuf, size_t len, std::vector<uint8_t>& outbuf) {
+	size_t start = outbuf.size();
+	outbuf.resize(start + base64_decoded_size(inbuf, len));
+	size_t written = base64_decode(inbuf, len, outbuf.data() + start);
+	outbuf.resize(start + written);
+}
 
-		for (j = 0; (j < i - 1); j++)
-			ret.push_back(char_array_3[j]);
-	}
-	// yield
-	::Sleep(0);
+void base64_decode(std::string const& inbuf, std::vector<uint8_t>& outbuf) {
+	base64_decode(inbuf.data(), inbuf.size(), outbuf);
 }
 
 std::string base64_encodeZ(uint8_t const* buf, size_t bufLen) {
@@ -140,30 +176,97 @@ std::string base64_encodeZ(uint8_t const* buf, size_t bufLen) {
 	return base64_encode(dest.data(), dest.size());
 }
 
-void base64_decodeZ(std::string const& encoded, std::vector<uint8_t>& decompressed) {
-	// base64 decode first
-	std::vector<uint8_t> decoded;
-	base64_decode(encoded, decoded);
+// base64 chars we decode per chunk when streaming into zlib
+static const size_t BASE64_CHUNK_CHARS = 16 * 1024;
+
+// length of the base64 we'd actually decode: up to any padding,
+// whitespace or other non-base64 char
+static size_t base64_span(const char* encoded, size_t len) {
+	const uint8_t* in = (const uint8_t*)encoded;
+	size_t n = 0;
+	while (n < len && base64_values[in[n]] != BASE64_INVALID)
+		n++;
+	return n;
+}
 
-	// only decompress if this is zlib data
-	if (((unsigned char*)decoded.data())[0] == ZLIB_BYTE1 &&
-		((unsigned char*)decoded.data())[1] == ZLIB_BYTE2) {
+static bool base64_is_zlib(const char* encoded, size_t len) {
+	// first 2 bytes are in the first quad
+	uint8_t head[3];
+	if (base64_decoded_size(encoded, len) <= 2 + sizeof(size_t) ||
+		base64_decode(encoded, 4, head) < 2)
+		return false;
+	return head[0] == ZLIB_BYTE1 && head[1] == ZLIB_BYTE2;
+}
 
-		// get original size from end of data
-		size_t destLenT;
-		memcpy(&destLenT,
-			decoded.data() + decoded.size() - sizeof(size_t), sizeof(size_t));
+size_t base64_decodeZ_size(const char* encoded, size_t len) {
+	len = base64_span(encoded, len);
+	size_t decodedLen = base64_decoded_size(encoded, len);
+	if (!base64_is_zlib(encoded, len))
+		return decodedLen;
+
+	// original size is at the end of the data, only decode the
+	// quads it lives in
+	size_t sizePos = decodedLen - sizeof(size_t);
+	size_t quad = sizePos / 3;
+	uint8_t tail[sizeof(size_t) + 8];
+	size_t tailLen = base64_decode(encoded + quad * 4, len - quad * 4, tail);
+	size_t offset = sizePos - quad * 3;
+	if (tailLen < offset + sizeof(size_t))
+		return 0;
+	size_t destLen;
+	memcpy(&destLen, tail + offset, sizeof(size_t));
+	return destLen;
+}
 
-		zlib::uLongf destLen = (zlib::uLongf)destLenT;
-		zlib::uLongf srcLen = (zlib::uLongf)(decoded.size() - sizeof(size_t));
+size_t base64_decodeZ(const char* encoded, size_t len, uint8_t* outbuf, size_t outlen) {
+	len = base64_span(encoded, len);
 
-		// now decompress with zlib
-		decompressed.resize(destLen);
-		zlib::uncompress((zlib::Bytef*)decompressed.data(), &destLen,
-			(zlib::Bytef*)decoded.data(), srcLen);
+	// not zlib? just decode it
+	if (!base64_is_zlib(encoded, len)) {
+		if (base64_decoded_size(encoded, len) > outlen)
+			return 0;
+		return base64_decode(encoded, len, outbuf);
 	}
-	// yield
-	::Sleep(0);
+
+	zlib::z_stream strm;
+	memset(&strm, 0, sizeof(strm));
+	if (zlib::inflateInit_(&strm, ZLIB_VERSION, (int)sizeof(zlib::z_stream)) != Z_OK)
+		return 0;
+	strm.next_out = (zlib::Bytef*)outbuf;
+	strm.avail_out = (zlib::uInt)outlen;
+
+	// decode a chunk at a time, straight into inflate
+	// - the size at the end of the data comes after the end of the
+	//   zlib stream, so inflate stops before it gets there
+	uint8_t chunk[BASE64_CHUNK_CHARS / 4 * 3];
+	int ret = Z_OK;
+	size_t pos = 0;
+	while (pos < len && ret == Z_OK) {
+		size_t n = len - pos;
+		if (n > BASE64_CHUNK_CHARS)
+			n = BASE64_CHUNK_CHARS;
+		size_t decoded = base64_decode(encoded + pos, n, chunk);
+		strm.next_in = (zlib::Bytef*)chunk;
+		strm.avail_in = (zlib::uInt)decoded;
+		ret = zlib::inflate(&strm, Z_NO_FLUSH);
+		// stopped early on a bad char?
+		if (decoded != base64_decoded_size(encoded + pos, n))
+			break;
+		pos += n;
+	}
+	size_t written = (size_t)strm.total_out;
+	zlib::inflateEnd(&strm);
+	return written;
+}
+
+void base64_decodeZ(const char* encoded, size_t len, std::vector<uint8_t>& decompressed) {
+	decompressed.resize(base64_decodeZ_size(encoded, len));
+	size_t written = base64_decodeZ(encoded, len, decompressed.data(), decompressed.size());
+	decompressed.resize(written);
+}
+
+void base64_decodeZ(std::string const& encoded, std::vector<uint8_t>& decompressed) {
+	base64_decodeZ(encoded.data(), encoded.size(), decompressed);
 }
 
 size_t zlib_size(const std::vector<uint8_t>& decoded) {
@@ -199,7 +302,5 @@ void zlib_decode(const std::vector<uint8_t>& decoded, uint8_t* outbuf) {
 		zlib::uncompress((zlib::Bytef*)outbuf, &destLen,
 			(zlib::Bytef*)decoded.data(), srcLen);
 	}
-	// yield
-	::Sleep(0);
 }
 
@@ -25,12 +25,29 @@
 // Shamelessly taken from: https://stackoverflow.com/questions/180947/base64-decode-snippet-in-c
 std::string base64_encode(uint8_t const* raw_bytes, size_t in_len);
 void base64_decode(std::string const& inbuf, std::vector<uint8_t>& outbuf);
+void base64_decode(const char* inbuf, size_t len, std::vector<uint8_t>& outbuf);
+
+// Decoding into a buffer you allocated yourself
+// - base64_decoded_size is exact for well formed input
+// - base64_decode returns how many bytes it actually wrote, it stops
+//   at padding or the first non-base64 char
+size_t base64_decoded_size(const char* inbuf, size_t len);
+size_t base64_decode(const char* inbuf, size_t len, uint8_t* outbuf);
 
 // Added zlib compression
 // Note: base64_decodeZ checks if data is zlib encoded, and returns 
 //       the data correctly if it is not.
 std::string base64_encodeZ(uint8_t const* buf, size_t bufLen);
 void base64_decodeZ(std::string const& inbuf, std::vector<uint8_t>& outbuf);
+void base64_decodeZ(const char* inbuf, size_t len, std::vector<uint8_t>& outbuf);
+
+// Streaming base64 + zlib decode into your own buffer
+// - base64_decodeZ_size gives the final (decompressed) size
+// - both stop at padding, whitespace or the first non-base64 char
+// - base64_decodeZ feeds small base64 decoded chunks straight into
+//   inflate, so the compressed data is never in memory all at once
+size_t base64_decodeZ_size(const char* inbuf, size_t len);
+size_t base64_decodeZ(const char* inbuf, size_t len, uint8_t* outbuf, size_t outlen);
 
 // If you need to alloc your buffer yourself (for alignment, say)
 // use base64_decode then use these methods
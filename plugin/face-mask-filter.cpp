@@ -118,7 +118,7 @@ Plugin::FaceMaskFilter::Instance::Instance(obs_data_t *data, obs_source_t *sourc
 	isActive(true), isVisible(true), videoTicked(true),
 	taskHandle(NULL), alertActivate(true),  alertDuration(10.0f),
 	alertElapsedTime(BIG_FLOAT), alertTriggered(false), alertShown(false), alertsLoaded(false),
-	demoCurrentMask(0), smllFaceDetector(nullptr), caching_done(false),
+	demoCurrentMask(0), smllFaceDetector(nullptr), caching_done(false), preloadBudget(0),
 	demoModeInDelay(false), demoModeGenPreviews(false),	demoModeSavingFrames(false), loading_mask(false),
 	drawMask(true),	drawAlert(false), drawFaces(false), drawMorphTris(false), drawFDRect(false), drawMotionRect(false),
 	filterPreviewMode(false), autoBGRemoval(false), cartoonMode(false), testingStage(nullptr), testMode(false), antialiasing_effect(nullptr), color_grading_filter_effect(nullptr),
@@ -311,6 +311,7 @@ Plugin::FaceMaskFilter::Instance::~Instance() {
 		gs_stagesurface_destroy(testingStage);
 
 	maskData = nullptr;
+	preloadedMasks.clear();
 	obs_leave_graphics();
 
 	// also destroy cache
@@ -360,6 +361,11 @@ void Plugin::FaceMaskFilter::Instance::get_defaults(obs_data_t *data) {
 	bfree(defMaskFolder);
 	
 	obs_data_set_default_int(data, P_ANTI_ALIASING, NO_ANTI_ALIASING);
+	obs_data_set_default_int(data, P_PERF_PROFILE, smll::PERF_PROFILE_MANUAL);
+
+	// PRELOADING
+	obs_data_set_default_string(data, P_PRELOAD, "");
+	obs_data_set_default_int(data, P_PRELOAD_BUDGET, 256);
 
 	// ALERTS
 	obs_data_set_default_bool(data, P_ALERT_ACTIVATE, false);
@@ -430,7 +436,7 @@ static void add_json_file_property(obs_properties_t *props, const char* name,
 	char* defFolder = obs_module_file(folder);
 	obs_property_t* p = obs_properties_add_path(props, name, P_TRANSLATE(name),
 		obs_path_type::OBS_PATH_FILE,
-		"Face Mask JSON (*.json)", defFolder);
+		"Face Mask (*.json *" MASK_PACKAGE_EXTENSION ")", defFolder);
 	std::string n = name; n += ".Description";
 	obs_property_set_long_description(p, P_TRANSLATE(n.c_str()));
 	bfree(defFolder);
@@ -456,6 +462,13 @@ static void add_folder_property(obs_properties_t *props, const char* name,
 	obs_property_set_long_description(p, P_TRANSLATE(n.c_str()));
 }
 
+static void add_int_slider(obs_properties_t *props, const char* name, int min, int max, int step) {
+	obs_property_t* p = obs_properties_add_int_slider(props, name,
+		P_TRANSLATE(name), min, max, step);
+	std::string n = name; n += ".Description";
+	obs_property_set_long_description(p, P_TRANSLATE(n.c_str()));
+}
+
 static void add_float_slider(obs_properties_t *props, const char* name, float min, float max, float step) {
 	obs_property_t* p = obs_properties_add_float_slider(props, name,
 		P_TRANSLATE(name), min, max, step);
@@ -490,7 +503,7 @@ bool Plugin::FaceMaskFilter::Instance::SendSourceTextureToThread(gs_texture* sou
 			detection.frame.active = true;
 			detection.frame.timestamp = sourceTimestamp;
 
-			detection.frame.resizeWidth = smll::Config::singleton().get_int(smll::CONFIG_INT_FACE_DETECT_WIDTH);
+			detection.frame.resizeWidth = detectorConfig.snapshot()->faceDetectWidth;
 			detection.frame.resizeHeight = (int)((float)detection.frame.resizeWidth * (float)baseHeight / (float)baseWidth);
 
 			// (re) allocate capture texture if necessary
@@ -550,6 +563,10 @@ void Plugin::FaceMaskFilter::Instance::get_properties(obs_properties_t *props) {
 	add_bool_property(props, P_ALERT_ACTIVATE);
 	add_float_slider(props, P_ALERT_DURATION, 10.0f, 60.0f, 0.1f);
 
+	// upcoming masks
+	add_text_property(props, P_PRELOAD);
+	add_int_slider(props, P_PRELOAD_BUDGET, 0, 2048, 16);
+
 	add_bool_property(props, P_TEST_MODE);
 	add_bool_property(props, P_LOG_MODE);
 
@@ -563,6 +580,14 @@ void Plugin::FaceMaskFilter::Instance::get_properties(obs_properties_t *props) {
 	obs_property_list_add_int(list, P_TRANSLATE(P_SSAA_ANTI_ALIASING), SSAA_ANTI_ALIASING);
 	obs_property_list_add_int(list, P_TRANSLATE(P_FXAA_ANTI_ALIASING), FXAA_ANTI_ALIASING);
 
+	// performance profile
+	list = add_int_list_property(props, P_PERF_PROFILE);
+	obs_property_list_add_int(list, P_TRANSLATE(P_PERF_MANUAL), smll::PERF_PROFILE_MANUAL);
+	obs_property_list_add_int(list, P_TRANSLATE(P_PERF_ECO), smll::PERF_PROFILE_ECO);
+	obs_property_list_add_int(list, P_TRANSLATE(P_PERF_BALANCED), smll::PERF_PROFILE_BALANCED);
+	obs_property_list_add_int(list, P_TRANSLATE(P_PERF_QUALITY), smll::PERF_PROFILE_QUALITY);
+	obs_property_list_add_int(list, P_TRANSLATE(P_PERF_AUTO), smll::PERF_PROFILE_AUTO);
+
 	// bg removal
 	add_bool_property(props, P_BGREMOVAL);
 
@@ -593,7 +618,10 @@ void Plugin::FaceMaskFilter::Instance::get_properties(obs_properties_t *props) {
 	add_bool_property(props, P_DRAWCROPRECT);
 
 	// add advanced configuration params
-	smll::Config::singleton().get_properties(props);
+	// - ours, not the shared config: each instance has its own
+	obs_data_t* settings = obs_source_get_settings(source);
+	detectorConfig.get_properties(props, settings);
+	obs_data_release(settings);
 #else
 	//for fixing empty properties bug for endless loading
 	add_dummy_property(props);
@@ -642,10 +670,10 @@ void Plugin::FaceMaskFilter::Instance::update(void *ptr, obs_data_t *data) {
 
 void Plugin::FaceMaskFilter::Instance::update(obs_data_t *data) {
 
-#if !defined(PUBLIC_RELEASE)
 	// update advanced properties
-	smll::Config::singleton().update_properties(data);
-#endif
+	// - release builds don't show them, but still apply any the source
+	//   was given, anything unset keeps the config's defaults
+	detectorConfig.update_properties(data);
 
 	// mask file names
 	std::replace(maskFolder.begin(), maskFolder.end(), '/', '\\');
@@ -681,6 +709,34 @@ void Plugin::FaceMaskFilter::Instance::update(obs_data_t *data) {
 		maskFilePath = newMaskFilePath;
 	}
 
+	// Preload playlist
+	{
+		std::vector<std::string> playlist;
+		std::string preload = obs_data_get_string(data, P_PRELOAD);
+		std::replace(preload.begin(), preload.end(), '/', '\\');
+		std::replace(preload.begin(), preload.end(), ';', '|');
+		for (std::string fn : Utils::split(preload, '|')) {
+			fn.erase(0, fn.find_first_not_of(" \t\r\n"));
+			fn.erase(fn.find_last_not_of(" \t\r\n") + 1);
+			if (fn.empty())
+				continue;
+			// plain names are in the mask folder
+			if (fn.find('\\') == std::string::npos)
+				playlist.push_back(MaskPath(maskFolder, fn));
+			else
+				playlist.push_back(fn);
+		}
+		std::unique_lock<std::mutex> lock(preloadMutex);
+		if (playlist != preloadPlaylist) {
+			// sizes only change with the playlist, not every pass
+			preloadSizes.clear();
+			for (const std::string& fn : playlist)
+				preloadSizes[fn] = Utils::FileSize(fn);
+		}
+		preloadPlaylist = playlist;
+		preloadBudget = (size_t)obs_data_get_int(data, P_PRELOAD_BUDGET) * 1024 * 1024;
+	}
+
 	// Flags
 	autoBGRemoval = obs_data_get_bool(data, P_BGREMOVAL);
 	cartoonMode = obs_data_get_bool(data, P_CARTOON);
@@ -689,6 +745,9 @@ void Plugin::FaceMaskFilter::Instance::update(obs_data_t *data) {
 	// Anti-aliasing
 	antialiasing_method = (int)obs_data_get_int(data, P_ANTI_ALIASING);
 
+	// Performance profile
+	detectorConfig.SetPerfProfile((smll::PerfProfileID)obs_data_get_int(data, P_PERF_PROFILE));
+
 	// Alerts
 	bool lastAlertActivate = alertActivate;
 	alertActivate = obs_data_get_bool(data, P_ALERT_ACTIVATE);
@@ -914,8 +973,13 @@ void Plugin::FaceMaskFilter::Instance::video_render(gs_effect_t *effect) {
 		if(smllFaceDetector)
 			smllFaceDetector->ResetFaces();
 		faces.length = 0;
-		// make sure file loads still happen
-		checkForMaskUnloading();
+		// make sure file loads still happen, unless the loading
+		// thread has the mask right now, then next frame will do
+		{
+			std::unique_lock<std::mutex> masklock(maskDataMutex, std::try_to_lock);
+			if (masklock.owns_lock())
+				checkForMaskUnloading();
+		}
 		obs_source_skip_video_filter(source);
 		return;
 	}
@@ -997,11 +1061,15 @@ void Plugin::FaceMaskFilter::Instance::video_render(gs_effect_t *effect) {
 		mask_data->SetGlobalAlpha(maskAlpha);
 	}
 
-	// some reasons triangulation should be destroyed
+	// some reasons triangulation should be invalidated
 	if (!mask_data || faces.length == 0) {
-		triangulation.DestroyBuffers();
+		triangulation.Invalidate();
 	}
 
+	// upload the latest triangulation
+	triangulation.buildLines = drawMorphTris;
+	triangulation.UploadBuffers();
+
 	if (color_grading_filter_effect && mask_data && mask_data->NeedsPBRLighting()) {
 		int current_height = baseHeight;
 		int current_width = baseWidth;
@@ -1012,12 +1080,20 @@ void Plugin::FaceMaskFilter::Instance::video_render(gs_effect_t *effect) {
 
 		float gamma_weight = 2.2;
 		int reduction_step = 2;
+		int first_reduction_step = detectorConfig.snapshot()->lightingReduction;
 		vec2 texel_size;
 
 		while (current_width > 4 && current_height > 4) {
 
+			// first pass might skip some levels, depending on profile
+			reduction_step = first_pass ? first_reduction_step : 2;
 			current_width /= reduction_step;
 			current_height /= reduction_step;
+			// a big first step can take small frames all the way to 0
+			if (current_width < 1)
+				current_width = 1;
+			if (current_height < 1)
+				current_height = 1;
 
 			current_texrender = current_level % 2 == 0 ? vidLightTexRender : vidLightTexRenderBack;
 
@@ -1075,7 +1151,8 @@ void Plugin::FaceMaskFilter::Instance::video_render(gs_effect_t *effect) {
 
 	// Get current method to use for anti-aliasing
 	if (antialiasing_method == NO_ANTI_ALIASING ||
-		antialiasing_method == FXAA_ANTI_ALIASING)
+		antialiasing_method == FXAA_ANTI_ALIASING ||
+		!detectorConfig.snapshot()->allowSSAA)
 		m_scale_rate = 1;
 	else
 		m_scale_rate = SSAA_UPSAMPLE_FACTOR;
@@ -1105,7 +1182,7 @@ void Plugin::FaceMaskFilter::Instance::video_render(gs_effect_t *effect) {
 
 					// Check here for no morph
 					if (!mask_data->GetMorph()) {
-						triangulation.DestroyBuffers();
+						triangulation.Invalidate();
 					}
 
 					if (mask_data->NeedsPBRLighting()) {
@@ -1252,7 +1329,7 @@ void Plugin::FaceMaskFilter::Instance::video_render(gs_effect_t *effect) {
 #if !defined(PUBLIC_RELEASE)
 	// draw face detection data
 	if (drawFaces)
-		smllRenderer->DrawFaces(faces);
+		smllRenderer->DrawFaces(faces, *detectorConfig.snapshot());
 #endif
 
 	// draw crop rectangles
@@ -1298,13 +1375,34 @@ void Plugin::FaceMaskFilter::Instance::video_render(gs_effect_t *effect) {
 
 void Plugin::FaceMaskFilter::Instance::checkForMaskUnloading() {
 	// Check for file/folder changes
-	if (currentMaskFilename != maskFilename) {
+	if (currentMaskFilename == maskFilename &&
+		currentMaskFolder == maskFolder)
+		return;
+
+	// preloaded? then switching is just a swap
+	std::string maskFn = MaskPath(maskFolder, maskFilename);
+	std::unique_lock<std::mutex> lock(preloadMutex);
+	auto preloaded = preloadedMasks.find(maskFn);
+	if (loading_mask || preloaded == preloadedMasks.end()) {
 		maskData = nullptr;
+		return;
 	}
+	std::unique_ptr<Mask::MaskData> next = std::move(preloaded->second.data);
+	preloadedMasks.erase(preloaded);
 
-	if (currentMaskFolder != maskFolder) {
-		maskData = nullptr;
+	// keep the current one around if we'll need it again
+	std::string currentFn = MaskPath(currentMaskFolder, currentMaskFilename);
+	if (maskData && std::find(preloadPlaylist.begin(), preloadPlaylist.end(),
+		currentFn) != preloadPlaylist.end()) {
+		PreloadedMask& current = preloadedMasks[currentFn];
+		current.data = std::move(maskData);
+		current.size = preloadSizes[currentFn];
 	}
+
+	maskData = std::move(next);
+	maskData->Rewind();
+	currentMaskFilename = maskFilename;
+	currentMaskFolder = maskFolder;
 }
 
 void Plugin::FaceMaskFilter::Instance::demoModeRender(gs_texture* vidTex, gs_texture* maskTex, 
@@ -1446,7 +1544,7 @@ int32_t Plugin::FaceMaskFilter::Instance::LocalThreadMain() {
 
 	obs_source_t *parent = obs_filter_get_parent(source);
 
-	smllFaceDetector = new smll::FaceDetector();
+	smllFaceDetector = new smll::FaceDetector(detectorConfig);
 
 	// run until we're shut down
 	TimeStamp lastTimestamp;
@@ -1504,8 +1602,6 @@ int32_t Plugin::FaceMaskFilter::Instance::LocalThreadMain() {
 			if (face_idx < 0)
 				face_idx = 0;
 
-			// acquire the locks in the correct order
-			obs_enter_graphics();
 			{
 
 				std::unique_lock<std::mutex> facelock(detection.faces[face_idx].mutex);
@@ -1538,7 +1634,6 @@ int32_t Plugin::FaceMaskFilter::Instance::LocalThreadMain() {
 				detection.faces[face_idx].detectionResults.motionRect = detect_results.motionRect;
 
 			}
-			obs_leave_graphics();
 
 			{
 				std::unique_lock<std::mutex> lock(detection.mutex);
@@ -1552,8 +1647,21 @@ int32_t Plugin::FaceMaskFilter::Instance::LocalThreadMain() {
 			auto elapsedMs =
 				std::chrono::duration_cast<std::chrono::microseconds>
 				(frameEnd - frameStart);
-			long long speedLimit = smll::Config::singleton().get_int(
-				smll::CONFIG_INT_SPEED_LIMIT) * 1000;
+
+			// auto profile: compare our time to the frame interval
+			if (detectorConfig.GetPerfProfile() == smll::PERF_PROFILE_AUTO) {
+				obs_video_info ovi;
+				if (obs_get_video_info(&ovi) && ovi.fps_num > 0) {
+					double frameMs = 1000.0 * (double)ovi.fps_den / (double)ovi.fps_num;
+					if (autoPerfProfile.Update(elapsedMs.count() / 1000.0, frameMs)) {
+						detectorConfig.SetAutoPerfProfile(autoPerfProfile.Current());
+						blog(LOG_DEBUG, "[FaceMask] Auto performance profile now %s",
+							smll::GetPerfProfile(autoPerfProfile.Current()).name);
+					}
+				}
+			}
+
+			long long speedLimit = (long long)detectorConfig.snapshot()->speedLimit * 1000;
 			long long sleepTime = max(speedLimit - elapsedMs.count(),
 				(long long)0);
 			if (sleepTime > 0)
@@ -1591,6 +1699,8 @@ int32_t Plugin::FaceMaskFilter::Instance::LocalMaskDataThreadMain() {
 	// Loading loop
 	bool lastDemoMode = false; 
 	while (mask_load_thread_running.test_and_set()) {
+		std::string currentFn;
+		bool haveCurrent = false;
 		{
 			std::unique_lock<std::mutex> lock(maskDataMutex, std::try_to_lock);
 			if (lock.owns_lock()) {
@@ -1601,7 +1711,7 @@ int32_t Plugin::FaceMaskFilter::Instance::LocalMaskDataThreadMain() {
 					currentMaskFilename = maskFilename;
 					currentMaskFolder = maskFolder;
 					// mask filename
-					std::string maskFn = currentMaskFolder + "\\" + currentMaskFilename;
+					std::string maskFn = MaskPath(currentMaskFolder, currentMaskFilename);
 					// load mask
 					SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
 					{
@@ -1630,8 +1740,20 @@ int32_t Plugin::FaceMaskFilter::Instance::LocalMaskDataThreadMain() {
 					obs_leave_graphics();
 				}
 				lastDemoMode = demoModeGenPreviews;
+
+				// the current mask names are only safe to read in here
+				currentFn = MaskPath(currentMaskFolder, currentMaskFilename);
+				haveCurrent = true;
 			}
 		}
+
+		// upcoming masks, loaded without holding up rendering
+		if (haveCurrent && !loading_mask && !demoModeGenPreviews) {
+			SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+			PreloadMasks(currentFn);
+			SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+		}
+
 		std::this_thread::sleep_for(std::chrono::milliseconds(33));
 	}
 
@@ -1647,6 +1769,8 @@ void Plugin::FaceMaskFilter::Instance::LoadDemo() {
 	blog(LOG_DEBUG, "loading demo folder %s", demoModeFolder.c_str());
 
 	std::vector<std::string> files = Utils::ListFolderRecursive(demoModeFolder, "*.json");
+	std::vector<std::string> packages = Utils::ListFolderRecursive(demoModeFolder, "*" MASK_PACKAGE_EXTENSION);
+	files.insert(files.end(), packages.begin(), packages.end());
 
 	obs_enter_graphics();
 	demoMaskDatas.clear();
@@ -1662,7 +1786,7 @@ void Plugin::FaceMaskFilter::Instance::LoadDemo() {
 		std::string fn = demoModeFolder + "\\" + files[i];
 		bool addMask = true;
 		if (demoModeGenPreviews) {
-			std::string gifname = fn.substr(0, fn.length() - 4) + "gif";
+			std::string gifname = fn.substr(0, fn.find_last_of('.') + 1) + "gif";
 			addMask = (::PathFileExists(Utils::ConvertStringToWstring(gifname).c_str()) != TRUE);
 
 			// don't do thumbs on these folders
@@ -1686,6 +1810,70 @@ void Plugin::FaceMaskFilter::Instance::LoadDemo() {
 }
 
 
+void Plugin::FaceMaskFilter::Instance::PreloadMasks(const std::string& currentFn) {
+	std::vector<std::unique_ptr<Mask::MaskData>> dropped;
+	std::string next;
+	{
+		std::unique_lock<std::mutex> lock(preloadMutex);
+
+		// drop what fell off the playlist
+		size_t used = 0;
+		for (auto it = preloadedMasks.begin(); it != preloadedMasks.end(); ) {
+			if (std::find(preloadPlaylist.begin(), preloadPlaylist.end(),
+				it->first) == preloadPlaylist.end()) {
+				dropped.emplace_back(std::move(it->second.data));
+				it = preloadedMasks.erase(it);
+			}
+			else {
+				used += it->second.size;
+				it++;
+			}
+		}
+
+		// next one to load, in playlist order, as long as it fits
+		for (const std::string& fn : preloadPlaylist) {
+			if (fn == currentFn || preloadedMasks.count(fn) > 0)
+				continue;
+			size_t size = preloadSizes[fn];
+			if (size == 0)
+				continue;
+			if (used + size <= preloadBudget)
+				next = fn;
+			break;
+		}
+	}
+
+	// unload on the graphics thread side
+	if (dropped.size() > 0) {
+		obs_enter_graphics();
+		dropped.clear();
+		obs_leave_graphics();
+	}
+
+	// one per pass, so a real switch never waits long for us
+	if (next.empty())
+		return;
+	std::unique_ptr<Mask::MaskData> mdat(LoadMask(next));
+	std::unique_lock<std::mutex> lock(preloadMutex);
+	if (std::find(preloadPlaylist.begin(), preloadPlaylist.end(), next) != preloadPlaylist.end()) {
+		PreloadedMask& preloaded = preloadedMasks[next];
+		preloaded.data = std::move(mdat);
+		preloaded.size = preloadSizes[next];
+		return;
+	}
+	lock.unlock();
+	obs_enter_graphics();
+	mdat = nullptr;
+	obs_leave_graphics();
+}
+
+std::string Plugin::FaceMaskFilter::Instance::MaskPath(const std::string& folder,
+	const std::string& filename) {
+	if (folder.empty())
+		return filename;
+	return folder + "\\" + filename;
+}
+
 Mask::MaskData*
 Plugin::FaceMaskFilter::Instance::LoadMask(std::string filename) {
 
@@ -1709,18 +1897,11 @@ Plugin::FaceMaskFilter::Instance::LoadMask(std::string filename) {
 void Plugin::FaceMaskFilter::Instance::drawCropRects(int width, int height) {
 #if !defined(PUBLIC_RELEASE)
 	dlib::rectangle r;
-	int x = (int)((float)(width / 2) *
-		smll::Config::singleton().get_double(
-			smll::CONFIG_DOUBLE_FACE_DETECT_CROP_X)) + (width / 2);
-	int y = (int)((float)(height / 2) *
-		smll::Config::singleton().get_double(
-			smll::CONFIG_DOUBLE_FACE_DETECT_CROP_Y)) + (height / 2);
-	int w = (int)((float)width *
-		smll::Config::singleton().get_double(
-			smll::CONFIG_DOUBLE_FACE_DETECT_CROP_WIDTH));
-	int h = (int)((float)height *
-		smll::Config::singleton().get_double(
-			smll::CONFIG_DOUBLE_FACE_DETECT_CROP_HEIGHT));
+	smll::ConfigSnapshotPtr config = detectorConfig.snapshot();
+	int x = (int)((float)(width / 2) * config->faceDetectCropX) + (width / 2);
+	int y = (int)((float)(height / 2) * config->faceDetectCropY) + (height / 2);
+	int w = (int)((float)width * config->faceDetectCropWidth);
+	int h = (int)((float)height * config->faceDetectCropHeight);
 
 	// need to transform back to capture size
 	x -= w / 2;
@@ -1794,7 +1975,7 @@ void Plugin::FaceMaskFilter::Instance::updateFaces() {
 			}
 
 			// new triangulation
-			triangulation.TakeBuffersFrom(detection.faces[fidx].triangulationResults);
+			triangulation.TakeMeshFrom(detection.faces[fidx].triangulationResults);
 			if (!drawMorphTris) {
 				triangulation.DestroyLineBuffer();
 			}
@@ -1802,7 +1983,7 @@ void Plugin::FaceMaskFilter::Instance::updateFaces() {
 			timestampInited = true;
 			processedFrameResults = detection.faces[fidx].detectionResults.processedResults;
 			// update our results
-			faces.CorrelateAndUpdateFrom(newFaces);
+			faces.CorrelateAndUpdateFrom(newFaces, *detectorConfig.snapshot());
 			if (lastResultIndex != fidx) {
 				sameFrameResults = false;
 				lastResultIndex = fidx;
@@ -24,6 +24,7 @@
 #include <mutex>
 #include <thread>
 #include <vector>
+#include <map>
 #include <atomic>
 
 #include "smll/FaceDetector.hpp"
@@ -128,6 +129,7 @@ namespace Plugin {
 			// misc functions
 			Mask::MaskData*	LoadMask(std::string filename);
 			void LoadDemo();
+			std::string MaskPath(const std::string& folder, const std::string& filename);
 			void drawCropRects(int width, int height);
 			void drawMotionRects(int width, int height);
 			void updateFaces();
@@ -146,7 +148,11 @@ namespace Plugin {
 			bool			videoTicked;
 			HANDLE			taskHandle;
 			ofstream		logOutput;
-			// Face detector
+			// Face detector, and its config
+			// - per instance, so each source can have its own 
+			//   detection budget
+			smll::Config			detectorConfig;
+			smll::AutoPerfProfile	autoPerfProfile;
 			smll::FaceDetector*		smllFaceDetector;
 #if !defined(PUBLIC_RELEASE)
 			smll::OBSRenderer*      smllRenderer;
@@ -174,8 +180,25 @@ namespace Plugin {
 			std::string			maskInternal;
 			std::string			currentMaskFilename;
 
+			// call with maskDataMutex held
 			void	checkForMaskUnloading();
 
+			// preloaded masks
+			// - a playlist of masks we will switch to soon, loaded in the
+			//   background so activating one is just a pointer swap
+			// - preloadMutex guards all of these
+			struct PreloadedMask {
+				std::unique_ptr<Mask::MaskData>	data;
+				size_t							size;
+			};
+			std::mutex							preloadMutex;
+			std::vector<std::string>			preloadPlaylist;
+			std::map<std::string, size_t>		preloadSizes;	// file sizes, per playlist change
+			size_t								preloadBudget;
+			std::map<std::string, PreloadedMask>	preloadedMasks;
+
+			void	PreloadMasks(const std::string& currentFn);
+
 			// alert params
 			bool				alertActivate;
 			float				alertDuration;
@@ -63,6 +63,14 @@
 #define P_NO_ANTI_ALIASING		"noAntialiasing"
 #define P_SSAA_ANTI_ALIASING	"ssaaAntialiasing"
 #define P_FXAA_ANTI_ALIASING	"fxaaAntialiasing"
+#define P_PERF_PROFILE			"perfProfile"
+#define P_PERF_MANUAL			"perfProfileManual"
+#define P_PERF_ECO				"perfProfileEco"
+#define P_PERF_BALANCED			"perfProfileBalanced"
+#define P_PERF_QUALITY			"perfProfileQuality"
+#define P_PERF_AUTO				"perfProfileAuto"
+#define P_PRELOAD				"preloadMasks"
+#define P_PRELOAD_BUDGET		"preloadBudget"
 
 // Other static strings
 static const char* const kDefaultMask = "";
@@ -66,9 +66,13 @@ namespace Utils {
 	const char* Base64ToTempFile(std::string base64String) {
 		std::vector<uint8_t> decoded;
 		base64_decodeZ(base64String, decoded);
+		return DataToTempFile(decoded.data(), decoded.size());
+	}
+
+	const char* DataToTempFile(const uint8_t* data, size_t size) {
 		const char* fn = GetTempFileName();
 		std::fstream f(fn, std::ios::out | std::ios::binary);
-		f.write((char*)decoded.data(), decoded.size());
+		f.write((const char*)data, size);
 		f.close();
 		return fn;
 	}
@@ -82,6 +86,27 @@ namespace Utils {
 	}
 
 
+	size_t FileSize(const std::string& filename) {
+		WIN32_FILE_ATTRIBUTE_DATA fad;
+		if (!::GetFileAttributesExW(ConvertStringToWstring(filename).c_str(),
+			GetFileExInfoStandard, &fad))
+			return 0;
+		return ((size_t)fad.nFileSizeHigh << 32) | (size_t)fad.nFileSizeLow;
+	}
+
+	std::string FileKey(const std::string& filename) {
+		WIN32_FILE_ATTRIBUTE_DATA fad;
+		if (!::GetFileAttributesExW(ConvertStringToWstring(filename).c_str(),
+			GetFileExInfoStandard, &fad))
+			return "";
+		uint64_t size = ((uint64_t)fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+		uint64_t mtime = ((uint64_t)fad.ftLastWriteTime.dwHighDateTime << 32) |
+			fad.ftLastWriteTime.dwLowDateTime;
+		return "file:" + filename + ":" + std::to_string(size) + ":" +
+			std::to_string(mtime);
+	}
+
+
 	std::vector<std::string> ListFolderRecursive(std::string path, std::string glob = "*") {
 		std::vector<std::string> res;
 		std::vector<std::wstring> wres = ListFolderRecursive(ConvertStringToWstring(path), ConvertStringToWstring(glob));
@@ -262,6 +287,60 @@ namespace Utils {
 		return r;
 	}
 
+	// MurmurHash64A, by Austin Appleby, public domain
+	//
+	// https://github.com/aappleby/smhasher/blob/master/src/MurmurHash2.cpp
+	//
+	uint64_t HashData(const void* data, size_t size, uint64_t seed) {
+		const uint64_t m = 0xc6a4a7935bd1e995ULL;
+		const int r = 47;
+
+		uint64_t h = seed ^ (size * m);
+
+		const uint8_t* p = (const uint8_t*)data;
+		const uint8_t* end = p + (size & ~(size_t)7);
+		for (; p != end; p += 8) {
+			uint64_t k;
+			memcpy(&k, p, sizeof(k));
+
+			k *= m;
+			k ^= k >> r;
+			k *= m;
+
+			h ^= k;
+			h *= m;
+		}
+
+		switch (size & 7) {
+		case 7: h ^= uint64_t(p[6]) << 48;
+			// fall through
+		case 6: h ^= uint64_t(p[5]) << 40;
+			// fall through
+		case 5: h ^= uint64_t(p[4]) << 32;
+			// fall through
+		case 4: h ^= uint64_t(p[3]) << 24;
+			// fall through
+		case 3: h ^= uint64_t(p[2]) << 16;
+			// fall through
+		case 2: h ^= uint64_t(p[1]) << 8;
+			// fall through
+		case 1: h ^= uint64_t(p[0]);
+			h *= m;
+		};
+
+		h ^= h >> r;
+		h *= m;
+		h ^= h >> r;
+
+		return h;
+	}
+
+	std::string HashToString(uint64_t hash) {
+		char buf[17];
+		snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)hash);
+		return buf;
+	}
+
 	void flip_list(bool *list, size_t start, size_t end)
 	{
 		for (size_t i = start; i < end; i++)
@@ -46,12 +46,16 @@ namespace Utils {
 	extern const char* GetTempPath();
 	extern const char* GetTempFileName();
 	extern const char* Base64ToTempFile(std::string base64String);
+	extern const char* DataToTempFile(const uint8_t* data, size_t size);
 	extern std::vector<std::string> split(const std::string &s, char delim);
 	extern std::string dirname(const std::string &p);
 	extern int count_spaces(const std::string& s);
 	extern void find_and_replace(std::string& source, std::string const& find, std::string const& replace);
 
 	extern void DeleteTempFile(std::string filename);
+	extern size_t FileSize(const std::string& filename);
+	// cache key for a file, changes when the file is written to
+	extern std::string FileKey(const std::string& filename);
 	extern std::vector<std::string> ListFolderRecursive(std::string path, std::string glob);
 
 	//wstring functions
@@ -59,6 +63,10 @@ namespace Utils {
 	extern std::vector<std::wstring> ListFolder(std::wstring path, std::wstring glob = L"*");
 	extern std::vector<std::wstring> ListFolderRecursive(std::wstring path, std::wstring glob = L"*");
 
+	// fast non-cryptographic 64 bit hash (MurmurHash64A)
+	extern uint64_t HashData(const void* data, size_t size, uint64_t seed = 0);
+	extern std::string HashToString(uint64_t hash);
+
 	extern float hermite(float t, float p1, float p2, float t1 = 0.0f, float t2 = 0.0f);
 	extern void fastMemcpy(void *pvDest, void *pvSrc, size_t nBytes);
 
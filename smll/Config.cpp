@@ -31,24 +31,23 @@ namespace smll {
 
 
 	// show our "advanced" settings
-	static bool g_showSettings = false;
-    
+	// - the toggle lives in each instance's own settings, all we do is
+	//   have the properties rebuilt, which reads it from there
 	bool onSettingsToggle(obs_properties_t *props, obs_property_t *property, 
 		obs_data_t *settings) {
 		UNUSED_PARAMETER(props);
 		UNUSED_PARAMETER(property);
 		UNUSED_PARAMETER(settings);
 
-		g_showSettings = obs_data_get_bool(settings,
-			CONFIG_BOOL_TOGGLE_SETTINGS);
-
 		return true;
 	}
 
 	static Config g_config;
 
 	Config::Config()
-        : m_data(nullptr) {
+        : m_data(nullptr)
+		, m_perfProfile(PERF_PROFILE_MANUAL)
+		, m_autoPerfProfile(PERF_PROFILE_BALANCED) {
 		//
 		// ---- Add All Parameters Here ----
 		//
@@ -85,6 +84,7 @@ namespace smll {
 
 		m_data = obs_data_create();
 		set_defaults(m_data);
+		PublishSnapshot();
 	}
 
 	Config::~Config() {
@@ -117,7 +117,10 @@ namespace smll {
 		}
 	}
 
-	void Config::get_properties(obs_properties_t* props) {
+	void Config::get_properties(obs_properties_t* props, obs_data_t* settings) {
+		bool showSettings = settings &&
+			obs_data_get_bool(settings, CONFIG_BOOL_TOGGLE_SETTINGS);
+
 		for (auto it = m_paramNames.begin(); it != m_paramNames.end(); it++) {
 			// skip hidden params
 			if (std::find(m_hiddenParams.begin(), 
@@ -135,7 +138,7 @@ namespace smll {
 					pname, P_TRANSLATE(pname));
 				if (*it == CONFIG_BOOL_TOGGLE_SETTINGS) {
 					obs_property_set_modified_callback(p, onSettingsToggle);
-					if (!g_showSettings)
+					if (!showSettings)
 						return;
 				}
 				break; 
@@ -164,26 +167,95 @@ namespace smll {
 		//   guarantees on the validity of these values, such as they should 
 		//   be between min/max and lie on a step. 
 		// - So, unfortunately, we need to validate these values
+		lock();
 		obs_data_apply(m_data, data);
 
-		g_showSettings = get_bool(CONFIG_BOOL_TOGGLE_SETTINGS);
-
 		// iterate params, and clamp int/double to their min/max
 		//
 		for (auto it = m_params.begin(); it != m_params.end(); it++) {
+			const char* name = it->first.c_str();
 			if (it->second.type == PARAM_TYPE_INT) {
-				int v = get_int(it->first.c_str());
+				int v = (int)obs_data_get_int(m_data, name);
 				v = std::max<int>((int)it->second.min, v);
 				v = std::min<int>((int)it->second.max, v);
-				set_int(it->first.c_str(), v);
+				obs_data_set_int(m_data, name, v);
 			}
 			else if (it->second.type == PARAM_TYPE_DOUBLE) {
-				double v = get_double(it->first.c_str());
+				double v = obs_data_get_double(m_data, name);
 				v = std::max<double>(it->second.min, v);
 				v = std::min<double>(it->second.max, v);
-				set_double(it->first.c_str(), v);
+				obs_data_set_double(m_data, name, v);
 			}
 		}
+
+		PublishSnapshot();
+		unlock();
+	}
+
+	void Config::SetPerfProfile(PerfProfileID id) {
+		lock();
+		if (id != m_perfProfile) {
+			m_perfProfile = id;
+			PublishSnapshot();
+		}
+		unlock();
+	}
+
+	void Config::SetAutoPerfProfile(PerfProfileID id) {
+		lock();
+		if (id != m_autoPerfProfile) {
+			m_autoPerfProfile = id;
+			if (m_perfProfile == PERF_PROFILE_AUTO)
+				PublishSnapshot();
+		}
+		unlock();
+	}
+
+	void Config::PublishSnapshot() {
+		std::shared_ptr<ConfigSnapshot> s = std::make_shared<ConfigSnapshot>();
+
+		s->kalmanEnable = obs_data_get_bool(m_data, CONFIG_BOOL_KALMAN_ENABLE);
+		for (int i = 0; i < CONFIG_NUM_SMOOTH_LANDMARKS; i++) {
+			s->smoothLandmark[i] = obs_data_get_bool(m_data,
+				(std::string(CONFIG_BOOL_SMOOTH_LANDMARK) + std::to_string(i + 1)).c_str());
+		}
+		s->smoothingFactor = obs_data_get_double(m_data, CONFIG_FLOAT_SMOOTHING_FACTOR);
+
+		s->movementThreshold = obs_data_get_double(m_data, CONFIG_DOUBLE_MOVEMENT_THRESHOLD);
+		s->blurFactor = obs_data_get_double(m_data, CONFIG_DOUBLE_BLUR_FACTOR);
+		s->motionRectanglePadding = obs_data_get_double(m_data, CONFIG_MOTION_RECTANGLE_PADDING);
+		s->minMotionRectangle = obs_data_get_double(m_data, CONFIG_MIN_MOTION_RECTANGLE);
+
+		s->faceDetectWidth = (int)obs_data_get_int(m_data, CONFIG_INT_FACE_DETECT_WIDTH);
+		s->faceDetectCropWidth = obs_data_get_double(m_data, CONFIG_DOUBLE_FACE_DETECT_CROP_WIDTH);
+		s->faceDetectCropHeight = obs_data_get_double(m_data, CONFIG_DOUBLE_FACE_DETECT_CROP_HEIGHT);
+		s->faceDetectCropX = obs_data_get_double(m_data, CONFIG_DOUBLE_FACE_DETECT_CROP_X);
+		s->faceDetectCropY = obs_data_get_double(m_data, CONFIG_DOUBLE_FACE_DETECT_CROP_Y);
+
+		s->faceDetectFrequency = (int)obs_data_get_int(m_data, CONFIG_INT_FACE_DETECT_FREQUENCY);
+		s->faceDetectRecheckFrequency = (int)obs_data_get_int(m_data, CONFIG_INT_FACE_DETECT_RECHECK_FREQUENCY);
+		s->trackingFrequency = (int)obs_data_get_int(m_data, CONFIG_INT_TRACKING_FREQUNCY);
+		s->trackingThreshold = obs_data_get_double(m_data, CONFIG_DOUBLE_TRACKING_THRESHOLD);
+
+		s->speedLimit = (int)obs_data_get_int(m_data, CONFIG_INT_SPEED_LIMIT);
+
+		// profile overrides
+		PerfProfileID id = m_perfProfile;
+		if (id == PERF_PROFILE_AUTO)
+			id = m_autoPerfProfile;
+		s->perfProfile = id;
+		const PerfProfile& profile = GetPerfProfile(id);
+		s->allowSSAA = profile.allowSSAA;
+		s->lightingReduction = profile.lightingReduction;
+		if (id != PERF_PROFILE_MANUAL) {
+			s->faceDetectWidth = profile.faceDetectWidth;
+			s->faceDetectRecheckFrequency = profile.faceDetectRecheckFrequency;
+			s->trackingFrequency = profile.trackingFrequency;
+			s->speedLimit = profile.speedLimit;
+			s->kalmanEnable = profile.kalmanEnable;
+		}
+
+		std::atomic_store(&m_snapshot, ConfigSnapshotPtr(s));
 	}
 
 
@@ -36,10 +36,14 @@
 
 #pragma warning( pop )
 
+#include "PerfProfile.hpp"
+
 
 #include <mutex>
 #include <map>
 #include <vector>
+#include <memory>
+#include <atomic>
 
 
 // param types
@@ -52,7 +56,7 @@
 #define CONFIG_GET(TYPE) 		{	lock();  \
 TYPE v = (TYPE)obs_data_get_##TYPE(m_data, name); unlock(); return v; }
 #define CONFIG_SET(TYPE,VALUE)	{	lock();  \
-obs_data_set_##TYPE(m_data, name, VALUE); unlock(); }
+obs_data_set_##TYPE(m_data, name, VALUE); PublishSnapshot(); unlock(); }
 
 
 namespace smll {
@@ -121,6 +125,45 @@ namespace smll {
 	static const char* const CONFIG_BOOL_KALMAN_ENABLE =
 		"kalmanFilteringEnable";
 
+	// Number of per-landmark smoothing flags
+	static const int CONFIG_NUM_SMOOTH_LANDMARKS = 68;
+
+	// Config Snapshot
+	// - a typed, read-only copy of all the params, made every time they 
+	//   change. Hot paths grab one of these (once per frame) instead of 
+	//   doing string keyed lookups under the config mutex.
+	struct ConfigSnapshot
+	{
+		bool	kalmanEnable;
+		bool	smoothLandmark[CONFIG_NUM_SMOOTH_LANDMARKS];
+		double	smoothingFactor;
+
+		double	movementThreshold;
+		double	blurFactor;
+		double	motionRectanglePadding;
+		double	minMotionRectangle;
+
+		int		faceDetectWidth;
+		double	faceDetectCropWidth;
+		double	faceDetectCropHeight;
+		double	faceDetectCropX;
+		double	faceDetectCropY;
+
+		int		faceDetectFrequency;
+		int		faceDetectRecheckFrequency;
+		int		trackingFrequency;
+		double	trackingThreshold;
+
+		int		speedLimit;
+
+		// performance profile in effect, and the render side
+		// settings it controls
+		PerfProfileID	perfProfile;
+		bool			allowSSAA;
+		int				lightingReduction;
+	};
+	typedef std::shared_ptr<const ConfigSnapshot> ConfigSnapshotPtr;
+
 	class Config
 	{
 	public:
@@ -149,9 +192,22 @@ namespace smll {
 		inline obs_data_t*		lock() { m_mutex.lock(); return m_data; }
 		inline void				unlock() { m_mutex.unlock(); }
 
+		// performance profile
+		// - auto picks its effective profile from SetAutoPerfProfile
+		// - set under the config lock, but read from any thread
+		void				SetPerfProfile(PerfProfileID id);
+		void				SetAutoPerfProfile(PerfProfileID id);
+		PerfProfileID		GetPerfProfile() const { return m_perfProfile.load(); }
+
+		// latest snapshot (no locking)
+		inline ConfigSnapshotPtr	snapshot() const { 
+			return std::atomic_load(&m_snapshot); }
+
 		// stuff
 		void				set_defaults(obs_data_t* data);
-		void				get_properties(obs_properties_t* props);
+		// settings: the instance's current settings, for the
+		// advanced settings toggle
+		void				get_properties(obs_properties_t* props, obs_data_t* settings);
 		void				update_properties(obs_data_t* data);
 
 	private:
@@ -170,12 +226,20 @@ namespace smll {
 		void AddParam(const char* name, int defaultValue, int min, int max, int step);
 		void AddParam(const char* name, double defaultValue, double min, double max, double step);
 
+		// make a new snapshot from m_data (call locked)
+		void PublishSnapshot();
+
 		std::vector<std::string> m_paramNames; //  need this to preserve order
 		std::map<std::string, ParamInfo> m_params;
 
 		std::mutex		m_mutex; // ensure thread safety
 		obs_data_t*		m_data;  // all vars stored here
 
+		ConfigSnapshotPtr	m_snapshot; // published copy of m_data
+
+		std::atomic<PerfProfileID>	m_perfProfile;
+		PerfProfileID		m_autoPerfProfile;
+
 		std::vector<std::string> m_hiddenParams; // hide these from UI
 	};
 
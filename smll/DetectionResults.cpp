@@ -169,7 +169,8 @@ namespace smll {
 
 	}
 
-	void DetectionResults::CorrelateAndUpdateFrom(DetectionResults& other) {
+	void DetectionResults::CorrelateAndUpdateFrom(DetectionResults& other,
+		const ConfigSnapshot& config) {
 
 		DetectionResults& faces = *this;
 
@@ -185,7 +186,7 @@ namespace smll {
 				int closest = other.findClosest(faces[i]);
 
 				// smooth new face into ours
-				faces[i].UpdateResultsFrom(other[closest]);
+				faces[i].UpdateResultsFrom(other[closest], config);
 				faces[i].numFramesLost = 0;
 				other[closest].matched = true;
 			}
@@ -213,7 +214,7 @@ namespace smll {
 				int closest = faces.findClosest(other[i]);
 
 				// smooth new face into ours
-				faces[closest].UpdateResultsFrom(other[i]);
+				faces[closest].UpdateResultsFrom(other[i], config);
 				faces[closest].numFramesLost = 0;
 				faces[closest].matched = true;
 			}
@@ -326,14 +327,15 @@ namespace smll {
 		}
 	}
 
-	void DetectionResult::UpdateResultsFrom(const DetectionResult& r) {
+	void DetectionResult::UpdateResultsFrom(const DetectionResult& r,
+		const ConfigSnapshot& config) {
 
 		if (!kalmanFilterInitialized) {
 			*this = r;
 			for (int i = 0; i < smll::NUM_FACIAL_LANDMARKS; i++) {
 				landmarks68[i] = r.landmarks68[i];
 			}
-			InitKalmanFilter();
+			InitKalmanFilter(config);
 		}
 
 		double ntx[3] = { r.pose.translation[0], r.pose.translation[1], r.pose.translation[2] };
@@ -341,7 +343,7 @@ namespace smll {
 		dlib::rectangle bnd = r.bounds;
 
 		// kalman filtering enabled?
-		if (Config::singleton().get_bool(CONFIG_BOOL_KALMAN_ENABLE)) {
+		if (config.kalmanEnable) {
 			
 			// Get the measured translation
 			cv::Mat translationMeasured = r.pose.GetCVTranslation();
@@ -395,9 +397,9 @@ namespace smll {
 
 		// copy values
 		bounds = bnd;
-		double smoothing = Config::singleton().get_double(CONFIG_FLOAT_SMOOTHING_FACTOR);
+		double smoothing = config.smoothingFactor;
 		for (int i = 0; i < smll::NUM_FACIAL_LANDMARKS; i++) {
-			bool landmark_smoothing = Config::singleton().get_bool((std::string(CONFIG_BOOL_SMOOTH_LANDMARK) + std::to_string(i + 1)).c_str());
+			bool landmark_smoothing = config.smoothLandmark[i];
 			if (landmark_smoothing) {
 				kalmanFilters[2 * i].SetMeasurementNoiseCovariance(smoothing);
 				kalmanFilters[2 * i + 1].SetMeasurementNoiseCovariance(smoothing);
@@ -413,8 +415,8 @@ namespace smll {
 		
 	}
 
-	void DetectionResult::InitKalmanFilter() {
-		if (Config::singleton().get_bool(CONFIG_BOOL_KALMAN_ENABLE)) {
+	void DetectionResult::InitKalmanFilter(const ConfigSnapshot& config) {
+		if (config.kalmanEnable) {
 			kalmanFilter.init(nStates, nMeasurements, nInputs, CV_64F);					// init Kalman Filter
 			cv::setIdentity(kalmanFilter.processNoiseCov, cv::Scalar::all(1e-5));		// set process noise
 			cv::setIdentity(kalmanFilter.measurementNoiseCov, cv::Scalar::all(1e-4));   // set measurement noise
@@ -476,7 +478,7 @@ namespace smll {
 			kalmanFilter.measurementMatrix.at<double>(4, 10) = 1; // pitch  
 			kalmanFilter.measurementMatrix.at<double>(5, 11) = 1; // yaw  
 
-			double smoothing = Config::singleton().get_double(CONFIG_FLOAT_SMOOTHING_FACTOR);
+			double smoothing = config.smoothingFactor;
 			for (size_t i = 0; i < NUM_FACIAL_LANDMARKS; i++)
 			{
 				kalmanFilters[2*i].Init(landmarks68[i].x());
@@ -39,6 +39,7 @@
 #include "landmarks.hpp"
 #include "SingleValueKalman.hpp"
 #include "Face.hpp"
+#include "Config.hpp"
 #include "../Plugin/utils.h"
 #include <opencv2/opencv.hpp>
 
@@ -113,7 +114,7 @@ namespace smll {
 
 		void CopyPoseFrom(const DetectionResult& r);
 		void InitStartPose();
-		void UpdateResultsFrom(const DetectionResult& r);
+		void UpdateResultsFrom(const DetectionResult& r, const ConfigSnapshot& config);
 
 		double DistanceTo(const DetectionResult& r) const;
 
@@ -138,7 +139,7 @@ namespace smll {
 		bool kalmanFilterInitialized;
 
 		// Kalman Filter methods
-		void InitKalmanFilter();
+		void InitKalmanFilter(const ConfigSnapshot& config);
 		void UpdateKalmanFilter(cv::Mat& measurements, cv::Mat& translationEstimated, cv::Mat& eulersEstimated);
 	};
 
@@ -147,7 +148,7 @@ namespace smll {
 	{
 	public:
 		DetectionResults();
-		void CorrelateAndUpdateFrom(DetectionResults& other);
+		void CorrelateAndUpdateFrom(DetectionResults& other, const ConfigSnapshot& config);
 		int findClosest(const smll::DetectionResult& result);
 		ProcessedResults processedResults;
 		dlib::rectangle motionRect;
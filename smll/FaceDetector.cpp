@@ -22,13 +22,15 @@
 #include "FaceDetector.hpp"
 #include "../Plugin/plugin.h"
 
+#include <xmmintrin.h>
+
 #define HULL_POINTS_SCALE		(1.25f)
-// border points = 4 corners + subdivide
-#define NUM_BORDER_POINTS		(4 * 2 * 2 * 2) 
-#define NUM_BORDER_POINT_DIVS	(3)
-// hull points = head + jaw + subdivide
-#define NUM_HULL_POINTS			(28 * 2 * 2 * 2)
-#define NUM_HULL_POINT_DIVS		(3)
+// canonical topologies are used up to this face angle (radians)
+#define CANONICAL_MAX_ANGLE		(0.35f)
+// canonical turned faces are modelled at this yaw (radians)
+#define CANONICAL_YAW			(0.25f)
+// canonical face height, as a fraction of the frame height
+#define CANONICAL_FACE_SCALE	(0.45f)
 
 
 #define FACEMASK_AVX		(L"facemask_AVX.dll")
@@ -46,14 +48,22 @@ using namespace std;
 
 namespace smll {
 
-	FaceDetector::FaceDetector()
-		: m_captureStage(nullptr)
+	static inline bool IsTurnedLeft(const std::vector<cv::Point2f>& warpedpoints) {
+		return warpedpoints[NOSE_4].x < warpedpoints[NOSE_1].x;
+	}
+
+	FaceDetector::FaceDetector(const Config& config)
+		: m_configSource(config)
+		, m_captureStage(nullptr)
 		, m_stageSize(0)
 		, m_trackingTimeout(0)
         , m_detectionTimeout(0)
 		, m_trackingFaceIndex(0)
 		, m_camera_w(0)
 		, m_camera_h(0)
+		, m_topologyCount(0)
+		, m_canonical_w(0)
+		, m_canonical_h(0)
 		, isPrevInit(false)
 		, cropInfo(0,0,0,0)
 		, loaded(false)
@@ -204,12 +214,10 @@ namespace smll {
 
 		cv::Mat diffImage;
 		cv::absdiff(prevImage, currentImage, diffImage);
-		int blur_factor = Config::singleton().get_double(
-			CONFIG_DOUBLE_BLUR_FACTOR);
+		int blur_factor = (int)m_config->blurFactor;
 		cv::GaussianBlur(diffImage, diffImage, cv::Size(blur_factor, blur_factor), 0, 0);
 
-		int threshold = Config::singleton().get_double(
-			CONFIG_DOUBLE_MOVEMENT_THRESHOLD);
+		int threshold = (int)m_config->movementThreshold;
 		int minY = diffImage.rows;
 		int minX = diffImage.cols;
 		int maxY = 0;
@@ -237,7 +245,7 @@ namespace smll {
 
 	void FaceDetector::addFaceRectangles(DetectionResults& results) {
 
-		float paddingPercentage = Config::singleton().get_double(CONFIG_MOTION_RECTANGLE_PADDING);
+		float paddingPercentage = (float)m_config->motionRectanglePadding;
 
 		for (int i = 0; i < m_faces.length; i++) {
 			// scale rectangle up to video frame size
@@ -260,7 +268,7 @@ namespace smll {
 		computeDifference(results);
 		addFaceRectangles(results);
 
-		float minMotionRectangle = Config::singleton().get_double(CONFIG_MIN_MOTION_RECTANGLE);
+		float minMotionRectangle = (float)m_config->minMotionRectangle;
 		int MRectMinW = minMotionRectangle *grayImage.cols;
 		int MRectMinH = minMotionRectangle *grayImage.rows;
 		if (results.motionRect.width() < MRectMinW || results.motionRect.height() < MRectMinH) {
@@ -289,6 +297,9 @@ namespace smll {
 		resizeWidth = width;
 		resizeHeight = height;
 
+		// config for this frame
+		m_config = m_configSource.snapshot();
+
 		// convenience	
 		m_capture = capture;
 
@@ -310,8 +321,7 @@ namespace smll {
 			computeCurrentImage(results);
 			DoFaceDetection();
 			if (m_faces.length > 0) {
-				m_detectionTimeout =
-					Config::singleton().get_int(CONFIG_INT_FACE_DETECT_RECHECK_FREQUENCY);
+				m_detectionTimeout = m_config->faceDetectRecheckFrequency;
 				StartObjectTracking();
 				results.processedResults.DetectionMade();
 			}
@@ -330,8 +340,7 @@ namespace smll {
 				m_trackingFaceIndex = (m_trackingFaceIndex + 1) % m_faces.length;
 
 				// tracking frequency
-				m_trackingTimeout =
-					Config::singleton().get_int(CONFIG_INT_TRACKING_FREQUNCY);
+				m_trackingTimeout = m_config->trackingFrequency;
 			}
 			else {
 				m_trackingFaceIndex = 0;
@@ -364,8 +373,8 @@ namespace smll {
 		DetectionResults& results,
 		TriangulationResult& result) {
 
-		// clear buffers
-		result.DestroyBuffers();
+		// nothing new until we say so
+		result.Invalidate();
 
 		// need valid morph data
 		if (!morphData.IsValid())
@@ -399,12 +408,14 @@ namespace smll {
 		face.GetCVTranslation().copyTo(trx); // make sure to copy!
 		trx.at<double>(0, 0) = 0.0; // clear x & y, we'll center it
 		trx.at<double>(1, 0) = 0.0;
-		std::vector<cv::Point3f> deltas = morphData.GetCVDeltas();
-		std::vector<cv::Point2f> projectedDeltas;
-		cv::projectPoints(deltas, rot, trx, GetCVCamMatrix(), GetCVDistCoeffs(), projectedDeltas);
+		morphData.GetCVDeltas(m_deltas);
+		cv::projectPoints(m_deltas, rot, trx, GetCVCamMatrix(), GetCVDistCoeffs(), m_projectedDeltas);
+		const std::vector<cv::Point2f>& projectedDeltas = m_projectedDeltas;
 
 		// make a list of points for triangulation
-		std::vector<cv::Point2f> points;
+		// - these are members, so they keep their storage between frames
+		std::vector<cv::Point2f>& points = m_points;
+		points.clear();
 
 		// add facial landmark points
 		dlib::point* facePoints = face.landmarks68;
@@ -414,10 +425,11 @@ namespace smll {
 		}
 
 		// add the head points
-		AddHeadPoints(points, face);
+		AddHeadPoints(points, face.GetCVRotation(), face.GetCVTranslation());
 
 		// Apply the morph deltas to points to create warpedpoints
-		std::vector<cv::Point2f> warpedpoints = points;
+		std::vector<cv::Point2f>& warpedpoints = m_warpedPoints;
+		warpedpoints.assign(points.begin(), points.end());
 		cv::Point2f c(width / 2, height / 2);
 		for (int i = 0; i < NUM_MORPH_LANDMARKS; i++) {
 			// bitmask tells us which deltas are non-zero
@@ -427,75 +439,197 @@ namespace smll {
 			}
 		}
 
-		// add smoothing points
-		for (int i = 0; i < NUM_FACE_CONTOURS; i++) {
-			const FaceContour& fc = GetFaceContour((FaceContourID)i);
-			// smooth em out
-			CatmullRomSmooth(points, fc.indices, NUM_SMOOTHING_STEPS);
-			CatmullRomSmooth(warpedpoints, fc.indices, NUM_SMOOTHING_STEPS);
+		// add smoothing, border and hull points
+		AddMeshPoints(points, warpedpoints);
+
+		// make the vertices
+		MakeVertices(result, points, warpedpoints);
+
+		// Create Triangulation
+
+		// decide which points go into the triangulation
+		std::vector<bool>& included = m_included;
+		SelectTriangulationPoints(points, warpedpoints, faceDeadOn, included);
+
+		// common case: a (mostly) frontal face can use one of the
+		// canonical topologies, as long as it was built from the same
+		// points (none off-frame, same eyebrow/nose picks) and none of
+		// its triangles flip
+		const MorphTopology* topology = nullptr;
+		if (angle < CANONICAL_MAX_ANGLE) {
+			MakeCanonicalTopologies();
+			int which = CANONICAL_FRONTAL;
+			if (!faceDeadOn) {
+				which = IsTurnedLeft(warpedpoints) ?
+					CANONICAL_TURNED_LEFT : CANONICAL_TURNED_RIGHT;
+			}
+			const MorphTopology& canonical = m_canonicalTopologies[which];
+			if (canonical.included == included && canonical.IsValidFor(points)) {
+				topology = &canonical;
+			}
 		}
 
-		// add border points
-		std::vector<cv::Point2f> borderpoints;
-		// 4 corners
-		borderpoints.push_back(cv::Point2f(0, 0));
-		borderpoints.push_back(cv::Point2f(width, 0));
-		borderpoints.push_back(cv::Point2f(width, height));
-		borderpoints.push_back(cv::Point2f(0, height));
-		// subdivide
-		for (int i = 0; i < NUM_BORDER_POINT_DIVS; i++) {
-			Subdivide(borderpoints);
+		if (topology == nullptr) {
+			// only re-triangulate if we have to
+			if (m_morphTopology.included != included ||
+				!m_morphTopology.IsValidFor(points)) {
+				Triangulate(points, included, m_morphTopology);
+			}
+			topology = &m_morphTopology;
 		}
-		points.insert(points.end(), borderpoints.begin(), borderpoints.end());
-		warpedpoints.insert(warpedpoints.end(), borderpoints.begin(), borderpoints.end());
 
-		// add hull points
-		std::vector<cv::Point2f> hullpoints;
-		MakeHullPoints(points, warpedpoints, hullpoints);
-		points.reserve(points.size() + hullpoints.size());
-		warpedpoints.reserve(warpedpoints.size() + hullpoints.size());
-		for (int i = 0; i < hullpoints.size(); i++) {
-			points.push_back(hullpoints[i]);
-			warpedpoints.push_back(hullpoints[i]);
+		// Make Area Indices
+		// - only if the topology changed since we made them
+		if (result.topologyId != topology->id ||
+			(result.buildLines && 
+			 result.indices[TriangulationResult::IDXBUFF_LINES].empty())) {
+			MakeAreaIndices(result, topology->triangles);
+			result.topologyId = topology->id;
 		}
 
-		// make the vertex buffer 
-		// TODO: we should probably leave the creation of this
-		//       graphics stuff to the render method
-		//
-		obs_enter_graphics();
-		gs_render_start(true);
+		result.valid = true;
+	}
+
+	// MakeVertices
+	// - fills in the CPU side vertex arrays, the render thread uploads 
+	//   them
+	//
+	void FaceDetector::MakeVertices(TriangulationResult& result,
+		const std::vector<cv::Point2f>& points, 
+		const std::vector<cv::Point2f>& warpedpoints) {
+
+		float width = (float)CaptureWidth();
+		float height = (float)CaptureHeight();
 		size_t nv = points.size();
+
+		// note: same size every frame, so these don't allocate
+		result.positions.resize(nv);
+		result.uvs.resize(nv);
+		result.colors.resize(nv);
+
 		LandmarkBitmask hpbm;
 		hpbm.set(HULL_POINT);
 		for (int i = 0; i < nv; i++) {
 			// position from warped points
 			// uv from original points
-			const cv::Point2f& p = warpedpoints[i];
-			const cv::Point2f& uv = points[i];
-
-			// add point and uv
-			gs_texcoord(uv.x / width, uv.y / height, 0);
-			gs_vertex2f(p.x, p.y);
+			result.positions[i] = warpedpoints[i];
+			result.uvs[i] = cv::Point2f(points[i].x / width, points[i].y / height);
 
 			if ((m_vtxBitmaskLookup[i] & hpbm).any())
-				gs_color(0x0);
+				result.colors[i] = 0x0;
 			else
-				gs_color(0xFFFFFFFF);
+				result.colors[i] = 0xFFFFFFFF;
 		}
-		result.vertexBuffer = gs_render_save();
-		obs_leave_graphics();
+	}
 
+	// MakeCanonicalTopologies
+	// - triangulates the 3D landmark model, looking dead-on and turned
+	//   slightly to either side, once per capture size. 
+	// - these are not baked in as constant tables: the border and hull
+	//   points, and the camera matrix we project with, all depend on
+	//   the capture size, so one table wouldn't fit every source. It
+	//   costs three Delaunays the first time a near-frontal face is
+	//   morphed at a new size, on the detection thread, not at startup.
+	//
+	void FaceDetector::MakeCanonicalTopologies() {
+		int w = CaptureWidth();
+		int h = CaptureHeight();
+		if (m_canonical_w == w && m_canonical_h == h)
+			return;
+		m_canonical_w = w;
+		m_canonical_h = h;
 
-		// Create Triangulation
+		// model points for the 68 landmarks
+		std::vector<int> model_indices;
+		for (int i = 0; i < NUM_FACIAL_LANDMARKS; i++) {
+			model_indices.push_back(i);
+		}
+		std::vector<cv::Point3f> model_points = GetLandmarkPoints(model_indices);
 
-		// create the openCV Subdiv2D object
-		cv::Rect rect(0, 0, CaptureWidth() + 1, CaptureHeight() + 1);
-		cv::Subdiv2D subdiv(rect);
+		// put the model in the middle of the frame, at a typical size
+		float model_height = fabs(GetLandmarkPoint(CHIN).y - GetLandmarkPoint(HEAD_6).y);
+		float z = (float)w * model_height / (CANONICAL_FACE_SCALE * (float)h);
+		cv::Mat trx = (cv::Mat_<double>(3, 1) << 0.0, 0.0, z);
+
+		const float yaws[] = { 0.0f, CANONICAL_YAW, -CANONICAL_YAW };
+		for (int i = 0; i < 3; i++) {
+			cv::Mat rot = (cv::Mat_<double>(3, 1) << 0.0, yaws[i], 0.0);
+
+			std::vector<cv::Point2f> points;
+			cv::projectPoints(model_points, rot, trx, GetCVCamMatrix(), 
+				GetCVDistCoeffs(), points);
+			AddHeadPoints(points, rot, trx);
+			std::vector<cv::Point2f> warpedpoints = points;
+			AddMeshPoints(points, warpedpoints);
+
+			bool faceDeadOn = (yaws[i] == 0.0f);
+			std::vector<bool> included;
+			SelectTriangulationPoints(points, warpedpoints, faceDeadOn, included);
+
+			int which = CANONICAL_FRONTAL;
+			if (!faceDeadOn) {
+				which = IsTurnedLeft(warpedpoints) ?
+					CANONICAL_TURNED_LEFT : CANONICAL_TURNED_RIGHT;
+			}
+			// keeps the included set, frames only use it if they match
+			Triangulate(points, included, m_canonicalTopologies[which]);
+		}
+	}
 
-		// add our points to subdiv2d
-		// save a map: subdiv2d vtx id -> index into our points
-		std::map<int, int> vtxMap;
+	// AddMeshPoints
+	// - adds smoothing, border and hull points to the landmark + head 
+	//   points
+	//
+	void FaceDetector::AddMeshPoints(std::vector<cv::Point2f>& points,
+		std::vector<cv::Point2f>& warpedpoints) {
+
+		float width = (float)CaptureWidth();
+		float height = (float)CaptureHeight();
+
+		// add smoothing points
+		for (int i = 0; i < NUM_FACE_CONTOURS; i++) {
+			const FaceContour& fc = GetFaceContour((FaceContourID)i);
+			// smooth em out
+			CatmullRomSmooth(points, fc.indices, NUM_SMOOTHING_STEPS);
+			CatmullRomSmooth(warpedpoints, fc.indices, NUM_SMOOTHING_STEPS);
+		}
+
+		// add border points
+		BorderPoints borderpoints;
+		// 4 corners
+		borderpoints[0] = cv::Point2f(0, 0);
+		borderpoints[1] = cv::Point2f(width, 0);
+		borderpoints[2] = cv::Point2f(width, height);
+		borderpoints[3] = cv::Point2f(0, height);
+		borderpoints.length = 4;
+		// subdivide
+		for (int i = 0; i < NUM_BORDER_POINT_DIVS; i++) {
+			Subdivide(borderpoints);
+		}
+		points.insert(points.end(), borderpoints.begin(), 
+			borderpoints.begin() + borderpoints.length);
+		warpedpoints.insert(warpedpoints.end(), borderpoints.begin(),
+			borderpoints.begin() + borderpoints.length);
+
+		// add hull points
+		HullPoints hullpoints;
+		MakeHullPoints(points, warpedpoints, hullpoints);
+		points.insert(points.end(), hullpoints.begin(),
+			hullpoints.begin() + hullpoints.length);
+		warpedpoints.insert(warpedpoints.end(), hullpoints.begin(),
+			hullpoints.begin() + hullpoints.length);
+	}
+
+	// SelectTriangulationPoints
+	// - decides which points go into the triangulation
+	//
+	void FaceDetector::SelectTriangulationPoints(const std::vector<cv::Point2f>& points,
+		const std::vector<cv::Point2f>& warpedpoints, bool faceDeadOn,
+		std::vector<bool>& included) {
+
+		// only points belonging to face, hull, border
+		cv::Rect rect(0, 0, CaptureWidth() + 1, CaptureHeight() + 1);
+		included.assign(points.size(), false);
 		size_t nsmooth = GetFaceContour(FACE_CONTOUR_LAST).smooth_points_index +
 			GetFaceContour(FACE_CONTOUR_LAST).num_smooth_points;
 		LandmarkBitmask facebm = TriangulationResult::GetBitmasks()[TriangulationResult::IDXBUFF_FACE];
@@ -504,24 +638,56 @@ namespace smll {
 			facebm = facebm | TriangulationResult::GetBitmasks()[TriangulationResult::IDXBUFF_LINES];
 		}
 		for (int i = 0; i < points.size(); i++) {
-			cv::Point2f& p = points[i];
-			// only add points belonging to face, hull, border
 			if ((i >= nsmooth || (m_vtxBitmaskLookup[i] & facebm).any())
-				&& rect.contains(p)) {
-				// note: this crashes if you insert a point outside the rect.
-				try {
-					int vid = subdiv.insert(p);
-					vtxMap[vid] = i;
-				}
-				catch (const std::exception& e) {
-					// ignore
-				}
+				&& rect.contains(points[i])) {
+				included[i] = true;
 			}
 		}
 
 		// selectively add eyebrows & nose points
 		if (!faceDeadOn) {
-			AddSelectivePoints(subdiv, points, warpedpoints, vtxMap);
+			AddSelectivePoints(points, warpedpoints, included);
+		}
+	}
+
+	bool FaceDetector::MorphTopology::IsValidFor(
+		const std::vector<cv::Point2f>& points) const {
+		if (triangles.size() == 0)
+			return false;
+
+		// all our triangles are wound the same way, so if one of them
+		// is now degenerate or wound the other way, it has flipped
+		for (int i = 0; i < triangles.size(); i++) {
+			const cv::Vec3i& t = triangles[i];
+			cv::Point2f e1 = points[t[1]] - points[t[0]];
+			cv::Point2f e2 = points[t[2]] - points[t[0]];
+			if (e1.cross(e2) <= 0.0f)
+				return false;
+		}
+		return true;
+	}
+
+	void FaceDetector::Triangulate(const std::vector<cv::Point2f>& points,
+		const std::vector<bool>& included, MorphTopology& topology) {
+
+		// create the openCV Subdiv2D object
+		cv::Rect rect(0, 0, CaptureWidth() + 1, CaptureHeight() + 1);
+		cv::Subdiv2D subdiv(rect);
+
+		// add our points to subdiv2d
+		// save a map: subdiv2d vtx id -> index into our points
+		std::map<int, int> vtxMap;
+		for (int i = 0; i < points.size(); i++) {
+			if (!included[i])
+				continue;
+			// note: this crashes if you insert a point outside the rect.
+			try {
+				int vid = subdiv.insert(points[i]);
+				vtxMap[vid] = i;
+			}
+			catch (const std::exception& e) {
+				// ignore
+			}
 		}
 
 		// get triangulation
@@ -550,91 +716,87 @@ namespace smll {
 		// revVtxMap for area sorting later on.
 
 		// re-index triangles and remove bad ones
+		topology.id = ++m_topologyCount;
+		topology.included = included;
+		topology.triangles.clear();
+		topology.triangles.reserve(triangleList.size());
 		for (int i = 0; i < triangleList.size(); i++) {
-			cv::Vec3i &t = triangleList[i];
-			if (t[0] < 4 || t[1] < 4 || t[2] < 4) {
-				// mark triangle as bad
-				t[0] = 0;
-				t[1] = 0;
-				t[2] = 0;
-			}
-			else {
-				// re-index
-				t[0] = vtxMap[t[0]];
-				t[1] = vtxMap[t[1]];
-				t[2] = vtxMap[t[2]];
-			}
-		}
+			const cv::Vec3i &t = triangleList[i];
+			if (t[0] < 4 || t[1] < 4 || t[2] < 4)
+				continue;
 
-		// Make Index Buffers
-		MakeAreaIndices(result, triangleList);
+			// re-index
+			cv::Vec3i tri(vtxMap[t[0]], vtxMap[t[1]], vtxMap[t[2]]);
+
+			// wind them all the same way, so we can spot flips later
+			cv::Point2f e1 = points[tri[1]] - points[tri[0]];
+			cv::Point2f e2 = points[tri[2]] - points[tri[0]];
+			float c = e1.cross(e2);
+			if (c == 0.0f)
+				continue;
+			if (c < 0.0f)
+				std::swap(tri[1], tri[2]);
+
+			topology.triangles.push_back(tri);
+		}
 	}
 
-	void FaceDetector::AddSelectivePoints(cv::Subdiv2D& subdiv,
-		const std::vector<cv::Point2f>& points,
-		const std::vector<cv::Point2f>& warpedpoints, std::map<int, int>& vtxMap) {
+	void FaceDetector::AddSelectivePoints(const std::vector<cv::Point2f>& points,
+		const std::vector<cv::Point2f>& warpedpoints, std::vector<bool>& included) {
 
-		bool turnedLeft = warpedpoints[NOSE_4].x < warpedpoints[NOSE_1].x;
+		bool turnedLeft = IsTurnedLeft(warpedpoints);
 
 		if (turnedLeft) {
-			AddContourSelective(subdiv, GetFaceContour(FACE_CONTOUR_EYEBROW_LEFT), points, warpedpoints, vtxMap, true);
-			AddContourSelective(subdiv, GetFaceContour(FACE_CONTOUR_EYE_LEFT_TOP), points, warpedpoints, vtxMap, true);
-			AddContourSelective(subdiv, GetFaceContour(FACE_CONTOUR_EYE_LEFT_BOTTOM), points, warpedpoints, vtxMap, true);
-			AddContourSelective(subdiv, GetFaceContour(FACE_CONTOUR_EYE_LEFT_BOTTOM), points, warpedpoints, vtxMap, true);
-			AddContourSelective(subdiv, GetFaceContour(FACE_CONTOUR_MOUTH_OUTER_TOP_LEFT), points, warpedpoints, vtxMap, true);
-
-			AddContour(subdiv, GetFaceContour(FACE_CONTOUR_EYEBROW_RIGHT), points, vtxMap);
-			AddContour(subdiv, GetFaceContour(FACE_CONTOUR_EYE_RIGHT_TOP), points, vtxMap);
-			AddContour(subdiv, GetFaceContour(FACE_CONTOUR_EYE_RIGHT_BOTTOM), points, vtxMap);
-			AddContour(subdiv, GetFaceContour(FACE_CONTOUR_EYE_RIGHT_BOTTOM), points, vtxMap);
-			AddContour(subdiv, GetFaceContour(FACE_CONTOUR_MOUTH_OUTER_TOP_RIGHT), points, vtxMap);
+			AddContourSelective(GetFaceContour(FACE_CONTOUR_EYEBROW_LEFT), points, warpedpoints, included, true);
+			AddContourSelective(GetFaceContour(FACE_CONTOUR_EYE_LEFT_TOP), points, warpedpoints, included, true);
+			AddContourSelective(GetFaceContour(FACE_CONTOUR_EYE_LEFT_BOTTOM), points, warpedpoints, included, true);
+			AddContourSelective(GetFaceContour(FACE_CONTOUR_MOUTH_OUTER_TOP_LEFT), points, warpedpoints, included, true);
+
+			AddContour(GetFaceContour(FACE_CONTOUR_EYEBROW_RIGHT), points, included);
+			AddContour(GetFaceContour(FACE_CONTOUR_EYE_RIGHT_TOP), points, included);
+			AddContour(GetFaceContour(FACE_CONTOUR_EYE_RIGHT_BOTTOM), points, included);
+			AddContour(GetFaceContour(FACE_CONTOUR_MOUTH_OUTER_TOP_RIGHT), points, included);
 		}
 		else {
-			AddContourSelective(subdiv, GetFaceContour(FACE_CONTOUR_EYEBROW_RIGHT), points, warpedpoints, vtxMap, false);
-			AddContourSelective(subdiv, GetFaceContour(FACE_CONTOUR_EYE_RIGHT_TOP), points, warpedpoints, vtxMap, false);
-			AddContourSelective(subdiv, GetFaceContour(FACE_CONTOUR_EYE_RIGHT_BOTTOM), points, warpedpoints, vtxMap, false);
-			AddContourSelective(subdiv, GetFaceContour(FACE_CONTOUR_EYE_RIGHT_BOTTOM), points, warpedpoints, vtxMap, false);
-			AddContourSelective(subdiv, GetFaceContour(FACE_CONTOUR_MOUTH_OUTER_TOP_RIGHT), points, warpedpoints, vtxMap, false);
-
-			AddContour(subdiv, GetFaceContour(FACE_CONTOUR_EYEBROW_LEFT), points, vtxMap);
-			AddContour(subdiv, GetFaceContour(FACE_CONTOUR_EYE_LEFT_TOP), points, vtxMap);
-			AddContour(subdiv, GetFaceContour(FACE_CONTOUR_EYE_LEFT_BOTTOM), points, vtxMap);
-			AddContour(subdiv, GetFaceContour(FACE_CONTOUR_EYE_LEFT_BOTTOM), points, vtxMap);
-			AddContour(subdiv, GetFaceContour(FACE_CONTOUR_MOUTH_OUTER_TOP_LEFT), points, vtxMap);
-		}
-
-		AddContourSelective(subdiv, GetFaceContour(FACE_CONTOUR_NOSE_BRIDGE), points, warpedpoints, vtxMap, turnedLeft);
-		AddContourSelective(subdiv, GetFaceContour(FACE_CONTOUR_NOSE_BOTTOM), points, warpedpoints, vtxMap, turnedLeft);
-		AddContourSelective(subdiv, GetFaceContour(FACE_CONTOUR_MOUTH_OUTER_BOTTOM), points, warpedpoints, vtxMap, turnedLeft);
+			AddContourSelective(GetFaceContour(FACE_CONTOUR_EYEBROW_RIGHT), points, warpedpoints, included, false);
+			AddContourSelective(GetFaceContour(FACE_CONTOUR_EYE_RIGHT_TOP), points, warpedpoints, included, false);
+			AddContourSelective(GetFaceContour(FACE_CONTOUR_EYE_RIGHT_BOTTOM), points, warpedpoints, included, false);
+			AddContourSelective(GetFaceContour(FACE_CONTOUR_MOUTH_OUTER_TOP_RIGHT), points, warpedpoints, included, false);
+
+			AddContour(GetFaceContour(FACE_CONTOUR_EYEBROW_LEFT), points, included);
+			AddContour(GetFaceContour(FACE_CONTOUR_EYE_LEFT_TOP), points, included);
+			AddContour(GetFaceContour(FACE_CONTOUR_EYE_LEFT_BOTTOM), points, included);
+			AddContour(GetFaceContour(FACE_CONTOUR_MOUTH_OUTER_TOP_LEFT), points, included);
+		}
+
+		AddContourSelective(GetFaceContour(FACE_CONTOUR_NOSE_BRIDGE), points, warpedpoints, included, turnedLeft);
+		AddContourSelective(GetFaceContour(FACE_CONTOUR_NOSE_BOTTOM), points, warpedpoints, included, turnedLeft);
+		AddContourSelective(GetFaceContour(FACE_CONTOUR_MOUTH_OUTER_BOTTOM), points, warpedpoints, included, turnedLeft);
 	}
 
-	void FaceDetector::AddContour(cv::Subdiv2D& subdiv, const FaceContour& fc, const std::vector<cv::Point2f>& points,
-		std::map<int, int>& vtxMap) {
+	void FaceDetector::AddContour(const FaceContour& fc, const std::vector<cv::Point2f>& points,
+		std::vector<bool>& included) {
 
 		cv::Rect rect(0, 0, CaptureWidth() + 1, CaptureHeight() + 1);
 
 		// add points 
 		for (int i = 0; i < fc.indices.size(); i++) {
-			const cv::Point2f& p = points[fc.indices[i]];
-			if (rect.contains(p)) {
-				int vid = subdiv.insert(p);
-				vtxMap[vid] = fc.indices[i];
+			if (rect.contains(points[fc.indices[i]])) {
+				included[fc.indices[i]] = true;
 			}
 		}
 		int smoothidx = fc.smooth_points_index;
 		for (int i = 0; i < fc.num_smooth_points; i++, smoothidx++) {
-			const cv::Point2f& p = points[smoothidx];
-			if (rect.contains(p)) {
-				int vid = subdiv.insert(p);
-				vtxMap[vid] = smoothidx;
+			if (rect.contains(points[smoothidx])) {
+				included[smoothidx] = true;
 			}
 		}
 	}
 
 
-	void FaceDetector::AddContourSelective(cv::Subdiv2D& subdiv, const FaceContour& fc,
+	void FaceDetector::AddContourSelective(const FaceContour& fc,
 		const std::vector<cv::Point2f>& points,
-		const std::vector<cv::Point2f>& warpedpoints, std::map<int, int>& vtxMap, 
+		const std::vector<cv::Point2f>& warpedpoints, std::vector<bool>& included, 
 		bool checkLeft) {
 
 		std::array<int, 15> lhead_points = { HEAD_6, HEAD_5, HEAD_4, HEAD_3, HEAD_2, 
@@ -687,8 +849,7 @@ namespace smll {
 			float d = m * ((p1.x - lo.x) * (hi.y - lo.y) - (p1.y - lo.y) * (hi.x - lo.x));
 			const cv::Point2f& p = points[fc.indices[i]];
 			if (d > 10.0f && rect.contains(p)) {
-				int vid = subdiv.insert(p);
-				vtxMap[vid] = fc.indices[i];
+				included[fc.indices[i]] = true;
 			}
 			else
 				break;
@@ -699,26 +860,23 @@ namespace smll {
 			float d = m * ((p1.x - lo.x) * (hi.y - lo.y) - (p1.y - lo.y) * (hi.x - lo.x));
 			const cv::Point2f& p = points[smoothidx];
 			if (d > 10.0f && rect.contains(p)) {
-				int vid = subdiv.insert(p);
-				vtxMap[vid] = smoothidx;
+				included[smoothidx] = true;
 			}
 			else
 				break;
 		}
 	}
 
-	void FaceDetector::AddHeadPoints(std::vector<cv::Point2f>& points, const DetectionResult& face) {
+	void FaceDetector::AddHeadPoints(std::vector<cv::Point2f>& points, 
+		const cv::Mat& rot, const cv::Mat& trx) {
 
 		points.reserve(points.size() + HP_NUM_HEAD_POINTS);
 
 		// get the head points
-		std::vector<cv::Point3f> headpoints = GetAllHeadPoints();
+		const std::vector<cv::Point3f>& headpoints = GetAllHeadPoints();
 
 		// project all the head points
-		const cv::Mat& rot = face.GetCVRotation();
-		cv::Mat trx = face.GetCVTranslation();
-
-		std::vector<cv::Point2f> projheadpoints;
+		std::vector<cv::Point2f>& projheadpoints = m_projectedHeadPoints;
 		cv::projectPoints(headpoints, rot, trx, GetCVCamMatrix(), GetCVDistCoeffs(), projheadpoints);
 
 		// select the correct points
@@ -759,7 +917,7 @@ namespace smll {
 	//   and keep the rest of the video frame from morphing with it
 	//
 	void FaceDetector::MakeHullPoints(const std::vector<cv::Point2f>& points,
-		const std::vector<cv::Point2f>& warpedpoints, std::vector<cv::Point2f>& hullpoints) {
+		const std::vector<cv::Point2f>& warpedpoints, HullPoints& hullpoints) {
 		// consider outside contours only
 		const int num_contours = 2;
 		const FaceContourID contours[num_contours] = { FACE_CONTOUR_CHIN, FACE_CONTOUR_HEAD };
@@ -776,6 +934,7 @@ namespace smll {
 		center /= (float)numPoints;
 
 		// go through the warped points, see if they expand the hull
+		hullpoints.length = 0;
 		// - we do this by checking the dot product of the delta to the
 		//   warped point with the vector to the original point from
 		//   the center
@@ -802,22 +961,22 @@ namespace smll {
 				// if dot product is positive
 				if (d.dot(v) > 0) {
 					// warped point expands hull
-					hullpoints.push_back(wp);
+					hullpoints[hullpoints.length++] = wp;
 				}
 				else {
 					// warped point shrinks hull, use original
-					hullpoints.push_back(p);
+					hullpoints[hullpoints.length++] = p;
 				}
 			}
 		}
 
 		// scale up hull points from center
-		for (int i = 0; i < hullpoints.size(); i++) {
+		for (int i = 0; i < hullpoints.length; i++) {
 			hullpoints[i] = ((hullpoints[i] - center) * HULL_POINTS_SCALE) + center;
 		}
 
 		// subdivide
-		for (int i = 0; i < NUM_BORDER_POINT_DIVS; i++) {
+		for (int i = 0; i < NUM_HULL_POINT_DIVS; i++) {
 			Subdivide(hullpoints);
 		}
 	}
@@ -827,8 +986,11 @@ namespace smll {
 	void FaceDetector::MakeAreaIndices(TriangulationResult& result,
 		const std::vector<cv::Vec3i>& triangleList) {
 
-		// Allocate temp storage for triangle indices
-		std::vector<uint32_t> triangles[TriangulationResult::NUM_INDEX_BUFFERS];
+		// Triangle indices go straight into the result
+		std::vector<uint32_t>* triangles = result.indices;
+		for (int i = 0; i < TriangulationResult::NUM_INDEX_BUFFERS; i++) {
+			triangles[i].clear();
+		}
 		triangles[TriangulationResult::IDXBUFF_BACKGROUND].reserve(triangleList.size() * 3);
 		triangles[TriangulationResult::IDXBUFF_FACE].reserve(triangleList.size() * 3);
 		triangles[TriangulationResult::IDXBUFF_HULL].reserve(triangleList.size() * 3);
@@ -911,54 +1073,79 @@ namespace smll {
 				triangles[TriangulationResult::IDXBUFF_BACKGROUND].push_back(i2);
 			}
 		}
-
-		// Build index buffers
-		// TODO: again, best to leave graphics calls to render() method
-		//
-		for (int i = 0; i < TriangulationResult::NUM_INDEX_BUFFERS; i++) {
-			if (i == TriangulationResult::IDXBUFF_LINES && !result.buildLines)
-				continue;
-			obs_enter_graphics();
-			uint32_t* indices = (uint32_t*)bmalloc(sizeof(uint32_t) * triangles[i].size());
-			memcpy(indices, triangles[i].data(), sizeof(uint32_t) * triangles[i].size());
-			result.indexBuffers[i] = gs_indexbuffer_create(gs_index_type::GS_UNSIGNED_LONG,
-				(void*)indices, triangles[i].size(), 0);
-			obs_leave_graphics();
-		}
 	}
 
 	// Subdivide : insert points half-way between all the points
+	// - works in place, back to front, so every original point is 
+	//   still there when we need it
 	//
-	void FaceDetector::Subdivide(std::vector<cv::Point2f>& points) {
-		points.reserve(points.size() * 2);
-		for (unsigned int i = 0; i < points.size(); i++) {
-			int i2 = (i + 1) % points.size();
-			points.insert(points.begin()+i2, cv::Point2f(
-				(points[i].x + points[i2].x) / 2.0f,
-				(points[i].y + points[i2].y) / 2.0f));
-			i++;
-		}
+	template<std::size_t N>
+	void FaceDetector::Subdivide(sarray<cv::Point2f, N>& points) {
+		int n = points.length;
+		if (n * 2 > (int)N) {
+			throw std::logic_error("Subdivide: not enough room for points.");
+		}
+		cv::Point2f first = points[0];
+		for (int i = n - 1; i >= 0; i--) {
+			const cv::Point2f& next = (i == n - 1) ? first : points[i + 1];
+			cv::Point2f p = points[i];
+			points[i * 2] = p;
+			points[i * 2 + 1] = cv::Point2f((p.x + next.x) / 2.0f,
+				(p.y + next.y) / 2.0f);
+		}
+		points.length = n * 2;
 	}
 
+	// Catmull-Rom basis weights for t = 1/5, 2/5, 3/5, 4/5
+	// Note: skip points at t=0 and t=1, they are already in our set
+	static const int NUM_T = NUM_SMOOTHING_STEPS - 1;
+	static_assert(NUM_T == 4, "SSE Catmull-Rom expects 4 points per segment");
+	struct CatmullRomWeights {
+		__m128 w[4];
+		CatmullRomWeights() {
+			float wf[4][NUM_T];
+			for (int k = 0; k < NUM_T; k++) {
+				float t = (float)(k + 1) / (float)NUM_SMOOTHING_STEPS;
+				float t2 = t * t;
+				float t3 = t2 * t;
+				wf[0][k] = 0.5f * (-t + 2.0f * t2 - t3);
+				wf[1][k] = 0.5f * (2.0f - 5.0f * t2 + 3.0f * t3);
+				wf[2][k] = 0.5f * (t + 4.0f * t2 - 3.0f * t3);
+				wf[3][k] = 0.5f * (-t2 + t3);
+			}
+			for (int j = 0; j < 4; j++) {
+				w[j] = _mm_loadu_ps(wf[j]);
+			}
+		}
+	};
+
 	// Curve Fitting - Catmull-Rom spline
 	// https://gist.github.com/pr0digy/1383576
 	// - converted to C++
 	// - modified for my uses
+	// - the spline basis only depends on t, and we always use the same
+	//   4 t values, so we evaluate the 4 points of a segment at once
+	//   with SSE
 	void FaceDetector::CatmullRomSmooth(std::vector<cv::Point2f>& points, 
 		const std::vector<int>& indices, int steps) {
 
 		if (indices.size() < 3)
 			return;
 
-		points.reserve(points.size() + ((indices.size() - 1) * (steps - 1)));
-
-		float dt = 1.0f / (float)steps;
+		if (steps != NUM_SMOOTHING_STEPS) {
+			throw std::invalid_argument("CatmullRomSmooth: unsupported step count.");
+		}
+		static const CatmullRomWeights weights;
+		const __m128* w = weights.w;
 
-		float x, y;
-		size_t i0, i1, i2, i3;
 		size_t count = indices.size() - 1;
 		size_t count_m1 = count - 1;
-		for (size_t i = 0; i < count; i++) {
+		size_t start = points.size();
+		points.resize(start + count * NUM_T);
+		float* out = (float*)(points.data() + start);
+
+		size_t i0, i1, i2, i3;
+		for (size_t i = 0; i < count; i++, out += NUM_T * 2) {
 			if (i == 0) {
 				// 0 0 1 2 (i == 0)
 				i0 = indices[i];
@@ -985,35 +1172,25 @@ namespace smll {
 			const cv::Point2f& p2 = points[i2];
 			const cv::Point2f& p3 = points[i3];
 
-			// TODO: we have more than a couple of SSE-enabled math libraries on tap
-			//       we should be using one here
-			//       ie) dlib/openCV/libOBS
-			//
-			// Note: skip points at t=0 and t=1, they are already in our set
-			//
-			for (float t = dt; t < 1.0f; t += dt) {
-				float t2 = t * t;
-				float t3 = t2 * t;
+			__m128 x = _mm_mul_ps(w[0], _mm_set1_ps(p0.x));
+			x = _mm_add_ps(x, _mm_mul_ps(w[1], _mm_set1_ps(p1.x)));
+			x = _mm_add_ps(x, _mm_mul_ps(w[2], _mm_set1_ps(p2.x)));
+			x = _mm_add_ps(x, _mm_mul_ps(w[3], _mm_set1_ps(p3.x)));
 
-				x = 0.5f * 
-					((2.0f * p1.x) +
-					 (p2.x - p0.x) * t +
-					 (2.0f * p0.x - 5.0f * p1.x + 4.0f * p2.x - p3.x) * t2 +
-					 (3.0f * p1.x - p0.x - 3.0f * p2.x + p3.x) * t3);
-					
-				y = 0.5f *
-					((2.0f * p1.y) +
-					 (p2.y - p0.y) * t +
-					 (2.0f * p0.y - 5.0f * p1.y + 4.0f * p2.y - p3.y) * t2 +
-					 (3.0f * p1.y - p0.y - 3.0f * p2.y + p3.y) * t3);
-
-				points.push_back(cv::Point2f(x, y));
-			}
+			__m128 y = _mm_mul_ps(w[0], _mm_set1_ps(p0.y));
+			y = _mm_add_ps(y, _mm_mul_ps(w[1], _mm_set1_ps(p1.y)));
+			y = _mm_add_ps(y, _mm_mul_ps(w[2], _mm_set1_ps(p2.y)));
+			y = _mm_add_ps(y, _mm_mul_ps(w[3], _mm_set1_ps(p3.y)));
+
+			// interleave back into x,y pairs
+			_mm_storeu_ps(out, _mm_unpacklo_ps(x, y));
+			_mm_storeu_ps(out + 4, _mm_unpackhi_ps(x, y));
 		}
 	}
 
 	void FaceDetector::ScaleMorph(std::vector<cv::Point2f>& points,
-		std::vector<int> indices, cv::Point2f& center, cv::Point2f& scale) {
+		const std::vector<int>& indices, const cv::Point2f& center, 
+		const cv::Point2f& scale) {
 		for (auto i : indices) {
 			points[i].x = (points[i].x - center.x) * scale.x + center.x;
 			points[i].y = (points[i].y - center.y) * scale.y + center.y;
@@ -1113,8 +1290,7 @@ namespace smll {
 		for (int i = 0; i < m_faces.length; i++) {
 			if (i == m_trackingFaceIndex) {
 				double confidence = m_faces[i].UpdateTracking(img);
-				if (confidence < Config::singleton().get_double(
-					CONFIG_DOUBLE_TRACKING_THRESHOLD)) {
+				if (confidence < m_config->trackingThreshold) {
 					m_faces.length = 0;
 					break;
 				}
@@ -28,6 +28,7 @@
 #include "DetectionResults.hpp"
 #include "TriangulationResult.hpp"
 #include "MorphData.hpp"
+#include "sarray.hpp"
 
 #include <stdexcept>
 
@@ -55,12 +56,18 @@
 
 namespace smll {
 
+// border points = 4 corners + subdivide
+#define NUM_BORDER_POINTS		(4 * 2 * 2 * 2) 
+#define NUM_BORDER_POINT_DIVS	(3)
+// hull points = head + jaw + subdivide
+#define NUM_HULL_POINTS			(28 * 2 * 2 * 2)
+#define NUM_HULL_POINT_DIVS		(3)
 
 class FaceDetector
 {
 public:
 
-	FaceDetector();
+	FaceDetector(const Config& config);
 	~FaceDetector();
 
 	void DetectFaces(const OBSTexture& capture, int w, int h, DetectionResults& results);
@@ -86,6 +93,10 @@ private:
 	// Saved Poses
 	ThreeDPoses		m_poses;
 
+	// Our config, and a snapshot of it for the current frame
+	const Config&		m_configSource;
+	ConfigSnapshotPtr	m_config;
+
 	// Face detection timeouts
     int             m_trackingTimeout;
     int             m_detectionTimeout;
@@ -114,6 +125,37 @@ private:
 	std::vector<LandmarkBitmask>	m_vtxBitmaskLookup;
 	void							MakeVtxBitmaskLookup();
 
+	// Morph triangulation topology
+	// - the Delaunay triangulation hardly ever changes from frame to
+	//   frame, so we keep the last one around and only re-triangulate
+	//   when the set of included points changes, or a triangle flips
+	struct MorphTopology {
+		int						id;			// changes on re-triangulate
+		std::vector<bool>		included;	// point-inclusion bitmask
+		std::vector<cv::Vec3i>	triangles;	// indices into our points
+
+		MorphTopology() : id(-1) {}
+
+		bool	IsValidFor(const std::vector<cv::Point2f>& points) const;
+	};
+	MorphTopology					m_morphTopology;
+	int								m_topologyCount;
+
+	// Canonical topologies
+	// - built lazily, once per capture size, from the 3D landmark model,
+	//   these cover the common near-frontal poses without any per-frame
+	//   Delaunay at all
+	enum {
+		CANONICAL_FRONTAL,
+		CANONICAL_TURNED_LEFT,
+		CANONICAL_TURNED_RIGHT,
+
+		NUM_CANONICAL_TOPOLOGIES
+	};
+	MorphTopology					m_canonicalTopologies[NUM_CANONICAL_TOPOLOGIES];
+	int								m_canonical_w, m_canonical_h;
+	void							MakeCanonicalTopologies();
+
 	bool loaded;
 	bool avx;
 	HINSTANCE hGetProcIDDLL;
@@ -171,25 +213,48 @@ private:
 		const std::vector<cv::Point2f>& image_points,
 		const cv::Mat& rotation, const cv::Mat& translation);
 
+	// Morph triangulation working storage
+	// - kept around so building the mesh doesn't allocate every frame
+	typedef sarray<cv::Point2f, NUM_BORDER_POINTS>	BorderPoints;
+	typedef sarray<cv::Point2f, NUM_HULL_POINTS>	HullPoints;
+	std::vector<cv::Point2f>	m_points;
+	std::vector<cv::Point2f>	m_warpedPoints;
+	std::vector<cv::Point3f>	m_deltas;
+	std::vector<cv::Point2f>	m_projectedDeltas;
+	std::vector<cv::Point2f>	m_projectedHeadPoints;
+	std::vector<bool>			m_included;
+
 	// Morph Triangulation Helpers
-	void	Subdivide(std::vector<cv::Point2f>& points);
+	template<std::size_t N>
+	void	Subdivide(sarray<cv::Point2f, N>& points);
 	void	CatmullRomSmooth(std::vector<cv::Point2f>& points, 
 		const std::vector<int>& indices, int steps);
 	void	ScaleMorph(std::vector<cv::Point2f>& points,
-		std::vector<int> indices, cv::Point2f& center, cv::Point2f& scale);
+		const std::vector<int>& indices, const cv::Point2f& center, 
+		const cv::Point2f& scale);
 	void	MakeHullPoints(const std::vector<cv::Point2f>& points,
-		const std::vector<cv::Point2f>& warpedpoints, 
-		std::vector<cv::Point2f>& hullpoints);
+		const std::vector<cv::Point2f>& warpedpoints, HullPoints& hullpoints);
+	void	MakeVertices(TriangulationResult& result,
+		const std::vector<cv::Point2f>& points,
+		const std::vector<cv::Point2f>& warpedpoints);
 	void	MakeAreaIndices(TriangulationResult& result,
 		const std::vector<cv::Vec3i>& triangles);
-	void	AddHeadPoints(std::vector<cv::Point2f>& points, const DetectionResult& face);
-	void    AddSelectivePoints(cv::Subdiv2D& subdiv, const std::vector<cv::Point2f>& points,
-		const std::vector<cv::Point2f>& warpedpoints, std::map<int, int>& vtxMap);
-	void	AddContourSelective(cv::Subdiv2D& subdiv, const FaceContour& fc,
+	void	AddHeadPoints(std::vector<cv::Point2f>& points, 
+		const cv::Mat& rot, const cv::Mat& trx);
+	void	AddMeshPoints(std::vector<cv::Point2f>& points,
+		std::vector<cv::Point2f>& warpedpoints);
+	void	SelectTriangulationPoints(const std::vector<cv::Point2f>& points,
+		const std::vector<cv::Point2f>& warpedpoints, bool faceDeadOn,
+		std::vector<bool>& included);
+	void    AddSelectivePoints(const std::vector<cv::Point2f>& points,
+		const std::vector<cv::Point2f>& warpedpoints, std::vector<bool>& included);
+	void	AddContourSelective(const FaceContour& fc,
 		const std::vector<cv::Point2f>& points,
-		const std::vector<cv::Point2f>& warpedpoints, std::map<int, int>& vtxMap, bool checkLeft=true);
-	void	AddContour(cv::Subdiv2D& subdiv, const FaceContour& fc,	const std::vector<cv::Point2f>& points,
-		std::map<int, int>& vtxMap);
+		const std::vector<cv::Point2f>& warpedpoints, std::vector<bool>& included, bool checkLeft=true);
+	void	AddContour(const FaceContour& fc, const std::vector<cv::Point2f>& points,
+		std::vector<bool>& included);
+	void	Triangulate(const std::vector<cv::Point2f>& points,
+		const std::vector<bool>& included, MorphTopology& topology);
 };
 
 
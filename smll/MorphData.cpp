@@ -35,14 +35,12 @@ namespace smll {
 		return m_deltas;
 	}
 
-	std::vector<cv::Point3f> MorphData::GetCVDeltas() const {
-		std::vector<cv::Point3f> r;
-		r.reserve(NUM_MORPH_LANDMARKS);
+	void MorphData::GetCVDeltas(std::vector<cv::Point3f>& deltas) const {
+		deltas.resize(NUM_MORPH_LANDMARKS);
 		for (unsigned int i = 0; i < NUM_MORPH_LANDMARKS; i++) {
 			const vec3& v = m_deltas[i];
-			r.emplace_back(cv::Point3f(v.x, v.y, v.z));
+			deltas[i] = cv::Point3f(v.x, v.y, v.z);
 		}
-		return r;
 	}
 
 	DeltaList& MorphData::GetDeltasAndStamp() {
@@ -43,7 +43,7 @@ namespace smll {
 		MorphData();
 
 		const DeltaList&			GetDeltas() const;
-		std::vector<cv::Point3f>	GetCVDeltas() const;
+		void						GetCVDeltas(std::vector<cv::Point3f>& deltas) const;
 		DeltaList&					GetDeltasAndStamp();
 		const LandmarkBitmask&		GetBitmask();
 
@@ -195,13 +195,14 @@ namespace smll {
 		m_textures[texture] = nullptr;
 	}
 
-	void OBSRenderer::DrawFaces(const DetectionResults& faces) {
+	void OBSRenderer::DrawFaces(const DetectionResults& faces, 
+		const ConfigSnapshot& config) {
 		gs_effect_t    *solid = obs_get_base_effect(OBS_EFFECT_SOLID);
 
 		//check list of landmarks drawing
 		bool landmark_checks[smll::NUM_FACIAL_LANDMARKS];
 		for (int i = 0; i < smll::NUM_FACIAL_LANDMARKS; i++) {
-			landmark_checks[i] = Config::singleton().get_bool((std::string(CONFIG_BOOL_SMOOTH_LANDMARK) + std::to_string(i + 1)).c_str());
+			landmark_checks[i] = config.smoothLandmark[i];
 		}
 
 		for (int i = 0; i < faces.length; i++) {
@@ -65,7 +65,7 @@ namespace smll {
 		gs_vertbuffer_t* GetVertexBuffer(int which);
 		void    DestroyVertexBufffer(int which);
 
-		void	DrawFaces(const DetectionResults& faces);
+		void	DrawFaces(const DetectionResults& faces, const ConfigSnapshot& config);
 		void	DrawLandmarks(const dlib::point* points, bool * checklist);
 		void	DrawRect(const dlib::rectangle& r, int width = 1);
 
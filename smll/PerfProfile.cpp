@@ -0,0 +1,101 @@
+/*
+* Face Masks for SlOBS
+* smll - streamlabs machine learning library
+*
+* Copyright (C) 2017 General Workings Inc
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+*/
+#include "PerfProfile.hpp"
+
+// auto profile: weight of each new detection time in the average
+#define AUTO_AVERAGE_WEIGHT		(0.05)
+// auto profile: step down when over budget for this many detections
+#define AUTO_STEP_DOWN_COUNT	(30)
+// auto profile: step up when well under budget for this many detections
+#define AUTO_STEP_UP_COUNT		(300)
+// auto profile: "well under budget" fraction of the frame interval
+#define AUTO_HEADROOM			(0.4)
+
+
+namespace smll {
+
+	// auto has no row, it always resolves to one of these
+	static const PerfProfile g_perf_profiles[PERF_PROFILE_AUTO] = {
+		// name        width recheck track speed kalman ssaa lighting
+		{ "manual",      480,   30,    1,   24,   true, true,  2 },
+		{ "eco",         240,   60,    3,   66,  false, false, 4 },
+		{ "balanced",    360,   30,    2,   33,   true, false, 4 },
+		{ "quality",     480,   20,    1,   16,   true, true,  2 },
+	};
+
+	const PerfProfile& GetPerfProfile(PerfProfileID id) {
+		if (id < 0 || id >= PERF_PROFILE_AUTO)
+			id = PERF_PROFILE_MANUAL;
+		return g_perf_profiles[id];
+	}
+
+	AutoPerfProfile::AutoPerfProfile()
+		: m_current(PERF_PROFILE_BALANCED)
+		, m_averageMs(0.0)
+		, m_overBudget(0)
+		, m_underBudget(0) {
+	}
+
+	bool AutoPerfProfile::Update(double detectMs, double frameIntervalMs) {
+		if (m_averageMs == 0.0)
+			m_averageMs = detectMs;
+		else
+			m_averageMs += (detectMs - m_averageMs) * AUTO_AVERAGE_WEIGHT;
+
+		// count how long we've been over/under budget
+		if (m_averageMs > frameIntervalMs) {
+			m_overBudget++;
+			m_underBudget = 0;
+		}
+		else if (m_averageMs < frameIntervalMs * AUTO_HEADROOM) {
+			m_underBudget++;
+			m_overBudget = 0;
+		}
+		else {
+			m_overBudget = 0;
+			m_underBudget = 0;
+		}
+
+		PerfProfileID last = m_current;
+		if (m_overBudget >= AUTO_STEP_DOWN_COUNT) {
+			if (m_current == PERF_PROFILE_QUALITY)
+				m_current = PERF_PROFILE_BALANCED;
+			else if (m_current == PERF_PROFILE_BALANCED)
+				m_current = PERF_PROFILE_ECO;
+			m_overBudget = 0;
+		}
+		else if (m_underBudget >= AUTO_STEP_UP_COUNT) {
+			if (m_current == PERF_PROFILE_ECO)
+				m_current = PERF_PROFILE_BALANCED;
+			else if (m_current == PERF_PROFILE_BALANCED)
+				m_current = PERF_PROFILE_QUALITY;
+			m_underBudget = 0;
+		}
+
+		// new profile, new timings
+		if (m_current != last) {
+			m_averageMs = 0.0;
+			return true;
+		}
+		return false;
+	}
+
+} // smll namespace
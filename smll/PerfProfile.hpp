@@ -0,0 +1,77 @@
+/*
+* Face Masks for SlOBS
+* smll - streamlabs machine learning library
+*
+* Copyright (C) 2017 General Workings Inc
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+*/
+#ifndef __SMLL_PERF_PROFILE_HPP__
+#define __SMLL_PERF_PROFILE_HPP__
+
+#pragma once
+
+namespace smll {
+
+	// Performance profiles
+	// - one knob to trade quality for CPU. Manual leaves all the
+	//   individual detection params alone.
+	enum PerfProfileID {
+		PERF_PROFILE_MANUAL = 0,
+		PERF_PROFILE_ECO,
+		PERF_PROFILE_BALANCED,
+		PERF_PROFILE_QUALITY,
+		PERF_PROFILE_AUTO,
+
+		NUM_PERF_PROFILES
+	};
+
+	struct PerfProfile
+	{
+		const char*	name;
+		int			faceDetectWidth;
+		int			faceDetectRecheckFrequency;
+		int			trackingFrequency;
+		int			speedLimit;
+		bool		kalmanEnable;
+		bool		allowSSAA;
+		int			lightingReduction; // first lighting downsample, <= 4 (2x2 taps)
+	};
+
+	// auto (or anything out of range) gives manual, resolve it first
+	const PerfProfile&	GetPerfProfile(PerfProfileID id);
+
+	// Auto profile
+	// - steps between eco, balanced and quality depending on how long
+	//   detection takes compared to the video frame interval
+	class AutoPerfProfile
+	{
+	public:
+		AutoPerfProfile();
+
+		// returns true if the profile changed
+		bool			Update(double detectMs, double frameIntervalMs);
+		PerfProfileID	Current() const { return m_current; }
+
+	private:
+		PerfProfileID	m_current;
+		double			m_averageMs;
+		int				m_overBudget;
+		int				m_underBudget;
+	};
+
+} // smll namespace
+
+#endif // __SMLL_PERF_PROFILE_HPP__
@@ -20,10 +20,15 @@
 */
 #include "TriangulationResult.hpp"
 
+#include <utility>
+#include <cstring>
+
 extern "C" {
 #pragma warning( push )
 #pragma warning( disable: 4201 )
 #include <libobs/obs.h>
+#include <libobs/graphics/vec2.h>
+#include <libobs/graphics/vec3.h>
 #pragma warning( pop )
 }
 
@@ -147,8 +152,10 @@ namespace smll {
 	TriangulationResult::BitmaskTable TriangulationResult::bitmasks;
 	
 
-	TriangulationResult::TriangulationResult() : vertexBuffer(nullptr),
-		buildLines(false), autoBGRemoval(false), cartoonMode(false) {
+	TriangulationResult::TriangulationResult() : topologyId(-1), 
+		valid(false), buildLines(false), vertexBuffer(nullptr), 
+		uploadedTopologyId(-1), verticesDirty(false),
+		autoBGRemoval(false), cartoonMode(false) {
 		for (int i = 0; i < NUM_INDEX_BUFFERS; i++) {
 			indexBuffers[i] = nullptr;
 		}
@@ -158,47 +165,106 @@ namespace smll {
 		DestroyBuffers();
 	}
 
+	void TriangulationResult::TakeMeshFrom(TriangulationResult& other) {
+		// nothing new?
+		if (!other.valid)
+			return;
+
+		// swap meshes, so the other side gets our old arrays
+		// back to fill in without allocating
+		positions.swap(other.positions);
+		uvs.swap(other.uvs);
+		colors.swap(other.colors);
+		for (int i = 0; i < NUM_INDEX_BUFFERS; i++) {
+			indices[i].swap(other.indices[i]);
+		}
+		std::swap(topologyId, other.topologyId);
+		valid = true;
+		verticesDirty = true;
+		other.valid = false;
+	}
+
+	void TriangulationResult::UploadBuffers() {
+		if (!valid)
+			return;
+
+		if (verticesDirty) {
+			size_t nv = positions.size();
+
+			// need a new one?
+			if (vertexBuffer &&
+				gs_vertexbuffer_get_data(vertexBuffer)->num != nv) {
+				gs_vertexbuffer_destroy(vertexBuffer);
+				vertexBuffer = nullptr;
+			}
+			if (vertexBuffer == nullptr) {
+				gs_vb_data* vbd = gs_vbdata_create();
+				vbd->num = nv;
+				vbd->points = (struct vec3*)bmalloc(sizeof(struct vec3) * nv);
+				vbd->colors = (uint32_t*)bmalloc(sizeof(uint32_t) * nv);
+				vbd->num_tex = 1;
+				vbd->tvarray = (struct gs_tvertarray*)bmalloc(sizeof(struct gs_tvertarray));
+				vbd->tvarray[0].width = 2;
+				vbd->tvarray[0].array = bmalloc(sizeof(struct vec2) * nv);
+				vertexBuffer = gs_vertexbuffer_create(vbd, GS_DYNAMIC);
+			}
+
+			// fill it in
+			gs_vb_data* vbd = gs_vertexbuffer_get_data(vertexBuffer);
+			struct vec2* tv = (struct vec2*)vbd->tvarray[0].array;
+			for (int i = 0; i < nv; i++) {
+				vec3_set(vbd->points + i, positions[i].x, positions[i].y, 0.0f);
+				vec2_set(tv + i, uvs[i].x, uvs[i].y);
+			}
+			memcpy(vbd->colors, colors.data(), sizeof(uint32_t) * nv);
+			gs_vertexbuffer_flush(vertexBuffer);
+			verticesDirty = false;
+		}
+
+		// index buffers only change with the topology
+		bool needLines = buildLines && !indices[IDXBUFF_LINES].empty() &&
+			indexBuffers[IDXBUFF_LINES] == nullptr;
+		if (uploadedTopologyId != topologyId || needLines) {
+			DestroyIndexBuffers();
+			for (int i = 0; i < NUM_INDEX_BUFFERS; i++) {
+				if (i == IDXBUFF_LINES && (!buildLines || indices[i].empty()))
+					continue;
+				uint32_t* idx = (uint32_t*)bmalloc(sizeof(uint32_t) * indices[i].size());
+				memcpy(idx, indices[i].data(), sizeof(uint32_t) * indices[i].size());
+				indexBuffers[i] = gs_indexbuffer_create(gs_index_type::GS_UNSIGNED_LONG,
+					(void*)idx, indices[i].size(), 0);
+			}
+			uploadedTopologyId = topologyId;
+		}
+	}
+
 	void TriangulationResult::DestroyBuffers() {
 		obs_enter_graphics();
 		if (vertexBuffer)
 			gs_vertexbuffer_destroy(vertexBuffer);
 		vertexBuffer = nullptr;
+		obs_leave_graphics();
+		DestroyIndexBuffers();
+	}
+
+	void TriangulationResult::DestroyIndexBuffers() {
+		obs_enter_graphics();
 		for (int i = 0; i < NUM_INDEX_BUFFERS; i++) {
 			if (indexBuffers[i])
 				gs_indexbuffer_destroy(indexBuffers[i]);
 			indexBuffers[i] = nullptr;
 		}
 		obs_leave_graphics();
+		uploadedTopologyId = -1;
 	}
 
 	void TriangulationResult::DestroyLineBuffer() {
+		if (indexBuffers[IDXBUFF_LINES] == nullptr)
+			return;
 		obs_enter_graphics();
-		if (indexBuffers[IDXBUFF_LINES])
-			gs_indexbuffer_destroy(indexBuffers[IDXBUFF_LINES]);
+		gs_indexbuffer_destroy(indexBuffers[IDXBUFF_LINES]);
 		obs_leave_graphics();
 		indexBuffers[IDXBUFF_LINES] = nullptr;
 	}
 
-	void TriangulationResult::TakeBuffersFrom(TriangulationResult& other) {
-
-		obs_enter_graphics();
-		if (other.vertexBuffer) {
-			if (vertexBuffer) {
-				gs_vertexbuffer_destroy(vertexBuffer);
-			}
-			vertexBuffer = other.vertexBuffer;
-			other.vertexBuffer = nullptr;
-		}
-		for (int i = 0; i < NUM_INDEX_BUFFERS; i++) {
-			if (other.indexBuffers[i]) {
-				if (indexBuffers[i]) {
-					gs_indexbuffer_destroy(indexBuffers[i]);
-				}
-				indexBuffers[i] = other.indexBuffers[i];
-				other.indexBuffers[i] = nullptr;
-			}
-		}
-		obs_leave_graphics();
-	}
-
 }
@@ -30,6 +30,7 @@ extern "C" {
 }
 
 #include <array>
+#include <vector>
 
 namespace smll {
 
@@ -49,20 +50,49 @@ namespace smll {
 
 		typedef std::array<LandmarkBitmask, NUM_INDEX_BUFFERS> BitmaskTable;
 
-		gs_vertbuffer_t*		vertexBuffer;
-		gs_indexbuffer_t*		indexBuffers[NUM_INDEX_BUFFERS];
-		bool					buildLines;
+		// CPU side mesh
+		// - built by the detection thread, without touching the graphics
+		//   subsystem. The arrays keep their storage between frames, and
+		//   get swapped (not copied) over to the render thread.
+		std::vector<cv::Point2f>	positions;
+		std::vector<cv::Point2f>	uvs;
+		std::vector<uint32_t>		colors;
+		std::vector<uint32_t>		indices[NUM_INDEX_BUFFERS];
+		int							topologyId;	// topology indices came from
+		bool						valid;
+		bool						buildLines;
+
+		// GPU buffers
+		// - owned by the render thread, and uploaded lazily from the
+		//   CPU mesh. The vertex buffer is dynamic and updated in place,
+		//   the index buffers are only rebuilt when the topology changes.
+		gs_vertbuffer_t*			vertexBuffer;
+		gs_indexbuffer_t*			indexBuffers[NUM_INDEX_BUFFERS];
+		int							uploadedTopologyId;
+		bool						verticesDirty;
 
 		// flags for triangulation/rendering
-		bool					autoBGRemoval;
-		bool					cartoonMode;
+		bool						autoBGRemoval;
+		bool						cartoonMode;
 
 		TriangulationResult();
 		~TriangulationResult();
 
+		bool IsValid() const {
+			return valid && vertexBuffer != nullptr;
+		}
+		void Invalidate() {
+			valid = false;
+		}
+
+		// detection thread -> render thread
+		void TakeMeshFrom(TriangulationResult& other);
+
+		// render thread only (in the graphics context)
+		void UploadBuffers();
 		void DestroyBuffers();
+		void DestroyIndexBuffers();
 		void DestroyLineBuffer();
-		void TakeBuffersFrom(TriangulationResult& other);
 
 		static const BitmaskTable& GetBitmasks();
 
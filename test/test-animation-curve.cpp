@@ -0,0 +1,136 @@
+/*
+* Face Masks for SlOBS
+*
+* Copyright (C) 2017 General Workings Inc
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+*/
+#include <CppUTest/TestHarness.h>
+#include "mask/mask-animation-curve.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+static const float TOLERANCE = 0.001f;
+
+// every frame within tolerance, played forwards, backwards and at random
+static void check_curve(const std::vector<float>& values) {
+	std::vector<uint8_t> data = Mask::AnimationCurve::Encode(values.data(),
+		values.size(), TOLERANCE);
+	Mask::AnimationCurve curve;
+	CHECK_TRUE(curve.Load(data.data(), data.size()));
+	CHECK_EQUAL((int)values.size(), curve.GetNumFrames());
+
+	int numFrames = (int)values.size();
+	for (int f = 0; f < numFrames; f++)
+		DOUBLES_EQUAL(values[f], curve.Evaluate(f), TOLERANCE);
+	for (int f = numFrames - 1; f >= 0; f--)
+		DOUBLES_EQUAL(values[f], curve.Evaluate(f), TOLERANCE);
+	srand(1234);
+	for (int i = 0; i < 1000; i++) {
+		int f = rand() % numFrames;
+		DOUBLES_EQUAL(values[f], curve.Evaluate(f), TOLERANCE);
+	}
+}
+
+TEST_GROUP(AnimationCurveTest) {};
+
+TEST(AnimationCurveTest, constantTest) {
+	std::vector<float> values(120, 2.5f);
+	check_curve(values);
+
+	std::vector<uint8_t> data = Mask::AnimationCurve::Encode(values.data(),
+		values.size(), TOLERANCE);
+	Mask::AnimationCurve curve;
+	curve.Load(data.data(), data.size());
+	CHECK_EQUAL(1, curve.GetNumKeys());
+	DOUBLES_EQUAL(2.5f, curve.Evaluate(-10), TOLERANCE);
+	DOUBLES_EQUAL(2.5f, curve.Evaluate(500), TOLERANCE);
+}
+
+TEST(AnimationCurveTest, linearTest) {
+	std::vector<float> values(100);
+	for (size_t i = 0; i < values.size(); i++)
+		values[i] = (i < 50) ? (float)i * 0.1f : 5.0f - (float)(i - 50) * 0.2f;
+	check_curve(values);
+
+	std::vector<uint8_t> data = Mask::AnimationCurve::Encode(values.data(),
+		values.size(), TOLERANCE);
+	Mask::AnimationCurve curve;
+	curve.Load(data.data(), data.size());
+	CHECK_TRUE(curve.GetNumKeys() <= 4);
+}
+
+TEST(AnimationCurveTest, smoothTest) {
+	std::vector<float> values(600);
+	for (size_t i = 0; i < values.size(); i++)
+		values[i] = sinf((float)i * 0.05f) * 3.0f + (float)i * 0.01f;
+	check_curve(values);
+
+	std::vector<uint8_t> data = Mask::AnimationCurve::Encode(values.data(),
+		values.size(), TOLERANCE);
+	CHECK_TRUE(data.size() < values.size() * sizeof(float) / 4);
+}
+
+TEST(AnimationCurveTest, noiseTest) {
+	std::vector<float> values(300);
+	srand(42);
+	for (size_t i = 0; i < values.size(); i++)
+		values[i] = (float)(rand() % 1000) / 100.0f;
+	check_curve(values);
+}
+
+TEST(AnimationCurveTest, badCurveTest) {
+	std::vector<float> values(50);
+	for (size_t i = 0; i < values.size(); i++)
+		values[i] = (float)(i * i);
+	std::vector<uint8_t> data = Mask::AnimationCurve::Encode(values.data(),
+		values.size(), TOLERANCE);
+
+	Mask::AnimationCurve curve;
+	CHECK_FALSE(curve.Load(data.data(), 10));
+	CHECK_FALSE(curve.Load(data.data(), data.size() - 1));
+	std::vector<float> floats(values);
+	CHECK_FALSE(curve.Load((const uint8_t*)floats.data(),
+		floats.size() * sizeof(float)));
+	CHECK_EQUAL(0, curve.GetNumFrames());
+
+	// a key far past the end of the channel, which would overflow the frame
+	Mask::CurveHeader header = { { 'F', 'M', 'A', 'C' }, 10, 3, 0, 0.0f, 1.0f };
+	std::vector<uint8_t> bad(sizeof(header));
+	memcpy(bad.data(), &header, sizeof(header));
+	const uint8_t keys[] = {
+		0x00, 0x00,								// frame 0
+		0x0A, 0x00,								// frame 5
+		0xFE, 0xFF, 0xFF, 0xFF, 0x0F, 0x00,		// frame 5 + INT32_MAX
+	};
+	bad.insert(bad.end(), keys, keys + sizeof(keys));
+	CHECK_FALSE(curve.Load(bad.data(), bad.size()));
+	CHECK_EQUAL(0, curve.GetNumFrames());
+}
+
+TEST(AnimationCurveTest, longCurveTest) {
+	// one long segment, fitting each length in turn would take minutes
+	std::vector<float> values(100000);
+	for (size_t i = 0; i < values.size(); i++)
+		values[i] = (float)i * 0.001f;
+	check_curve(values);
+
+	std::vector<uint8_t> data = Mask::AnimationCurve::Encode(values.data(),
+		values.size(), TOLERANCE);
+	Mask::AnimationCurve curve;
+	curve.Load(data.data(), data.size());
+	CHECK_TRUE(curve.GetNumKeys() <= 4);
+}
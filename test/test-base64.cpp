@@ -21,7 +21,7 @@
 #include <CppUTest/TestHarness.h>
 #include "Plugin/base64.h"
 #include <cmath>
-#include <iostream>
+#include <cstring>
 using namespace std;
 TEST_GROUP(base64Test) {};
 
@@ -54,4 +54,144 @@ TEST(base64Test, base64DecodeTest) {
 	for (size_t i = 0; i < actaulResult.size(); i++) {
 		CHECK_EQUAL(actaulResult[i], expectedResult[i]);
 	}
-}
\ No newline at end of file
+}
+
+TEST(base64Test, base64DecodeBufferTest) {
+	std::string const encodedText = "RmFjZSBNYXNrcyBmb3IgU2xPQlM=";
+	std::string const expectedResult = "Face Masks for SlOBS";
+
+	// exact size up front
+	size_t size = base64_decoded_size(encodedText.data(), encodedText.size());
+	CHECK_EQUAL(expectedResult.size(), size);
+
+	// decode into our own buffer
+	std::vector<uint8_t> buffer(size + 4, 0xAA);
+	size_t written = base64_decode(encodedText.data(), encodedText.size(), buffer.data());
+	CHECK_EQUAL(expectedResult.size(), written);
+	CHECK_EQUAL(0, memcmp(expectedResult.data(), buffer.data(), written));
+
+	// and nothing past it
+	for (size_t i = written; i < buffer.size(); i++)
+		CHECK_EQUAL(0xAA, buffer[i]);
+}
+
+TEST(base64Test, base64DecodeStopsAtInvalidTest) {
+	// decoding stops at the first non-base64 char
+	std::string const encodedText = "RmFjZSBN!YXNrcyBmb3IgU2xPQlM=";
+	std::vector<uint8_t> actualResult;
+	base64_decode(encodedText, actualResult);
+	CHECK_EQUAL(6, actualResult.size());
+	CHECK_EQUAL(0, memcmp("Face M", actualResult.data(), actualResult.size()));
+}
+
+TEST(base64Test, base64EncodeDecodeAllLengthsTest) {
+	for (size_t len = 0; len < 64; len++) {
+		std::vector<uint8_t> input(len);
+		for (size_t i = 0; i < len; i++)
+			input[i] = (uint8_t)(i * 37 + len);
+		string encoded = base64_encode(input.data(), input.size());
+		CHECK_EQUAL(input.size(), base64_decoded_size(encoded.data(), encoded.size()));
+
+		std::vector<uint8_t> actualResult;
+		base64_decode(encoded, actualResult);
+		CHECK_EQUAL(input.size(), actualResult.size());
+		CHECK(input == actualResult);
+	}
+}
+
+TEST(base64Test, base64DecodeZBufferTest) {
+	// compressible, and big enough to take several chunks
+	std::vector<uint8_t> input(200000);
+	for (size_t i = 0; i < input.size(); i++)
+		input[i] = (uint8_t)((i / 7) % 251);
+	string encoded = base64_encodeZ(input.data(), input.size());
+
+	size_t size = base64_decodeZ_size(encoded.data(), encoded.size());
+	CHECK_EQUAL(input.size(), size);
+
+	std::vector<uint8_t> buffer(size);
+	size_t written = base64_decodeZ(encoded.data(), encoded.size(), buffer.data(), buffer.size());
+	CHECK_EQUAL(input.size(), written);
+	CHECK(input == buffer);
+
+	// plain base64 comes through as is
+	string plain = base64_encode(input.data(), 1000);
+	CHECK_EQUAL(1000, base64_decodeZ_size(plain.data(), plain.size()));
+	written = base64_decodeZ(plain.data(), plain.size(), buffer.data(), buffer.size());
+	CHECK_EQUAL(1000, written);
+	CHECK_EQUAL(0, memcmp(input.data(), buffer.data(), written));
+}
+
+TEST(base64Test, base64DecodeZTrailingNewlineTest) {
+	std::vector<uint8_t> input(5000);
+	for (size_t i = 0; i < input.size(); i++)
+		input[i] = (uint8_t)((i / 3) % 17);
+
+	// zlib data, as it comes out of a text file
+	string encoded = base64_encodeZ(input.data(), input.size()) + "\n";
+	std::vector<uint8_t> actualResult;
+	base64_decodeZ(encoded, actualResult);
+	CHECK(input == actualResult);
+
+	// plain base64, padded, with trailing whitespace
+	string plain = base64_encode(input.data(), 1000) + " \r\n";
+	CHECK_EQUAL(1000, base64_decodeZ_size(plain.data(), plain.size()));
+	actualResult.clear();
+	base64_decodeZ(plain, actualResult);
+	CHECK_EQUAL(1000, actualResult.size());
+	CHECK_EQUAL(0, memcmp(input.data(), actualResult.data(), actualResult.size()));
+}
+
+// Benchmarks
+// - mask files are mostly multi-megabyte base64 strings, so these
+//   decode data that size. They're slow, so only built with
+//   BUILD_UNIT_TEST_BENCHMARKS, and the runner's verbose output
+//   gives their timings.
+#if defined(FACEMASK_BENCHMARKS)
+static const size_t BENCHMARK_SIZE = 16 * 1024 * 1024;
+static const int BENCHMARK_RUNS = 4;
+
+static std::vector<uint8_t> benchmark_data() {
+	std::vector<uint8_t> data(BENCHMARK_SIZE);
+	uint32_t x = 12345;
+	for (size_t i = 0; i < data.size(); i++) {
+		x = x * 1103515245 + 12345;
+		data[i] = (uint8_t)(x >> 16);
+	}
+	return data;
+}
+
+TEST(base64Test, base64DecodeBenchmark) {
+	std::vector<uint8_t> input = benchmark_data();
+	string encoded = base64_encode(input.data(), input.size());
+
+	std::vector<uint8_t> actualResult;
+	for (int i = 0; i < BENCHMARK_RUNS; i++) {
+		actualResult.clear();
+		base64_decode(encoded, actualResult);
+	}
+	CHECK(input == actualResult);
+}
+
+TEST(base64Test, base64DecodeBufferBenchmark) {
+	std::vector<uint8_t> input = benchmark_data();
+	string encoded = base64_encode(input.data(), input.size());
+	std::vector<uint8_t> buffer(base64_decoded_size(encoded.data(), encoded.size()));
+
+	size_t written = 0;
+	for (int i = 0; i < BENCHMARK_RUNS; i++)
+		written = base64_decode(encoded.data(), encoded.size(), buffer.data());
+	CHECK_EQUAL(input.size(), written);
+	CHECK(input == buffer);
+}
+
+TEST(base64Test, base64DecodeZBenchmark) {
+	std::vector<uint8_t> input = benchmark_data();
+	string encoded = base64_encodeZ(input.data(), input.size());
+
+	std::vector<uint8_t> actualResult;
+	for (int i = 0; i < BENCHMARK_RUNS; i++)
+		base64_decodeZ(encoded, actualResult);
+	CHECK(input == actualResult);
+}
+#endif
@@ -0,0 +1,144 @@
+/*
+* Face Masks for SlOBS
+*
+* Copyright (C) 2017 General Workings Inc
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+*/
+#include <CppUTest/TestHarness.h>
+#include "mask/mask-resource.h"
+
+using Cache = Mask::Resource::Cache;
+
+// obs data needs no graphics context, so it stands in for textures here
+static const Cache::CacheableType TYPE = Cache::CacheableType::OBSData;
+
+// adds it as whoever loaded it would, null if the cache didn't take it
+static void* add(Cache& cache, const std::string& key, size_t bytes) {
+	obs_data_t* data = obs_data_create();
+	if (cache.add(TYPE, key, data, bytes))
+		return data;
+	obs_data_release(data);
+	return nullptr;
+}
+
+// loads and lets go again, which counts as a re-use
+static bool cached(Cache& cache, const std::string& key) {
+	void* resource = nullptr;
+	cache.load(TYPE, key, &resource);
+	if (!resource)
+		return false;
+	cache.try_destroy_resource(key, resource, TYPE);
+	return true;
+}
+
+TEST_GROUP(CacheTest) {};
+
+TEST(CacheTest, budgetTest) {
+	Cache cache;
+	cache.set_budget(250);
+
+	void* a = add(cache, "a", 100);
+	void* b = add(cache, "b", 100);
+	CHECK_TRUE(a != nullptr);
+	CHECK_TRUE(b != nullptr);
+	// nothing idle to make room with
+	CHECK_TRUE(add(cache, "c", 100) == nullptr);
+	CHECK_TRUE(add(cache, "big", 1000) == nullptr);
+
+	Cache::Stats stats = cache.get_stats();
+	CHECK_EQUAL(2, (int)stats.items);
+	CHECK_EQUAL(200, (int)stats.bytes);
+	CHECK_EQUAL(0, (int)stats.evictions);
+
+	// a goes idle, c takes its place
+	cache.try_destroy_resource("a", a, TYPE);
+	void* c = add(cache, "c", 100);
+	CHECK_TRUE(c != nullptr);
+	CHECK_FALSE(cached(cache, "a"));
+	stats = cache.get_stats();
+	CHECK_EQUAL(200, (int)stats.bytes);
+	CHECK_EQUAL(1, (int)stats.evictions);
+
+	// shrinking can't take what is in use, only once it goes idle
+	cache.set_budget(100);
+	CHECK_EQUAL(200, (int)cache.get_stats().bytes);
+	cache.try_destroy_resource("b", b, TYPE);
+	cache.try_destroy_resource("c", c, TYPE);
+	stats = cache.get_stats();
+	CHECK_EQUAL(100, (int)stats.bytes);
+	CHECK_EQUAL(1, (int)stats.items);
+	CHECK_EQUAL(2, (int)stats.evictions);
+	CHECK_TRUE(cached(cache, "c"));
+
+	cache.destroy();
+}
+
+TEST(CacheTest, lruOrderTest) {
+	Cache cache;
+	cache.set_budget(300);
+
+	void* a = add(cache, "a", 100);
+	void* b = add(cache, "b", 100);
+	void* c = add(cache, "c", 100);
+	cache.try_destroy_resource("a", a, TYPE);
+	cache.try_destroy_resource("b", b, TYPE);
+	cache.try_destroy_resource("c", c, TYPE);
+	// b gets used again, so it moves to the re-used list
+	CHECK_TRUE(cached(cache, "b"));
+
+	// oldest used-once first, then the re-used one
+	// - only misses are checked, a hit would re-use it
+	CHECK_TRUE(add(cache, "d", 100) != nullptr);
+	CHECK_FALSE(cached(cache, "a"));
+	CHECK_TRUE(add(cache, "e", 100) != nullptr);
+	CHECK_FALSE(cached(cache, "c"));
+	CHECK_TRUE(add(cache, "f", 100) != nullptr);
+	CHECK_FALSE(cached(cache, "b"));
+
+	Cache::Stats stats = cache.get_stats();
+	CHECK_EQUAL(3, (int)stats.evictions);
+	CHECK_EQUAL(3, (int)stats.items);
+	CHECK_EQUAL(300, (int)stats.bytes);
+
+	cache.destroy();
+}
+
+TEST(CacheTest, evictionCountTest) {
+	Cache cache;
+	cache.set_budget(100);
+
+	const char* keys[] = { "a", "b", "c", "d", "e" };
+	for (const char* key : keys) {
+		void* resource = add(cache, key, 100);
+		CHECK_TRUE(resource != nullptr);
+		cache.try_destroy_resource(key, resource, TYPE);
+	}
+
+	Cache::Stats stats = cache.get_stats();
+	CHECK_EQUAL(4, (int)stats.evictions);
+	CHECK_EQUAL(1, (int)stats.items);
+	CHECK_EQUAL(100, (int)stats.bytes);
+
+	// hits and misses are not evictions
+	CHECK_TRUE(cached(cache, "e"));
+	CHECK_FALSE(cached(cache, "a"));
+	stats = cache.get_stats();
+	CHECK_EQUAL(1, (int)stats.hits);
+	CHECK_EQUAL(1, (int)stats.misses);
+	CHECK_EQUAL(4, (int)stats.evictions);
+
+	cache.destroy();
+}
@@ -0,0 +1,171 @@
+/*
+* Face Masks for SlOBS
+*
+* Copyright (C) 2017 General Workings Inc
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+*/
+#include <CppUTest/TestHarness.h>
+#include "Plugin/utils.h"
+#include "mask/mask-package.h"
+#include <fstream>
+#include <cstring>
+
+namespace zlib {
+#include <zlib.h>
+}
+
+static size_t align_blob(size_t offset) {
+	return (offset + MASK_PACKAGE_BLOB_ALIGNMENT - 1) & ~(size_t)(MASK_PACKAGE_BLOB_ALIGNMENT - 1);
+}
+
+// writes a package with a raw blob and a zlib blob
+static std::string write_test_package(const std::string& json,
+	const std::vector<uint8_t>& raw, const std::vector<uint8_t>& compressed) {
+
+	Mask::PackageHeader header;
+	memcpy(header.magic, MASK_PACKAGE_MAGIC, sizeof(header.magic));
+	header.version = MASK_PACKAGE_VERSION;
+	header.numBlobs = 2;
+	header.reserved = 0;
+	header.jsonOffset = sizeof(header);
+	header.jsonSize = json.size() + 1;
+	header.blobTableOffset = align_blob(header.jsonOffset + header.jsonSize);
+
+	zlib::uLongf zsize = zlib::compressBound((zlib::uLong)compressed.size());
+	std::vector<uint8_t> zdata(zsize);
+	zlib::compress((zlib::Bytef*)zdata.data(), &zsize,
+		(const zlib::Bytef*)compressed.data(), (zlib::uLong)compressed.size());
+	zdata.resize(zsize);
+
+	Mask::PackageBlobEntry blobs[2];
+	memset(blobs, 0, sizeof(blobs));
+	blobs[0].offset = align_blob(header.blobTableOffset + sizeof(blobs));
+	blobs[0].size = raw.size();
+	blobs[0].rawSize = raw.size();
+	blobs[0].compression = Mask::PACKAGE_COMPRESSION_NONE;
+	blobs[1].offset = align_blob(blobs[0].offset + blobs[0].size);
+	blobs[1].size = zdata.size();
+	blobs[1].rawSize = compressed.size();
+	blobs[1].compression = Mask::PACKAGE_COMPRESSION_ZLIB;
+
+	std::vector<uint8_t> file((size_t)(blobs[1].offset + blobs[1].size), 0);
+	memcpy(file.data(), &header, sizeof(header));
+	memcpy(file.data() + header.jsonOffset, json.c_str(), json.size() + 1);
+	memcpy(file.data() + header.blobTableOffset, blobs, sizeof(blobs));
+	memcpy(file.data() + blobs[0].offset, raw.data(), raw.size());
+	memcpy(file.data() + blobs[1].offset, zdata.data(), zdata.size());
+
+	std::string fn = Utils::GetTempFileName();
+	std::fstream f(fn, std::ios::out | std::ios::binary);
+	f.write((const char*)file.data(), file.size());
+	f.close();
+	return fn;
+}
+
+TEST_GROUP(PackageTest) {};
+
+TEST(PackageTest, blobRefTest) {
+	CHECK_TRUE(Mask::Package::IsBlobRef("@blob:0"));
+	CHECK_TRUE(Mask::Package::IsBlobRef("@blob:12"));
+	CHECK_FALSE(Mask::Package::IsBlobRef("eJztwTEBAAAAwqD1T20ND6AAAAAAAAAAAAA="));
+	CHECK_FALSE(Mask::Package::IsBlobRef(""));
+}
+
+TEST(PackageTest, loadPackageTest) {
+	const std::string json = "{ \"name\": \"test\", \"data\": \"@blob:1\" }";
+	std::vector<uint8_t> raw(100);
+	std::vector<uint8_t> compressed(1000);
+	for (size_t i = 0; i < raw.size(); i++)
+		raw[i] = (uint8_t)i;
+	for (size_t i = 0; i < compressed.size(); i++)
+		compressed[i] = (uint8_t)(i / 10);
+	std::string fn = write_test_package(json, raw, compressed);
+
+	CHECK_TRUE(Mask::Package::IsPackage(fn));
+	{
+		std::shared_ptr<Mask::Package> package = std::make_shared<Mask::Package>(fn);
+		STRCMP_EQUAL(json.c_str(), package->GetJSON());
+		CHECK_EQUAL(2, package->GetNumBlobs());
+
+		// uncompressed blobs come straight out of the mapping, aligned
+		Mask::Blob blob;
+		package->GetBlob("@blob:0", blob);
+		CHECK_EQUAL(raw.size(), blob.size());
+		CHECK_EQUAL(0, (size_t)blob.data() % MASK_PACKAGE_BLOB_ALIGNMENT);
+		CHECK_EQUAL(0, memcmp(raw.data(), blob.data(), raw.size()));
+
+		Mask::Blob zblob;
+		package->GetBlob("@blob:1", zblob);
+		CHECK_EQUAL(compressed.size(), zblob.size());
+		CHECK_EQUAL(0, memcmp(compressed.data(), zblob.data(), compressed.size()));
+
+		CHECK_THROWS(std::out_of_range, package->GetBlob("@blob:2", blob));
+		CHECK_THROWS(std::invalid_argument, package->GetBlob("@blob:x", blob));
+	}
+	Utils::DeleteTempFile(fn);
+}
+
+TEST(PackageTest, notAPackageTest) {
+	std::string fn = Utils::GetTempFileName();
+	std::fstream f(fn, std::ios::out | std::ios::binary);
+	f << "{ \"name\": \"test\", \"description\": \"not a package\" }";
+	f.close();
+
+	CHECK_FALSE(Mask::Package::IsPackage(fn));
+	CHECK_THROWS(std::invalid_argument, Mask::Package package(fn));
+	Utils::DeleteTempFile(fn);
+}
+
+// rewrites one blob table entry of a package file
+static void patch_blob_entry(const std::string& fn, size_t index,
+	const Mask::PackageBlobEntry& entry) {
+	std::fstream f(fn, std::ios::in | std::ios::out | std::ios::binary);
+	Mask::PackageHeader header;
+	f.read((char*)&header, sizeof(header));
+	f.seekp(header.blobTableOffset + index * sizeof(entry));
+	f.write((const char*)&entry, sizeof(entry));
+	f.close();
+}
+
+TEST(PackageTest, badBlobSizeTest) {
+	const std::string json = "{ \"name\": \"test\" }";
+	std::vector<uint8_t> raw(100, 1);
+	std::vector<uint8_t> compressed(1000, 2);
+
+	// offset + size wraps around
+	std::string fn = write_test_package(json, raw, compressed);
+	Mask::PackageBlobEntry entry;
+	memset(&entry, 0, sizeof(entry));
+	entry.offset = UINT64_MAX - 8;
+	entry.size = 100;
+	entry.rawSize = 100;
+	patch_blob_entry(fn, 0, entry);
+	CHECK_THROWS(std::invalid_argument, Mask::Package package(fn));
+	Utils::DeleteTempFile(fn);
+
+	// raw size far bigger than the data could inflate to
+	fn = write_test_package(json, raw, compressed);
+	std::fstream f(fn, std::ios::in | std::ios::binary);
+	Mask::PackageHeader header;
+	f.read((char*)&header, sizeof(header));
+	f.seekg(header.blobTableOffset + sizeof(entry));
+	f.read((char*)&entry, sizeof(entry));
+	f.close();
+	entry.rawSize = 1ULL << 40;
+	patch_blob_entry(fn, 1, entry);
+	CHECK_THROWS(std::invalid_argument, Mask::Package package(fn));
+	Utils::DeleteTempFile(fn);
+}
@@ -174,4 +174,32 @@ TEST(UtilsTest, convertWstringToStringTest) {
 		const std::string actual = Utils::ConvertWstringToString(testTexts[i]);
 		STRCMP_EQUAL(expectedResult[i].c_str(), actual.c_str());
 	}
-}
\ No newline at end of file
+}
+
+TEST(UtilsTest, hashDataTest) {
+	std::vector<uint8_t> data(100);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = (uint8_t)(i * 7);
+
+	// same data, same hash, for every tail length
+	for (size_t size = 0; size < 17; size++) {
+		CHECK_EQUAL(Utils::HashData(data.data(), size), Utils::HashData(data.data(), size));
+		if (size > 0)
+			CHECK(Utils::HashData(data.data(), size) != Utils::HashData(data.data(), size - 1));
+	}
+
+	// any change, different hash
+	uint64_t hash = Utils::HashData(data.data(), data.size());
+	for (size_t i = 0; i < data.size(); i += 13) {
+		std::vector<uint8_t> changed(data);
+		changed[i] ^= 1;
+		CHECK(hash != Utils::HashData(changed.data(), changed.size()));
+	}
+
+	// seed chains
+	CHECK(hash != Utils::HashData(data.data(), data.size(), 1));
+
+	std::string s = Utils::HashToString(0x0123456789abcdefULL);
+	STRCMP_EQUAL("0123456789abcdef", s.c_str());
+	CHECK_EQUAL(16, Utils::HashToString(1).length());
+}
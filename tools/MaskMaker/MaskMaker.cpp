@@ -26,6 +26,7 @@
 #include "command_merge.h"
 #include "command_tweak.h"
 #include "command_depends.h"
+#include "command_pack.h"
 
 
 using namespace std;
@@ -58,6 +59,8 @@ int main(int argc, char** argv) {
 		command_tweak(args);
 	else if (args.command == "depends")
 		command_depends(args);
+	else if (args.command == "pack")
+		command_pack(args);
 	else if (args.command == "printtexture")
 		std::cout << args.createImageResourceFromFile(args.value("file"), true).dump(4) << std::endl;
 	else if (args.command == "buildtexture")
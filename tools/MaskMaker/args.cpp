@@ -98,6 +98,11 @@ void Args::usage() {
 	cout << "  import  -  imports an FBX file and creates a json" << endl;
 	cout << "  morphimport,mi  -  imports morph FBX files and creates a json" << endl;
 	cout << "  tweak   -  tweak (set) values in the json." << endl;
+	cout << "  pack    -  converts a json to a binary mask package" << endl;
+	cout << endl;
+	cout << "  import and morphimport store animations as raw frames unless given" << endl;
+	cout << "  curve-tolerance=<value>, then they are fitted to curves within it." << endl;
+	cout << "  Curves make much smaller masks, but older plugins can't load them." << endl;
 	cout << endl;
 	cout << "example:" << endl;
 	cout << endl;
@@ -107,6 +112,8 @@ void Args::usage() {
 	cout << "  maskmaker.exe addres file=phong.effect helmet.json" << endl;
 	cout << "  maskmaker.exe addres type=material helmet.json" << endl;
 	cout << "  maskmaker.exe addpart name=helmet helmet.json" << endl;
+	cout << "  maskmaker.exe import file=helmet.fbx curve-tolerance=0.0001 helmet.json" << endl;
+	cout << "  maskmaker.exe pack file=helmet.json compress=true helmet.fmpk" << endl;
 	cout << endl;
 }
 
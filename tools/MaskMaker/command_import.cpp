@@ -20,8 +20,11 @@
 #include "utils.h"
 #include "command_import.h"
 #include "command_morph_import.h"
+#include "mask-animation-curve.h"
 
-#define MAX_BONES_PER_SKIN		(8)
+// keep in sync with the plugin, and the bones array in the effects
+#define MAX_BONES_PER_SKIN		(32)
+#define MAX_WEIGHTS_PER_VERTEX	(8)
 
 #define INHERIT_TYPE_RrSs 0
 #define INHERIT_TYPE_RSrs 1
@@ -612,7 +615,7 @@ void command_import(Args& args) {
 				if (verts[j].bones.size() == 0) {
 					cout << "WARNING! SKINNED MESH HAS ENTIRELY UNWEIGHTED VERTEX!" << endl;
 				}
-				if (verts[j].bones.size() > MAX_BONES_PER_SKIN) {
+				if (verts[j].bones.size() > MAX_WEIGHTS_PER_VERTEX) {
 					cout << "WARNING! SKINNED MESH VERTEX " << j << " HAS TOO MANY WEIGHTS! " << verts[j].bones.size() << endl;
 					for (unsigned int k = 0; k < verts[j].bones.size(); k++) {
 						cout << " vert bone index: " << verts[j].bones[k].bone << " : " << verts[j].bones[k].weight << endl;
@@ -1261,9 +1264,30 @@ int GetDeltaIndex(string nodeName) {
 	return -1;
 }
 
+// SetChannelValues
+// - fits the frames to a curve when we have a tolerance, otherwise
+//   stores every frame
+// - curves are opt-in: plugins from before the curve format can't
+//   load them
+static void SetChannelValues(json& jchan, const std::vector<float>& keys,
+	float tolerance) {
+	if (tolerance > 0.0f) {
+		std::vector<uint8_t> curve = Mask::AnimationCurve::Encode(keys.data(),
+			keys.size(), tolerance);
+		jchan["encoding"] = MASK_CURVE_ENCODING;
+		jchan["values"] = base64_encodeZ(curve.data(), (unsigned int)curve.size());
+	}
+	else {
+		jchan["values"] = base64_encodeZ((uint8_t*)keys.data(),
+			(unsigned int)(sizeof(float) * keys.size()));
+	}
+}
+
 void ImportAnimations(Args& args, const aiScene* scene, json& rez, 
 	bool forMorph, aiVector3D* rest_points) {
 
+	float tolerance = args.floatValue("curve-tolerance");
+
 	for (unsigned int i = 0; i < scene->mNumAnimations; i++) {
 		aiAnimation* anim = scene->mAnimations[i];
 
@@ -1413,8 +1437,7 @@ void ImportAnimations(Args& args, const aiScene* scene, json& rez,
 					}
 					jchan["pre-state"] = AnimBehaviourToString(chan->mPreState);
 					jchan["post-state"] = AnimBehaviourToString(chan->mPostState);
-					jchan["values"] = base64_encodeZ((uint8_t*)xkeys.data(),
-						(unsigned int)(sizeof(float) * xkeys.size()));
+					SetChannelValues(jchan, xkeys, tolerance);
 					snprintf(temp, sizeof(temp), "%d", jchanCount++);
 					jchannels[temp] = jchan;
 				}
@@ -1430,8 +1453,7 @@ void ImportAnimations(Args& args, const aiScene* scene, json& rez,
 					}
 					jchan["pre-state"] = AnimBehaviourToString(chan->mPreState);
 					jchan["post-state"] = AnimBehaviourToString(chan->mPostState);
-					jchan["values"] = base64_encodeZ((uint8_t*)ykeys.data(),
-						(unsigned int)(sizeof(float) * ykeys.size()));
+					SetChannelValues(jchan, ykeys, tolerance);
 					snprintf(temp, sizeof(temp), "%d", jchanCount++);
 					jchannels[temp] = jchan;
 				}
@@ -1447,8 +1469,7 @@ void ImportAnimations(Args& args, const aiScene* scene, json& rez,
 					}
 					jchan["pre-state"] = AnimBehaviourToString(chan->mPreState);
 					jchan["post-state"] = AnimBehaviourToString(chan->mPostState);
-					jchan["values"] = base64_encodeZ((uint8_t*)zkeys.data(),
-						(unsigned int)(sizeof(float) * zkeys.size()));
+					SetChannelValues(jchan, zkeys, tolerance);
 					snprintf(temp, sizeof(temp), "%d", jchanCount++);
 					jchannels[temp] = jchan;
 				}
@@ -1535,8 +1556,7 @@ void ImportAnimations(Args& args, const aiScene* scene, json& rez,
 					jchan["type"] = "part-qrot-x";
 					jchan["pre-state"] = AnimBehaviourToString(chan->mPreState);
 					jchan["post-state"] = AnimBehaviourToString(chan->mPostState);
-					jchan["values"] = base64_encodeZ((uint8_t*)xkeys.data(),
-						(unsigned int)(sizeof(float) * xkeys.size()));
+					SetChannelValues(jchan, xkeys, tolerance);
 					snprintf(temp, sizeof(temp), "%d", jchanCount++);
 					jchannels[temp] = jchan;
 				}
@@ -1546,8 +1566,7 @@ void ImportAnimations(Args& args, const aiScene* scene, json& rez,
 					jchan["type"] = "part-qrot-y";
 					jchan["pre-state"] = AnimBehaviourToString(chan->mPreState);
 					jchan["post-state"] = AnimBehaviourToString(chan->mPostState);
-					jchan["values"] = base64_encodeZ((uint8_t*)ykeys.data(),
-						(unsigned int)(sizeof(float) * ykeys.size()));
+					SetChannelValues(jchan, ykeys, tolerance);
 					snprintf(temp, sizeof(temp), "%d", jchanCount++);
 					jchannels[temp] = jchan;
 				}
@@ -1557,8 +1576,7 @@ void ImportAnimations(Args& args, const aiScene* scene, json& rez,
 					jchan["type"] = "part-qrot-z";
 					jchan["pre-state"] = AnimBehaviourToString(chan->mPreState);
 					jchan["post-state"] = AnimBehaviourToString(chan->mPostState);
-					jchan["values"] = base64_encodeZ((uint8_t*)zkeys.data(),
-						(unsigned int)(sizeof(float) * zkeys.size()));
+					SetChannelValues(jchan, zkeys, tolerance);
 					snprintf(temp, sizeof(temp), "%d", jchanCount++);
 					jchannels[temp] = jchan;
 				}
@@ -1568,8 +1586,7 @@ void ImportAnimations(Args& args, const aiScene* scene, json& rez,
 					jchan["type"] = "part-qrot-w";
 					jchan["pre-state"] = AnimBehaviourToString(chan->mPreState);
 					jchan["post-state"] = AnimBehaviourToString(chan->mPostState);
-					jchan["values"] = base64_encodeZ((uint8_t*)wkeys.data(),
-						(unsigned int)(sizeof(float) * wkeys.size()));
+					SetChannelValues(jchan, wkeys, tolerance);
 					snprintf(temp, sizeof(temp), "%d", jchanCount++);
 					jchannels[temp] = jchan;
 				}
@@ -1646,8 +1663,7 @@ void ImportAnimations(Args& args, const aiScene* scene, json& rez,
 					jchan["type"] = "part-scl-x";
 					jchan["pre-state"] = AnimBehaviourToString(chan->mPreState);
 					jchan["post-state"] = AnimBehaviourToString(chan->mPostState);
-					jchan["values"] = base64_encodeZ((uint8_t*)xkeys.data(),
-						(unsigned int)(sizeof(float) * xkeys.size()));
+					SetChannelValues(jchan, xkeys, tolerance);
 					snprintf(temp, sizeof(temp), "%d", jchanCount++);
 					jchannels[temp] = jchan;
 				}
@@ -1657,8 +1673,7 @@ void ImportAnimations(Args& args, const aiScene* scene, json& rez,
 					jchan["type"] = "part-scl-y";
 					jchan["pre-state"] = AnimBehaviourToString(chan->mPreState);
 					jchan["post-state"] = AnimBehaviourToString(chan->mPostState);
-					jchan["values"] = base64_encodeZ((uint8_t*)ykeys.data(),
-						(unsigned int)(sizeof(float) * ykeys.size()));
+					SetChannelValues(jchan, ykeys, tolerance);
 					snprintf(temp, sizeof(temp), "%d", jchanCount++);
 					jchannels[temp] = jchan;
 				}
@@ -1668,8 +1683,7 @@ void ImportAnimations(Args& args, const aiScene* scene, json& rez,
 					jchan["type"] = "part-scl-z";
 					jchan["pre-state"] = AnimBehaviourToString(chan->mPreState);
 					jchan["post-state"] = AnimBehaviourToString(chan->mPostState);
-					jchan["values"] = base64_encodeZ((uint8_t*)zkeys.data(),
-						(unsigned int)(sizeof(float) * zkeys.size()));
+					SetChannelValues(jchan, zkeys, tolerance);
 					snprintf(temp, sizeof(temp), "%d", jchanCount++);
 					jchannels[temp] = jchan;
 				}
@@ -0,0 +1,172 @@
+/*
+*
+* Copyright (C) 2017 General Workings Inc
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 2 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+*/
+#include "stdafx.h"
+#include "utils.h"
+#include "command_pack.h"
+#include "mask-package.h"
+
+
+static bool is_blob_key(const string& resType, const string& key) {
+	if (resType == "image")
+		return key == "data" || key.find("mip-data-") != string::npos;
+	if (resType == "mesh")
+		return key == "data" || key == "vertex-buffer" || key == "index-buffer";
+	if (resType == "effect")
+		return key == "data";
+	return false;
+}
+
+class PackageBuilder {
+public:
+	PackageBuilder(bool compress) : compress(compress) {}
+
+	bool compress;
+	vector<Mask::PackageBlobEntry> entries;
+	vector<vector<uint8_t>> blobs;
+	size_t rawTotal = 0;
+
+	// replaces the base64 data with a blob reference
+	void add(json& value) {
+		if (!value.is_string())
+			return;
+		string base64data = value.get<string>();
+		if (base64data.empty() ||
+			base64data.compare(0, strlen(MASK_PACKAGE_BLOB_PREFIX), MASK_PACKAGE_BLOB_PREFIX) == 0)
+			return;
+
+		Mask::PackageBlobEntry entry;
+		memset(&entry, 0, sizeof(entry));
+		vector<uint8_t> data;
+		base64_decodeZ(base64data, data);
+		entry.rawSize = data.size();
+		entry.compression = Mask::PACKAGE_COMPRESSION_NONE;
+		rawTotal += data.size();
+
+		// compress, but only keep it if it's worth it
+		if (compress && data.size() > 0) {
+			uLongf zsize = compressBound((uLong)data.size());
+			vector<uint8_t> zdata(zsize);
+			if (compress2(zdata.data(), &zsize, data.data(), (uLong)data.size(),
+				Z_BEST_COMPRESSION) == Z_OK && zsize < data.size() * 9 / 10) {
+				zdata.resize(zsize);
+				data.swap(zdata);
+				entry.compression = Mask::PACKAGE_COMPRESSION_ZLIB;
+			}
+		}
+		entry.size = data.size();
+
+		value = MASK_PACKAGE_BLOB_PREFIX + to_string(blobs.size());
+		entries.push_back(entry);
+		blobs.emplace_back(std::move(data));
+	}
+};
+
+static uint64_t align_to(uint64_t offset, uint64_t alignment) {
+	return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+static void write_padding(fstream& f, uint64_t& offset, uint64_t alignment) {
+	static const char zeros[MASK_PACKAGE_BLOB_ALIGNMENT] = { 0 };
+	uint64_t aligned = align_to(offset, alignment);
+	f.write(zeros, aligned - offset);
+	offset = aligned;
+}
+
+void command_pack(Args& args) {
+
+	// load json file
+	string infile = args.value("file");
+	json j = args.loadJsonFile(infile);
+	if (j.is_null())
+		return;
+
+	// pull all the base64 data out into blobs
+	PackageBuilder builder(args.boolValue("compress"));
+	if (j.find("resources") != j.end()) {
+		for (auto it = j["resources"].begin(); it != j["resources"].end(); it++) {
+			json& res = it.value();
+			if (!res.is_object() || res.find("type") == res.end())
+				continue;
+			string resType = res["type"].get<string>();
+			if (resType == "animation") {
+				if (res.find("channels") == res.end())
+					continue;
+				for (auto ch = res["channels"].begin(); ch != res["channels"].end(); ch++) {
+					json& channel = ch.value();
+					if (channel.is_object() && channel.find("values") != channel.end())
+						builder.add(channel["values"]);
+				}
+			}
+			else {
+				for (auto kv = res.begin(); kv != res.end(); kv++) {
+					if (is_blob_key(resType, kv.key()))
+						builder.add(kv.value());
+				}
+			}
+		}
+	}
+
+	// lay out the file
+	string jsonText = j.dump();
+	Mask::PackageHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MASK_PACKAGE_MAGIC, sizeof(header.magic));
+	header.version = MASK_PACKAGE_VERSION;
+	header.numBlobs = (uint32_t)builder.blobs.size();
+	header.jsonOffset = sizeof(header);
+	header.jsonSize = jsonText.size() + 1;
+	header.blobTableOffset = align_to(header.jsonOffset + header.jsonSize,
+		sizeof(uint64_t));
+	uint64_t offset = header.blobTableOffset +
+		sizeof(Mask::PackageBlobEntry) * builder.entries.size();
+	for (size_t i = 0; i < builder.entries.size(); i++) {
+		offset = align_to(offset, MASK_PACKAGE_BLOB_ALIGNMENT);
+		builder.entries[i].offset = offset;
+		offset += builder.entries[i].size;
+	}
+
+	// write it out
+	fstream f(args.filename.c_str(), ios::out | ios::binary);
+	if (!f.good()) {
+		cout << "Cannot write package file '" << args.filename << "'." << endl;
+		return;
+	}
+	offset = 0;
+	f.write((const char*)&header, sizeof(header));
+	offset += sizeof(header);
+	f.write(jsonText.c_str(), jsonText.size() + 1);
+	offset += jsonText.size() + 1;
+	write_padding(f, offset, sizeof(uint64_t));
+	if (!builder.entries.empty()) {
+		f.write((const char*)builder.entries.data(),
+			sizeof(Mask::PackageBlobEntry) * builder.entries.size());
+		offset += sizeof(Mask::PackageBlobEntry) * builder.entries.size();
+	}
+	for (size_t i = 0; i < builder.blobs.size(); i++) {
+		write_padding(f, offset, MASK_PACKAGE_BLOB_ALIGNMENT);
+		f.write((const char*)builder.blobs[i].data(), builder.blobs[i].size());
+		offset += builder.blobs[i].size();
+	}
+	f.close();
+
+	cout << infile << " -> " << args.filename << ": " << builder.blobs.size()
+		<< " blobs, " << builder.rawTotal << " bytes of data, "
+		<< offset << " bytes total." << endl;
+}
+